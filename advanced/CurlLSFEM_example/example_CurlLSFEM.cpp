@@ -87,6 +87,17 @@
        \li Ninja.xml - input file with distorted mesh (shaped like Ninja star) and one mesh block
        \li CurlLSFEMblock_in_block.xml - input file with box mesh with a center block with different material values.
 
+      Optional input file parameters:
+
+       \li "assembly mode" - "FECrs" (default) sums element contributions into Epetra_FECrsMatrix
+                             and ships off-processor rows in GlobalAssemble; "Owner Computes"
+                             also computes a one-layer halo of off-processor elements and inserts
+                             only locally owned rows, so assembly needs no communication.
+       \li "scatter plan reassemblies" - number of times to re-assemble the matrices from saved
+                             element matrices with a precomputed scatter plan (default 0).
+                             Requires "Owner Computes"; mimics the re-assembly done in Newton
+                             and time-stepping loops once the matrix graph is fixed.
+
  **/
 
 /**************************************************************/
@@ -139,6 +150,9 @@
 // AztecOO includes
 #include "AztecOO.h"
 
+// Ifpack (64-bit global id solve)
+#include "Ifpack.h"
+
 // ML Includes
 #include "ml_MultiLevelPreconditioner.h"
 #include "ml_RefMaxwell_11_Operator.h"
@@ -152,6 +166,19 @@
 #include "pamgen_im_ne_nemesisI_l.h"
 #include "pamgen_extras.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// LSFEM example utilities
+#include "../LSFEM_common/LSFEM_GlobalOrdinal.hpp"
+#include "../LSFEM_common/LSFEM_ElementList.hpp"
+#include "../LSFEM_common/LSFEM_ScatterPlan.hpp"
+#include "../LSFEM_common/LSFEM_Incidence.hpp"
+#include "../LSFEM_common/LSFEM_OffProcEntries.hpp"
+#include "../LSFEM_common/LSFEM_AssembledOperator.hpp"
+#include "Epetra_IntervalMap.hpp"
+
 
 #define ABS(x) ((x)>0?(x):-(x))
 
@@ -211,6 +238,30 @@ void TestMultiLevelPreconditioner_CurlLSFEM(char ProblemType[],
                                            double & TotalErrorResidual,
                                            double & TotalErrorExactSol);
 
+/** \brief  AztecOO CG with an Ifpack symmetric Gauss-Seidel preconditioner on the
+            assembled (1,1) operator; used instead of ML with 64-bit global ids
+
+    \param  ProblemType        [in]    problem type
+    \param  CurlCurl           [in]    H(curl) stiffness matrix
+    \param  D0clean            [in]    Edge to node incidence matrix
+    \param  M0inv              [in]    H(grad) mass matrix inverse
+    \param  M1                 [in]    H(curl) mass matrix
+    \param  xh                 [out]   solution vector
+    \param  b                  [in]    right-hand-side vector
+    \param  TotalErrorResidual [out]   error residual
+    \param  TotalErrorExactSol [out]   error in xh
+
+ */
+void TestIfpackPreconditioner_CurlLSFEM(char ProblemType[],
+                                        Epetra_CrsMatrix   & CurlCurl,
+                                        Epetra_CrsMatrix   & D0clean,
+                                        Epetra_CrsMatrix   & M0inv,
+                                        Epetra_CrsMatrix   & M1,
+                                        Epetra_MultiVector & xh,
+                                        Epetra_MultiVector & b,
+                                        double & TotalErrorResidual,
+                                        double & TotalErrorExactSol);
+
 
 /**********************************************************************************/
 /******** FUNCTION DECLARATIONS FOR EXACT SOLUTION AND SOURCE TERMS ***************/
@@ -382,6 +433,14 @@ int main(int argc, char *argv[]) {
   // Get pamgen mesh definition
     std::string meshInput = Teuchos::getParameter<std::string>(inputList,"meshInput");
 
+  // Get assembly mode ("FECrs" or "Owner Computes")
+    std::string assemblyMode = inputList.get("assembly mode",std::string("FECrs"));
+    bool ownerComputes = (assemblyMode == "Owner Computes");
+
+  // Get number of re-assemblies with the scatter plan (needs all owned rows computed locally)
+    int numReassemblies = inputList.get("scatter plan reassemblies",0);
+    if (!ownerComputes) numReassemblies = 0;
+
 
 /**********************************************************************************/
 /***************************** GET CELL TOPOLOGY **********************************/
@@ -600,11 +659,11 @@ int main(int argc, char *argv[]) {
       if(nodeIsOwned[i]) ownedNodes++;
 
    // Build a list of the OWNED global ids...
-    int *ownedGIDs=new int [ownedNodes];
+    LSFEM_GO *ownedGIDs=new LSFEM_GO [ownedNodes];
     int oidx=0;
     for(int i=0;i<numNodes;i++)
       if(nodeIsOwned[i]){
-        ownedGIDs[oidx]=(int)globalNodeIds[i];
+        ownedGIDs[oidx]=(LSFEM_GO)globalNodeIds[i];
         oidx++;
       }
 
@@ -737,11 +796,11 @@ int main(int argc, char *argv[]) {
            numOwnedEdges++;
         }
      }
-    int * ownedEdgeIds = new int[numOwnedEdges];
+    LSFEM_GO * ownedEdgeIds = new LSFEM_GO[numOwnedEdges];
     int nedge=0;
     for (int i=0; i<numEdges; i++) {
         if (edgeIsOwned[i]){
-           ownedEdgeIds[nedge]=(int)globalEdgeIds[i];
+           ownedEdgeIds[nedge]=(LSFEM_GO)globalEdgeIds[i];
            nedge++;
         }
      }
@@ -757,21 +816,23 @@ int main(int argc, char *argv[]) {
            numOwnedFaces++;
         }
      }
-    int * ownedFaceIds = new int[numOwnedFaces];
+    LSFEM_GO * ownedFaceIds = new LSFEM_GO[numOwnedFaces];
     int nface=0;
     for (int i=0; i<numFaces; i++) {
         if (faceIsOwned[i]){
-           ownedFaceIds[nface]=(int)globalFaceIds[i];
+           ownedFaceIds[nface]=(LSFEM_GO)globalFaceIds[i];
            nface++;
         }
      }
 
   // Calculate number of global edges and faces
-    int numEdgesGlobal;
-    int numFacesGlobal;
+    long long numEdgesGlobal;
+    long long numFacesGlobal;
 #ifdef HAVE_MPI
-    Comm.SumAll(&numOwnedEdges,&numEdgesGlobal,1);
-    Comm.SumAll(&numOwnedFaces,&numFacesGlobal,1);
+    long long numOwnedEdgesLL = numOwnedEdges;
+    long long numOwnedFacesLL = numOwnedFaces;
+    Comm.SumAll(&numOwnedEdgesLL,&numEdgesGlobal,1);
+    Comm.SumAll(&numOwnedFacesLL,&numFacesGlobal,1);
 #else
     numEdgesGlobal = numEdges;
     numFacesGlobal = numFaces;
@@ -953,17 +1014,46 @@ int main(int argc, char *argv[]) {
 /**********************************************************************************/
 
    // Define global epetra maps
-    Epetra_Map globalMapG(-1,ownedNodes,ownedGIDs,0,Comm);
-    Epetra_Map globalMapC(-1,numOwnedEdges,ownedEdgeIds,0,Comm);
+    Epetra_Map globalMapG((LSFEM_GO)-1,ownedNodes,ownedGIDs,(LSFEM_GO)0,Comm);
+    Epetra_Map globalMapC((LSFEM_GO)-1,numOwnedEdges,ownedEdgeIds,(LSFEM_GO)0,Comm);
 
-    Epetra_FECrsMatrix StiffMatrixC(Copy, globalMapC, numFieldsC);
-    Epetra_FECrsMatrix MassMatrixC (Copy, globalMapC, numFieldsC);
-    Epetra_FECrsMatrix MassMatrixG (Copy, globalMapG, numFieldsG);
-    Epetra_FEVector    rhsVector   (globalMapC);
+   // In owner computes mode only owned rows are inserted, so nothing is kept for GlobalAssemble
+    Epetra_FECrsMatrix StiffMatrixC(Copy, globalMapC, numFieldsC, ownerComputes);
+    Epetra_FECrsMatrix MassMatrixC (Copy, globalMapC, numFieldsC, ownerComputes);
+    Epetra_FECrsMatrix MassMatrixG (Copy, globalMapG, numFieldsG, ownerComputes);
+    Epetra_FEVector    rhsVector   (globalMapC, 1, ownerComputes);
 
   if(MyPID==0) {std::cout << "Build global maps                           "
                  << Time.ElapsedTime() << " sec \n";  Time.ResetStartTime();}
 
+   // Memory held by the global id lists of the maps (grows with the global id width)
+   {
+      double gidBytes = (double)(ownedNodes + numOwnedEdges)*sizeof(LSFEM_GO), gidBytesTot = 0.0;
+      Comm.SumAll(&gidBytes,&gidBytesTot,1);
+      if (MyPID == 0) {
+        std::cout << "\tGlobal id width:         " << 8*sizeof(LSFEM_GO) << " bits\n";
+        std::cout << "\tMap global id storage:   " << gidBytesTot << " bytes\n\n";
+      }
+   }
+
+   // Compressed form of the same id lists: contiguous runs only (no owners are looked
+   // up here, so the replicated range directory is not built)
+   {
+      Epetra_Time intervalTime(Comm);
+      Epetra_IntervalMap<LSFEM_GO> intervalMapG(ownedNodes,ownedGIDs,Comm);
+      Epetra_IntervalMap<LSFEM_GO> intervalMapC(numOwnedEdges,ownedEdgeIds,Comm);
+      double intervalSec = intervalTime.ElapsedTime(), intervalSecMax = 0.0;
+      double intervalBytes = intervalMapG.BytesUsed() + intervalMapC.BytesUsed(), intervalBytesTot = 0.0;
+      Comm.MaxAll(&intervalSec,&intervalSecMax,1);
+      Comm.SumAll(&intervalBytes,&intervalBytesTot,1);
+      if (MyPID == 0) {
+        std::cout << "\tInterval maps (runs G/C): " << intervalMapG.NumGlobalRuns() << " / "
+                  << intervalMapC.NumGlobalRuns() << "\n";
+        std::cout << "\tInterval map storage:    " << intervalBytesTot << " bytes, built in "
+                  << intervalSecMax << " sec\n\n";
+      }
+   }
+
 
 /**********************************************************************************/
 /************************** OUTPUT CONNECTIVITY (FOR PLOTTING) ********************/
@@ -997,7 +1087,7 @@ int main(int argc, char *argv[]) {
      EpetraExt::MultiVectorToMatrixMarketFile("coords.dat",nCoord,0,0,false);
 
     // Put element to node mapping in multivector for output
-     Epetra_Map   globalMapElem(numElemsGlobal, numElems, 0, Comm);
+     Epetra_Map   globalMapElem((LSFEM_GO)numElemsGlobal, numElems, (LSFEM_GO)0, Comm);
      Epetra_MultiVector elem2node(globalMapElem, numNodesPerElem);
      for (int ielem=0; ielem<numElems; ielem++) {
         for (int inode=0; inode<numNodesPerElem; inode++) {
@@ -1039,23 +1129,25 @@ int main(int argc, char *argv[]) {
 /*************************BUILD INCIDENCE MATRIX***********************************/
 /**********************************************************************************/
 
-  // Edge to node incidence matrix
-    Epetra_FECrsMatrix DGrad(Copy, globalMapC, 2);
+  // Edge to node incidence matrix, written directly in CRS form from edgeToNode
+    std::vector<double> edgeNodeVals(2*numEdges);
+    for (int j=0; j<numEdges; j++){
+      edgeNodeVals[2*j]   = -1.0;
+      edgeNodeVals[2*j+1] =  1.0;
+    }
+
+    Teuchos::RCP<Epetra_CrsMatrix> DGradPtr =
+       LSFEM_BuildIncidence(globalMapC, globalMapG, numEdges, edgeIsOwned, edgeToNode,
+                            &edgeNodeVals[0], numNodes, nodeIsOwned, globalNodeIds);
+    Epetra_CrsMatrix & DGrad = *DGradPtr;
 
     // Grab edge coordinates (for dumping to disk)
     Epetra_Vector EDGE_X(globalMapC);
     Epetra_Vector EDGE_Y(globalMapC);
     Epetra_Vector EDGE_Z(globalMapC);
 
-    double vals[2];
-    vals[0]=-1.0; vals[1]=1.0;
     for (int j=0, elid=0; j<numEdges; j++){
       if (edgeIsOwned[j]){
-        int rowNum = globalEdgeIds[j];
-        int colNum[2];
-        colNum[0] = globalNodeIds[edgeToNode(j,0)];
-        colNum[1] = globalNodeIds[edgeToNode(j,1)];
-        DGrad.InsertGlobalValues(1, &rowNum, 2, colNum, vals);
         EDGE_X[elid] = (nodeCoordx[edgeToNode(j,0)] + nodeCoordx[edgeToNode(j,1)])/2.0;
         EDGE_Y[elid] = (nodeCoordy[edgeToNode(j,0)] + nodeCoordy[edgeToNode(j,1)])/2.0;
         EDGE_Z[elid] = (nodeCoordz[edgeToNode(j,0)] + nodeCoordz[edgeToNode(j,1)])/2.0;
@@ -1063,9 +1155,6 @@ int main(int argc, char *argv[]) {
       }
     }
 
-    DGrad.GlobalAssemble(globalMapG,globalMapC);
-    DGrad.FillComplete(MassMatrixG.RowMap(),MassMatrixC.RowMap());
-
   if(MyPID==0) {std::cout << "Building incidence matrix                   "
                  << Time.ElapsedTime() << " sec \n"  ; Time.ResetStartTime();}
 
@@ -1168,17 +1257,102 @@ int main(int argc, char *argv[]) {
   if(MyPID==0) {std::cout << "Boundary Condition Setup                    "
                  << Time.ElapsedTime() << " sec \n\n"; Time.ResetStartTime();}
 
+/**********************************************************************************/
+/************************ BUILD ELEMENT ASSEMBLY LIST *****************************/
+/**********************************************************************************/
+
+  // Collect everything the workset loop needs per element: coordinates, global ids,
+  // edge signs, material value and boundary flags
+   LSFEM_ElementList asmElems(numNodesPerElem, numEdgesPerElem, numFacesPerElem, spaceDim);
+   asmElems.Resize(numElems);
+
+   for (int cell=0; cell<numElems; cell++){
+
+      // Physical cell coordinates and global node ids
+       for (int inode=0; inode<numNodesPerElem; inode++) {
+         asmElems.NodeGID(cell,inode) = globalNodeIds[elemToNode(cell,inode)];
+         asmElems.Coord(cell,inode,0) = nodeCoord(elemToNode(cell,inode),0);
+         asmElems.Coord(cell,inode,1) = nodeCoord(elemToNode(cell,inode),1);
+         asmElems.Coord(cell,inode,2) = nodeCoord(elemToNode(cell,inode),2);
+       }
+
+      // Edge global ids and signs
+       for (int iedge=0; iedge<numEdgesPerElem; iedge++) {
+          asmElems.EdgeGID(cell,iedge) = globalEdgeIds[elemToEdge(cell,iedge)];
+          if (elemToNode(cell,refEdgeToNode(iedge,0))==edgeToNode(elemToEdge(cell,iedge),0) &&
+              elemToNode(cell,refEdgeToNode(iedge,1))==edgeToNode(elemToEdge(cell,iedge),1))
+              asmElems.EdgeSign(cell,iedge) = 1.0;
+          else
+              asmElems.EdgeSign(cell,iedge) = -1.0;
+        }
+
+      // modify signs for edges that are owned by another processor
+      // (Note: this is particular to the numbering of edges used in Pamgen!!)
+       for (int iface=0; iface<4; iface++) {
+          if (!faceIsOwned[elemToFace(cell,iface)]) {
+             asmElems.EdgeSign(cell,iface)   = -1.0*asmElems.EdgeSign(cell,iface);
+             asmElems.EdgeSign(cell,iface+4) = -1.0*asmElems.EdgeSign(cell,iface+4);
+          }
+       }
+
+#ifdef DUMP_DATA
+       for (int iedge=0; iedge<numEdgesPerElem; iedge++) {
+          edgeSign[iedge][cell] = asmElems.EdgeSign(cell,iedge);
+       }
+#endif
+
+      // Face global ids and boundary flags
+       for (int iface=0; iface<numFacesPerElem; iface++) {
+          asmElems.FaceGID(cell,iface) = globalFaceIds[elemToFace(cell,iface)];
+          asmElems.FaceOnBoundary(cell,iface) = faceOnBoundary(elemToFace(cell,iface));
+       }
+
+       asmElems.Mu(cell) = muVal(cell);
+   }
+
+  // Owner computes: add the elements of neighboring processors that touch our nodes
+   if (ownerComputes) {
+      asmElems.ExchangeHalo(Comm, elemToNode, numNodes, num_node_comm_maps,
+                            node_comm_proc_ids, node_cmap_node_cnts, comm_node_ids);
+   }
+   int numAsmElems = asmElems.NumElements();
+
+  if(MyPID==0) {std::cout << "Build element assembly list                 "
+                 << Time.ElapsedTime() << " sec \n"; Time.ResetStartTime();}
+
+   if (ownerComputes) {
+      double ghostElems = asmElems.NumGhostElements(), ghostElemsTot = 0.0;
+      double ghostBytes = asmElems.BytesSent(), ghostBytesTot = 0.0;
+      Comm.SumAll(&ghostElems,&ghostElemsTot,1);
+      Comm.SumAll(&ghostBytes,&ghostBytesTot,1);
+      if (MyPID == 0) {
+        std::cout << "\tOwner computes: redundant ghost elements = " << ghostElemsTot << "\n";
+        std::cout << "\tOwner computes: halo bytes communicated  = " << ghostBytesTot << "\n\n";
+      }
+   }
+
 /**********************************************************************************/
 /******************** DEFINE WORKSETS AND LOOP OVER THEM **************************/
 /**********************************************************************************/
 
  // Define desired workset size and count how many worksets there are on this processor's mesh block
-  int desiredWorksetSize = numElems;                      // change to desired workset size!
+  int desiredWorksetSize = numAsmElems;                      // change to desired workset size!
   //int desiredWorksetSize = 100;                      // change to desired workset size!
-  int numWorksets        = numElems/desiredWorksetSize;
+  int numWorksets        = numAsmElems/desiredWorksetSize;
+
+  // When numAsmElems is not divisible by desiredWorksetSize, increase workset count by 1
+  if(numWorksets*desiredWorksetSize < numAsmElems) numWorksets += 1;
 
-  // When numElems is not divisible by desiredWorksetSize, increase workset count by 1
-  if(numWorksets*desiredWorksetSize < numElems) numWorksets += 1;
+  // Off-processor entries left for GlobalAssemble to ship (FECrs mode)
+  LSFEM_OffProcEntries offProcG, offProcC, offProcRhs;
+
+  // Element matrices saved for re-assembly with the scatter plan
+  FieldContainer<double> elemMassG, elemMassC, elemStiffC;
+  if (numReassemblies > 0) {
+     elemMassG.resize(numAsmElems, numFieldsG, numFieldsG);
+     elemMassC.resize(numAsmElems, numFieldsC, numFieldsC);
+     elemStiffC.resize(numAsmElems, numFieldsC, numFieldsC);
+  }
 
  if (MyPID == 0) {
     std::cout << "Building discretization matrix and right hand side... \n\n";
@@ -1194,8 +1368,8 @@ int main(int argc, char *argv[]) {
     int worksetBegin = (workset + 0)*desiredWorksetSize;
     int worksetEnd   = (workset + 1)*desiredWorksetSize;
 
-    // When numElems is not divisible by desiredWorksetSize, the last workset ends at numElems
-     worksetEnd   = (worksetEnd <= numElems) ? worksetEnd : numElems;
+    // When numAsmElems is not divisible by desiredWorksetSize, the last workset ends at numAsmElems
+     worksetEnd   = (worksetEnd <= numAsmElems) ? worksetEnd : numAsmElems;
 
     // Now we know the actual workset size and can allocate the array for the cell nodes
      worksetSize  = worksetEnd - worksetBegin;
@@ -1208,45 +1382,16 @@ int main(int argc, char *argv[]) {
 
       // Physical cell coordinates
        for (int inode=0; inode<numNodesPerElem; inode++) {
-         cellWorkset(cellCounter,inode,0) = nodeCoord(elemToNode(cell,inode),0);
-         cellWorkset(cellCounter,inode,1) = nodeCoord(elemToNode(cell,inode),1);
-         cellWorkset(cellCounter,inode,2) = nodeCoord(elemToNode(cell,inode),2);
+         cellWorkset(cellCounter,inode,0) = asmElems.Coord(cell,inode,0);
+         cellWorkset(cellCounter,inode,1) = asmElems.Coord(cell,inode,1);
+         cellWorkset(cellCounter,inode,2) = asmElems.Coord(cell,inode,2);
        }
 
       // Edge signs
        for (int iedge=0; iedge<numEdgesPerElem; iedge++) {
-          if (elemToNode(cell,refEdgeToNode(iedge,0))==edgeToNode(elemToEdge(cell,iedge),0) &&
-              elemToNode(cell,refEdgeToNode(iedge,1))==edgeToNode(elemToEdge(cell,iedge),1))
-              worksetEdgeSigns(cellCounter,iedge) = 1.0;
-          else
-              worksetEdgeSigns(cellCounter,iedge) = -1.0;
+          worksetEdgeSigns(cellCounter,iedge) = asmElems.EdgeSign(cell,iedge);
         }
 
-      // modify signs for edges that are owned by another processor
-      // (Note: this is particular to the numbering of edges used in Pamgen!!)
-       if (!faceIsOwned[elemToFace(cell,0)]) {
-            worksetEdgeSigns(cellCounter,0)=-1.0*worksetEdgeSigns(cellCounter,0);
-            worksetEdgeSigns(cellCounter,4)=-1.0*worksetEdgeSigns(cellCounter,4);
-        }
-       if (!faceIsOwned[elemToFace(cell,1)]) {
-            worksetEdgeSigns(cellCounter,1)=-1.0*worksetEdgeSigns(cellCounter,1);
-            worksetEdgeSigns(cellCounter,5)=-1.0*worksetEdgeSigns(cellCounter,5);
-        }
-       if (!faceIsOwned[elemToFace(cell,2)]) {
-            worksetEdgeSigns(cellCounter,2)=-1.0*worksetEdgeSigns(cellCounter,2);
-            worksetEdgeSigns(cellCounter,6)=-1.0*worksetEdgeSigns(cellCounter,6);
-        }
-       if (!faceIsOwned[elemToFace(cell,3)]) {
-            worksetEdgeSigns(cellCounter,3)=-1.0*worksetEdgeSigns(cellCounter,3);
-            worksetEdgeSigns(cellCounter,7)=-1.0*worksetEdgeSigns(cellCounter,7);
-        }
-
-#ifdef DUMP_DATA
-       for (int iedge=0; iedge<numEdgesPerElem; iedge++) {
-          edgeSign[iedge][cell] = worksetEdgeSigns(cellCounter,iedge);
-       }
-#endif
-
         cellCounter++;
 
      } // end loop over workset cells
@@ -1329,7 +1474,7 @@ int main(int argc, char *argv[]) {
       cellCounter = 0;
       for(int cell = worksetBegin; cell < worksetEnd; cell++){
          for (int nPt = 0; nPt < numCubPoints; nPt++){
-          weightedMeasureMuInv(cellCounter,nPt) = weightedMeasure(cellCounter,nPt) / muVal(cell);
+          weightedMeasureMuInv(cellCounter,nPt) = weightedMeasure(cellCounter,nPt) / asmElems.Mu(cell);
         }
         cellCounter++;
       }
@@ -1383,7 +1528,7 @@ int main(int argc, char *argv[]) {
       cellCounter = 0;
       for(int cell = worksetBegin; cell < worksetEnd; cell++){
          for (int nPt = 0; nPt < numCubPoints; nPt++){
-          weightedMeasureMu(cellCounter,nPt) = weightedMeasure(cellCounter,nPt) * muVal(cell);
+          weightedMeasureMu(cellCounter,nPt) = weightedMeasure(cellCounter,nPt) * asmElems.Mu(cell);
         }
         cellCounter++;
       }
@@ -1424,12 +1569,12 @@ int main(int argc, char *argv[]) {
             double z = worksetCubPoints(worksetCellOrdinal,nPt,2);
             double du1, du2, du3;
 
-            evalCurlu(du1, du2, du3, x, y, z, muVal(cell));
+            evalCurlu(du1, du2, du3, x, y, z, asmElems.Mu(cell));
             rhsDatag(worksetCellOrdinal,nPt,0) = du1;
             rhsDatag(worksetCellOrdinal,nPt,1) = du2;
             rhsDatag(worksetCellOrdinal,nPt,2) = du3;
 
-            evalGradDivu(du1, du2, du3,  x, y, z, muVal(cell));
+            evalGradDivu(du1, du2, du3,  x, y, z, asmElems.Mu(cell));
             rhsDatah(worksetCellOrdinal,nPt,0) = du1;
             rhsDatah(worksetCellOrdinal,nPt,1) = du2;
             rhsDatah(worksetCellOrdinal,nPt,2) = du3;
@@ -1456,7 +1601,7 @@ int main(int argc, char *argv[]) {
 
       // evaluate boundary term
        for (int iface = 0; iface < numFacesPerElem; iface++){
-          if (faceOnBoundary(elemToFace(cell,iface))){
+          if (asmElems.FaceOnBoundary(cell,iface)){
 
             // cell nodal coordinates
              for (int inode =0; inode < numNodesPerElem; inode++){
@@ -1505,7 +1650,7 @@ int main(int argc, char *argv[]) {
                 double y = worksetFacePoints(0, nPt, 1);
                 double z = worksetFacePoints(0, nPt, 2);
 
-                divuFace(0,nPt)=evalDivu(x, y, z, muVal(cell));
+                divuFace(0,nPt)=evalDivu(x, y, z, asmElems.Mu(cell));
               }
 
             // compute the dot product and multiply by Gauss weights
@@ -1552,20 +1697,36 @@ int main(int argc, char *argv[]) {
       // Compute cell ordinal relative to the current workset
       int worksetCellOrdinal = cell - worksetBegin;
 
+      // Save element matrices for re-assembly
+      if (numReassemblies > 0) {
+        for (int i = 0; i < numFieldsG; i++)
+          for (int j = 0; j < numFieldsG; j++)
+            elemMassG(cell,i,j) = massMatrixHGrad(worksetCellOrdinal,i,j);
+        for (int i = 0; i < numFieldsC; i++)
+          for (int j = 0; j < numFieldsC; j++) {
+            elemMassC(cell,i,j)  = massMatrixHCurl (worksetCellOrdinal,i,j);
+            elemStiffC(cell,i,j) = stiffMatrixHCurl(worksetCellOrdinal,i,j);
+          }
+      }
+
 
       /*** Assemble H(grad) mass matrix ***/
 
       // loop over nodes for matrix row
       for (int cellNodeRow = 0; cellNodeRow < numFieldsG; cellNodeRow++){
 
-        int localNodeRow  = elemToNode(cell, cellNodeRow);
-        int globalNodeRow = globalNodeIds[localNodeRow];
+        LSFEM_GO globalNodeRow = asmElems.NodeGID(cell, cellNodeRow);
+
+       // owner computes: rows of other processors are assembled by their owners
+        if (!globalMapG.MyGID(globalNodeRow)) {
+          if (ownerComputes) continue;
+          for (int j = 0; j < numFieldsG; j++) offProcG.Add(globalNodeRow, asmElems.NodeGID(cell, j));
+        }
 
        // loop over nodes for matrix column
         for (int cellNodeCol = 0; cellNodeCol < numFieldsG; cellNodeCol++){
 
-          int localNodeCol  = elemToNode(cell, cellNodeCol);
-          int globalNodeCol = globalNodeIds[localNodeCol];
+          LSFEM_GO globalNodeCol = asmElems.NodeGID(cell, cellNodeCol);
           double massGContribution = massMatrixHGrad(worksetCellOrdinal, cellNodeRow, cellNodeCol);
 
           MassMatrixG.InsertGlobalValues(1, &globalNodeRow, 1, &globalNodeCol, &massGContribution);
@@ -1579,17 +1740,22 @@ int main(int argc, char *argv[]) {
       // loop over edges for matrix row
       for (int cellEdgeRow = 0; cellEdgeRow < numFieldsC; cellEdgeRow++){
 
-        int localEdgeRow  = elemToEdge(cell, cellEdgeRow);
-        int globalEdgeRow = globalEdgeIds[localEdgeRow];
+        LSFEM_GO globalEdgeRow = asmElems.EdgeGID(cell, cellEdgeRow);
         double rhsContribution = gC(worksetCellOrdinal, cellEdgeRow) - hC(worksetCellOrdinal, cellEdgeRow);
 
+       // owner computes: rows of other processors are assembled by their owners
+        if (!globalMapC.MyGID(globalEdgeRow)) {
+          if (ownerComputes) continue;
+          for (int j = 0; j < numFieldsC; j++) offProcC.Add(globalEdgeRow, asmElems.EdgeGID(cell, j));
+          offProcRhs.Add(globalEdgeRow, 0);
+        }
+
         rhsVector.SumIntoGlobalValues(1, &globalEdgeRow, &rhsContribution);
 
        // loop over edges for matrix column
         for (int cellEdgeCol = 0; cellEdgeCol < numFieldsC; cellEdgeCol++){
 
-          int localEdgeCol  = elemToEdge(cell, cellEdgeCol);
-          int globalEdgeCol = globalEdgeIds[localEdgeCol];
+          LSFEM_GO globalEdgeCol = asmElems.EdgeGID(cell, cellEdgeCol);
 
           double massCContribution  = massMatrixHCurl (worksetCellOrdinal, cellEdgeRow, cellEdgeCol);
           double stiffCContribution = stiffMatrixHCurl(worksetCellOrdinal, cellEdgeRow, cellEdgeCol);
@@ -1622,6 +1788,77 @@ int main(int argc, char *argv[]) {
   if(MyPID==0) {std::cout << "Global assembly                             "
                  << Time.ElapsedTime() << " sec \n"; Time.ResetStartTime();}
 
+   if (!ownerComputes) {
+      // GlobalAssemble merges repeated contributions to an entry and then
+      // ships a column id and a value per entry and a row id and a length
+      // per row; the right-hand side ships an id and a value per row
+      offProcG.Merge(); offProcC.Merge(); offProcRhs.Merge();
+      double offProc[3] = {offProcG.NumEntries() + 2.0*offProcC.NumEntries(),
+                           offProcG.NumRows() + 2.0*offProcC.NumRows(),
+                           (double)offProcRhs.NumRows()};
+      double offProcTot[3];
+      Comm.SumAll(offProc,offProcTot,3);
+      if (MyPID == 0) {
+        std::cout << "\tFECrs: off-processor matrix entries      = " << offProcTot[0]
+                  << " in " << offProcTot[1] << " rows\n";
+        std::cout << "\tFECrs: off-processor rhs entries         = " << offProcTot[2] << "\n";
+        std::cout << "\tFECrs: assembly bytes communicated       = "
+                  << offProcTot[0]*(sizeof(LSFEM_GO)+sizeof(double))
+                   + offProcTot[1]*(sizeof(LSFEM_GO)+sizeof(int))
+                   + offProcTot[2]*(sizeof(LSFEM_GO)+sizeof(double)) << "\n\n";
+      }
+   }
+
+
+/**********************************************************************************/
+/********************** RE-ASSEMBLE WITH SCATTER PLAN *****************************/
+/**********************************************************************************/
+
+   if (numReassemblies > 0) {
+
+     // Offsets of every element entry in the CRS value arrays, computed once
+      LSFEM_ScatterPlan scatterPlanG(MassMatrixG,  numAsmElems, numFieldsG, &asmElems.NodeGID(0,0));
+      LSFEM_ScatterPlan scatterPlanC(MassMatrixC,  numAsmElems, numFieldsC, &asmElems.EdgeGID(0,0));
+      LSFEM_ScatterPlan scatterPlanS(StiffMatrixC, numAsmElems, numFieldsC, &asmElems.EdgeGID(0,0));
+
+      if(MyPID==0) {std::cout << "Build scatter plans                         "
+                     << Time.ElapsedTime() << " sec \n";
+                    std::cout << "\tElement colors (G, C):  " << scatterPlanG.NumColors()
+                     << ", " << scatterPlanC.NumColors() << "\n";
+                    Time.ResetStartTime();}
+
+      std::vector<double> valuesG = LSFEM_ScatterPlan::Values(MassMatrixG);
+      std::vector<double> valuesC = LSFEM_ScatterPlan::Values(MassMatrixC);
+      std::vector<double> valuesS = LSFEM_ScatterPlan::Values(StiffMatrixC);
+      Time.ResetStartTime();
+
+      for (int n = 0; n < numReassemblies; n++) {
+         MassMatrixG.PutScalar(0.0);
+         MassMatrixC.PutScalar(0.0);
+         StiffMatrixC.PutScalar(0.0);
+         scatterPlanG.Assemble(&elemMassG[0],  MassMatrixG);
+         scatterPlanC.Assemble(&elemMassC[0],  MassMatrixC);
+         scatterPlanS.Assemble(&elemStiffC[0], StiffMatrixC);
+      }
+
+      double reassemblyTime = Time.ElapsedTime()/numReassemblies;
+      int numThreads = 1;
+#ifdef _OPENMP
+      numThreads = omp_get_max_threads();
+#endif
+
+      // Re-assembled matrices should match the originals entry by entry, up to
+      // summation order
+      double entryDiff = LSFEM_ScatterPlan::MaxDifference(MassMatrixG, valuesG);
+      entryDiff = std::max(entryDiff, LSFEM_ScatterPlan::MaxDifference(MassMatrixC, valuesC));
+      entryDiff = std::max(entryDiff, LSFEM_ScatterPlan::MaxDifference(StiffMatrixC, valuesS));
+
+      if(MyPID==0) {std::cout << "Re-assemble with scatter plan (per pass)    "
+                     << reassemblyTime << " sec, " << numThreads << " threads\n";
+                    std::cout << "\tLargest change in matrix entries: " << entryDiff << "\n\n";
+                    Time.ResetStartTime();}
+   }
+
 
 #ifdef DUMP_DATA
     // Node Coordinates
@@ -1652,8 +1889,8 @@ int main(int argc, char *argv[]) {
    }
    Epetra_CrsMatrix MassMatrixGinv(Copy,MassMatrixG.RowMap(),MassMatrixG.RowMap(),1);
    for(int i=0;i<DiagG.MyLength();i++) {
-     int CID=MassMatrixG.GCID(i);
-     MassMatrixGinv.InsertGlobalValues(MassMatrixG.GRID(i),1,&(DiagG[i]),&CID);
+     LSFEM_GO CID=(LSFEM_GO)MassMatrixG.GCID64(i);
+     MassMatrixGinv.InsertGlobalValues((LSFEM_GO)MassMatrixG.GRID64(i),1,&(DiagG[i]),&CID);
    }
    MassMatrixGinv.FillComplete();
 
@@ -1661,17 +1898,23 @@ int main(int argc, char *argv[]) {
    for(int i=0;i<numNodes;i++) {
      if (nodeOnBoundary(i)){
       double val=0.0;
-      int index = globalNodeIds[i];
+      LSFEM_GO index = globalNodeIds[i];
       MassMatrixGinv.ReplaceGlobalValues(index,1,&val,&index);
      }
    }
 
-  // Get the full matrix operator
-   ML_Epetra::ML_RefMaxwell_11_Operator MatrixC(StiffMatrixC,DGrad,MassMatrixGinv,MassMatrixC);
+  // Get the full matrix operator (ML is 32-bit only: assembled with 64-bit ids)
+#ifndef LSFEM_64BIT_GLOBAL_IDS
+   Teuchos::RCP<Epetra_Operator> MatrixC =
+     Teuchos::rcp(new ML_Epetra::ML_RefMaxwell_11_Operator(StiffMatrixC,DGrad,MassMatrixGinv,MassMatrixC));
+#else
+   Teuchos::RCP<Epetra_Operator> MatrixC =
+     LSFEM_BuildRefMaxwell11(StiffMatrixC,DGrad,MassMatrixGinv,MassMatrixC);
+#endif
 
   // Apply it to v
    Epetra_MultiVector rhsDir(globalMapC,true);
-   MatrixC.Apply(v,rhsDir);
+   MatrixC->Apply(v,rhsDir);
 
   // Update right-hand side
    rhsVector.Update(-1.0,rhsDir,1.0);
@@ -1692,7 +1935,11 @@ int main(int argc, char *argv[]) {
 
    // Zero out rows and columns of stiffness matrix corresponding to Dirichlet edges
    //  and add one to diagonal.
+#ifndef LSFEM_64BIT_GLOBAL_IDS
     ML_Epetra::Apply_OAZToMatrix(BCEdges, numBCEdges, StiffMatrixC);
+#else
+    LSFEM_ApplyOAZToMatrix(BCEdges, numBCEdges, StiffMatrixC);
+#endif
 
     delete [] BCEdges;
 
@@ -1704,9 +1951,11 @@ int main(int argc, char *argv[]) {
 /*********************************** SOLVE ****************************************/
 /**********************************************************************************/
 
+   double TotalErrorResidual=0, TotalErrorExactSol=0;
+
+#ifndef LSFEM_64BIT_GLOBAL_IDS
    // Parameter list for ML
    Teuchos::ParameterList MLList,dummy;
-   double TotalErrorResidual=0, TotalErrorExactSol=0;
    ML_Epetra::SetDefaultsRefMaxwell(MLList);
    Teuchos::ParameterList MLList2=MLList.get("refmaxwell: 11list",MLList);
    MLList2.set("aggregation: type","Uncoupled-MIS");
@@ -1741,6 +1990,7 @@ int main(int argc, char *argv[]) {
   if (MyPID == 0) {
    cout<<MLList2<<endl;
   }
+#endif
 
    Epetra_FEVector xh(rhsVector);
 
@@ -1751,10 +2001,17 @@ int main(int argc, char *argv[]) {
 
    char probType[12] = "curl_lsfem";
 
+#ifndef LSFEM_64BIT_GLOBAL_IDS
    TestMultiLevelPreconditioner_CurlLSFEM(probType,MLList2,StiffMatrixC,
                                           DGrad,MassMatrixGinv,MassMatrixC,
                                           xh,rhsVector,
                                           TotalErrorResidual, TotalErrorExactSol);
+#else
+   TestIfpackPreconditioner_CurlLSFEM(probType,StiffMatrixC,
+                                      DGrad,MassMatrixGinv,MassMatrixC,
+                                      xh,rhsVector,
+                                      TotalErrorResidual, TotalErrorExactSol);
+#endif
 
 /**********************************************************************************/
 /**************************** CALCULATE ERROR *************************************/
@@ -1771,7 +2028,9 @@ int main(int argc, char *argv[]) {
 
 #ifdef HAVE_MPI
    // Import solution onto current processor
-     Epetra_Map  solnMap(numEdgesGlobal, numEdgesGlobal, 0, Comm);
+   // (overlapping map of the edges of this processor's elements)
+     std::vector<LSFEM_GO> localEdgeGIDs(globalEdgeIds, globalEdgeIds+numEdges);
+     Epetra_Map  solnMap((LSFEM_GO)-1, numEdges, &localEdgeGIDs[0], (LSFEM_GO)0, Comm);
      Epetra_Import  solnImporter(solnMap, globalMapC);
      Epetra_FEVector  uCoeff(solnMap);
      uCoeff.Import(xh, solnImporter, Insert);
@@ -1881,11 +2140,11 @@ int main(int argc, char *argv[]) {
           double curluApprox2= 0.0;
           double curluApprox3 = 0.0;
           for (int i = 0; i < numFieldsC; i++){
-             int rowIndex = globalEdgeIds[elemToEdge(k,i)];
+             int rowIndex = elemToEdge(k,i);
 #ifdef HAVE_MPI
              double uh1 = uCoeff.Values()[rowIndex];
 #else
-             double uh1 = xh.Values()[rowIndex];
+             double uh1 = xh.Values()[globalEdgeIds[rowIndex]];
 #endif
              uApprox1 += uh1*uhCValsTrans(0,i,nPt,0)*hexEdgeSigns(0,i);
              uApprox2 += uh1*uhCValsTrans(0,i,nPt,1)*hexEdgeSigns(0,i);
@@ -2182,6 +2441,70 @@ void TestMultiLevelPreconditioner_CurlLSFEM(char ProblemType[],
     delete [] BCedges;
 }
 
+/*************************************************************************************/
+/************************** IFPACK PRECONDITIONER ************************************/
+/*************************************************************************************/
+void TestIfpackPreconditioner_CurlLSFEM(char ProblemType[],
+                                        Epetra_CrsMatrix   & CurlCurl,
+                                        Epetra_CrsMatrix   & D0clean,
+                                        Epetra_CrsMatrix   & M0inv,
+                                        Epetra_CrsMatrix   & M1,
+                                        Epetra_MultiVector & xh,
+                                        Epetra_MultiVector & b,
+                                        double & TotalErrorResidual,
+                                        double & TotalErrorExactSol){
+
+  /* Get the BC edges, nuke their rows of D0 and OAZ M1 */
+  std::vector<int> BCedges = LSFEM_FindDirichletRows(CurlCurl);
+  int numBCedges = (int)BCedges.size();
+  Epetra_CrsMatrix D0(D0clean);
+  LSFEM_ZeroRows(numBCedges ? &BCedges[0] : 0, numBCedges, D0);
+  LSFEM_ApplyOAZToMatrix(numBCedges ? &BCedges[0] : 0, numBCedges, M1);
+
+  if(!CurlCurl.Comm().MyPID())
+    cout<<"Total number of rows = "<<CurlCurl.NumGlobalRows64()<<endl;
+
+  /* Assemble the (1,1) Block Operator */
+  Teuchos::RCP<Epetra_CrsMatrix> Operator11 = LSFEM_BuildRefMaxwell11(CurlCurl,D0,M0inv,M1);
+
+  /* Build the AztecOO stuff */
+  Epetra_MultiVector x(xh);
+  x.PutScalar(0.0);
+
+  Epetra_LinearProblem Problem(Operator11.get(),&x,&b);
+  Epetra_MultiVector* lhs = Problem.GetLHS();
+  Epetra_MultiVector* rhs = Problem.GetRHS();
+
+  Epetra_Time Time(CurlCurl.Comm());
+
+  /* Build the Ifpack Preconditioner */
+  Ifpack Factory;
+  Teuchos::RCP<Ifpack_Preconditioner> Prec =
+    Teuchos::rcp(Factory.Create("point relaxation stand-alone", Operator11.get()));
+  Teuchos::ParameterList IfpackList;
+  IfpackList.set("relaxation: type", "symmetric Gauss-Seidel");
+  IfpackList.set("relaxation: sweeps", 2);
+  Prec->SetParameters(IfpackList);
+  Prec->Initialize();
+  Prec->Compute();
+
+  /* Solve! */
+  AztecOO solver(Problem);
+  solver.SetPrecOperator(Prec.get());
+  solver.SetAztecOption(AZ_solver, AZ_cg);
+  solver.SetAztecOption(AZ_output, 32);
+  solver.Iterate(2000, 1e-10);
+
+  Epetra_MultiVector xexact(xh);
+  xexact.PutScalar(0.0);
+
+  // accuracy check
+  string msg = ProblemType;
+  solution_test(msg,*Operator11,*lhs,*rhs,xexact,Time,TotalErrorExactSol,TotalErrorResidual);
+
+  xh = *lhs;
+}
+
 /**********************************************************************************/
 /************ USER DEFINED FUNCTIONS FOR EXACT SOLUTION ***************************/
 /**********************************************************************************/
@@ -78,6 +78,20 @@
 
 
      \endverbatim
+
+      Optional input file parameters:
+
+       \li "assembly mode" - "FECrs" (default) sums element contributions into Epetra_FECrsMatrix
+                             and ships off-processor rows in GlobalAssemble; "Owner Computes"
+                             also computes a one-layer halo of off-processor elements and inserts
+                             only locally owned rows, so assembly needs no communication.
+       \li "scatter plan reassemblies" - number of times to re-assemble the matrices from saved
+                             element matrices with a precomputed scatter plan (default 0).
+                             Requires "Owner Computes"; mimics the re-assembly done in Newton
+                             and time-stepping loops once the matrix graph is fixed.
+       \li "fused applies" - number of times to apply a*M2 + b*K2 with two Multiply calls and
+                             with one fused pass over the shared graph of the face mass and
+                             stiffness matrices (default 0), as a time integrator would.
  **/
 
 
@@ -131,9 +145,26 @@
 #include "pamgen_im_ne_nemesisI_l.h"
 #include "pamgen_extras.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// LSFEM example utilities
+#include "../LSFEM_common/LSFEM_GlobalOrdinal.hpp"
+#include "../LSFEM_common/LSFEM_ElementList.hpp"
+#include "../LSFEM_common/LSFEM_ScatterPlan.hpp"
+#include "../LSFEM_common/LSFEM_Incidence.hpp"
+#include "../LSFEM_common/LSFEM_OffProcEntries.hpp"
+#include "../LSFEM_common/LSFEM_AssembledOperator.hpp"
+#include "Epetra_SharedGraphMatrices.hpp"
+#include "Epetra_IntervalMap.hpp"
+
 // AztecOO includes
 #include "AztecOO.h"
 
+// Ifpack (64-bit global id solve)
+#include "Ifpack.h"
+
 // ML Includes
 #include "ml_epetra_utils.h"
 #include "ml_RefMaxwell_11_Operator.h"
@@ -208,6 +239,30 @@ void TestMultiLevelPreconditioner_DivLSFEM(char ProblemType[],
                                            double & TotalErrorResidual,
                                            double & TotalErrorExactSol);
 
+/** \brief  AztecOO CG with an Ifpack symmetric Gauss-Seidel preconditioner on the
+            assembled (1,1) operator; used instead of ML with 64-bit global ids
+
+    \param  ProblemType        [in]    problem type
+    \param  GradDiv            [in]    H(div) stiffness matrix
+    \param  D1clean            [in]    Face to edge incidence matrix
+    \param  M1inv              [in]    H(curl) mass matrix inverse
+    \param  M2                 [in]    H(div) mass matrix
+    \param  xh                 [out]   solution vector
+    \param  b                  [in]    right-hand-side vector
+    \param  TotalErrorResidual [out]   error residual
+    \param  TotalErrorExactSol [out]   error in xh
+
+ */
+void TestIfpackPreconditioner_DivLSFEM(char ProblemType[],
+                                       Epetra_CrsMatrix   & GradDiv,
+                                       Epetra_CrsMatrix   & D1clean,
+                                       Epetra_CrsMatrix   & M1inv,
+                                       Epetra_CrsMatrix   & M2,
+                                       Epetra_MultiVector & xh,
+                                       Epetra_MultiVector & b,
+                                       double & TotalErrorResidual,
+                                       double & TotalErrorExactSol);
+
 /**********************************************************************************/
 /******** FUNCTION DECLARATIONS FOR EXACT SOLUTION AND SOURCE TERMS ***************/
 /**********************************************************************************/
@@ -376,6 +431,17 @@ int main(int argc, char *argv[]) {
   // Get pamgen mesh definition
     std::string meshInput = Teuchos::getParameter<std::string>(inputList,"meshInput");
 
+  // Get assembly mode ("FECrs" or "Owner Computes")
+    std::string assemblyMode = inputList.get("assembly mode",std::string("FECrs"));
+    bool ownerComputes = (assemblyMode == "Owner Computes");
+
+  // Get number of re-assemblies with the scatter plan (needs all owned rows computed locally)
+    int numReassemblies = inputList.get("scatter plan reassemblies",0);
+    if (!ownerComputes) numReassemblies = 0;
+
+  // Get number of fused mass/stiffness applies to time
+    int numFusedApplies = inputList.get("fused applies",0);
+
 
 /**********************************************************************************/
 /***************************** GET CELL TOPOLOGY **********************************/
@@ -588,11 +654,11 @@ int main(int argc, char *argv[]) {
       if(nodeIsOwned[i]) ownedNodes++;
 
    // Build a list of the OWNED global ids...
-    int *ownedGIDs=new int [ownedNodes];
+    LSFEM_GO *ownedGIDs=new LSFEM_GO [ownedNodes];
     int oidx=0;
     for(int i=0;i<numNodes;i++)
       if(nodeIsOwned[i]){
-        ownedGIDs[oidx]=(int)globalNodeIds[i];
+        ownedGIDs[oidx]=(LSFEM_GO)globalNodeIds[i];
         oidx++;
       }
 
@@ -727,11 +793,11 @@ int main(int argc, char *argv[]) {
            numOwnedEdges++;
         }
      }
-    int * ownedEdgeIds = new int[numOwnedEdges];
+    LSFEM_GO * ownedEdgeIds = new LSFEM_GO[numOwnedEdges];
     int nedge=0;
     for (int i=0; i<numEdges; i++) {
         if (edgeIsOwned[i]){
-           ownedEdgeIds[nedge]=(int)globalEdgeIds[i];
+           ownedEdgeIds[nedge]=(LSFEM_GO)globalEdgeIds[i];
            nedge++;
         }
      }
@@ -747,21 +813,23 @@ int main(int argc, char *argv[]) {
            numOwnedFaces++;
         }
      }
-    int * ownedFaceIds = new int[numOwnedFaces];
+    LSFEM_GO * ownedFaceIds = new LSFEM_GO[numOwnedFaces];
     int nface=0;
     for (int i=0; i<numFaces; i++) {
         if (faceIsOwned[i]){
-           ownedFaceIds[nface]=(int)globalFaceIds[i];
+           ownedFaceIds[nface]=(LSFEM_GO)globalFaceIds[i];
            nface++;
         }
      }
 
   // Calculate number of global edges and faces
-    int numEdgesGlobal;
-    int numFacesGlobal;
+    long long numEdgesGlobal;
+    long long numFacesGlobal;
 #ifdef HAVE_MPI
-    Comm.SumAll(&numOwnedEdges,&numEdgesGlobal,1);
-    Comm.SumAll(&numOwnedFaces,&numFacesGlobal,1);
+    long long numOwnedEdgesLL = numOwnedEdges;
+    long long numOwnedFacesLL = numOwnedFaces;
+    Comm.SumAll(&numOwnedEdgesLL,&numEdgesGlobal,1);
+    Comm.SumAll(&numOwnedFacesLL,&numFacesGlobal,1);
 #else
     numEdgesGlobal = numEdges;
     numFacesGlobal = numFaces;
@@ -917,20 +985,51 @@ int main(int argc, char *argv[]) {
 /**********************************************************************************/
 
    // Define global epetra maps
-    Epetra_Map globalMapG(-1,ownedNodes,ownedGIDs,0,Comm);
-    Epetra_Map globalMapC(-1,numOwnedEdges,ownedEdgeIds,0,Comm);
-    Epetra_Map globalMapD(-1,numOwnedFaces,ownedFaceIds,0,Comm);
+    Epetra_Map globalMapG((LSFEM_GO)-1,ownedNodes,ownedGIDs,(LSFEM_GO)0,Comm);
+    Epetra_Map globalMapC((LSFEM_GO)-1,numOwnedEdges,ownedEdgeIds,(LSFEM_GO)0,Comm);
+    Epetra_Map globalMapD((LSFEM_GO)-1,numOwnedFaces,ownedFaceIds,(LSFEM_GO)0,Comm);
 
    // Global arrays in Epetra format
-    Epetra_FECrsMatrix MassMatrixC(Copy, globalMapC, numFieldsC);
-    Epetra_FECrsMatrix MassMatrixD(Copy, globalMapD, numFieldsD);
-    Epetra_FECrsMatrix MassMatrixG(Copy, globalMapG, numFieldsG);
-    Epetra_FECrsMatrix StiffMatrixD(Copy, globalMapD, numFieldsD);
-    Epetra_FEVector rhsVector(globalMapD);
+   // In owner computes mode only owned rows are inserted, so nothing is kept for GlobalAssemble
+    Epetra_FECrsMatrix MassMatrixC(Copy, globalMapC, numFieldsC, ownerComputes);
+    Epetra_FECrsMatrix MassMatrixD(Copy, globalMapD, numFieldsD, ownerComputes);
+    Epetra_FECrsMatrix MassMatrixG(Copy, globalMapG, numFieldsG, ownerComputes);
+    Epetra_FECrsMatrix StiffMatrixD(Copy, globalMapD, numFieldsD, ownerComputes);
+    Epetra_FEVector rhsVector(globalMapD, 1, ownerComputes);
 
  if(MyPID==0) {std::cout << "Build global maps                           "
                  << Time.ElapsedTime() << " sec \n";  Time.ResetStartTime();}
 
+   // Memory held by the global id lists of the maps (grows with the global id width)
+   {
+      double gidBytes = (double)(ownedNodes + numOwnedEdges + numOwnedFaces)*sizeof(LSFEM_GO), gidBytesTot = 0.0;
+      Comm.SumAll(&gidBytes,&gidBytesTot,1);
+      if (MyPID == 0) {
+        std::cout << "\tGlobal id width:         " << 8*sizeof(LSFEM_GO) << " bits\n";
+        std::cout << "\tMap global id storage:   " << gidBytesTot << " bytes\n\n";
+      }
+   }
+
+   // Compressed form of the same id lists: contiguous runs only (no owners are looked
+   // up here, so the replicated range directory is not built)
+   {
+      Epetra_Time intervalTime(Comm);
+      Epetra_IntervalMap<LSFEM_GO> intervalMapG(ownedNodes,ownedGIDs,Comm);
+      Epetra_IntervalMap<LSFEM_GO> intervalMapC(numOwnedEdges,ownedEdgeIds,Comm);
+      Epetra_IntervalMap<LSFEM_GO> intervalMapD(numOwnedFaces,ownedFaceIds,Comm);
+      double intervalSec = intervalTime.ElapsedTime(), intervalSecMax = 0.0;
+      double intervalBytes = intervalMapG.BytesUsed() + intervalMapC.BytesUsed() + intervalMapD.BytesUsed();
+      double intervalBytesTot = 0.0;
+      Comm.MaxAll(&intervalSec,&intervalSecMax,1);
+      Comm.SumAll(&intervalBytes,&intervalBytesTot,1);
+      if (MyPID == 0) {
+        std::cout << "\tInterval maps (runs G/C/D): " << intervalMapG.NumGlobalRuns() << " / "
+                  << intervalMapC.NumGlobalRuns() << " / " << intervalMapD.NumGlobalRuns() << "\n";
+        std::cout << "\tInterval map storage:    " << intervalBytesTot << " bytes, built in "
+                  << intervalSecMax << " sec\n\n";
+      }
+   }
+
 
 /**********************************************************************************/
 /************************** OUTPUT CONNECTIVITY (FOR PLOTTING) ********************/
@@ -948,7 +1047,7 @@ int main(int argc, char *argv[]) {
 
 #ifdef DUMP_DATA
     // Put element to node mapping in multivector for output
-     Epetra_Map   globalMapElem(numElemsGlobal, numElems, 0, Comm);
+     Epetra_Map   globalMapElem((LSFEM_GO)numElemsGlobal, numElems, (LSFEM_GO)0, Comm);
      Epetra_MultiVector elem2node(globalMapElem, numNodesPerElem);
      for (int ielem=0; ielem<numElems; ielem++) {
         for (int inode=0; inode<numNodesPerElem; inode++) {
@@ -1003,79 +1102,76 @@ int main(int argc, char *argv[]) {
 /*************************BUILD INCIDENCE MATRIX***********************************/
 /**********************************************************************************/
 
-  // Edge to node (DGrad) and face to edge (DCurl) incidence matrices
-    Epetra_FECrsMatrix DCurl(Copy, globalMapD, 4);
-    Epetra_FECrsMatrix DGrad(Copy, globalMapC, 2);
+  // Edge to node (DGrad) and face to edge (DCurl) incidence matrices are written
+  // directly in CRS form from the connectivity arrays (no FE assembly)
 
-   // Edge to node incidence matrix
-    double edgevals[2];
-    edgevals[0]=-1.0; edgevals[1]=1.0;
+   // Edge to node incidence values
+    std::vector<double> edgeNodeVals(2*numEdges);
     for (int j=0; j<numEdges; j++){
-      if (edgeIsOwned[j]){
-        int rowNum = globalEdgeIds[j];
-        int colNum[2];
-        colNum[0] = globalNodeIds[edgeToNode(j,0)];
-        colNum[1] = globalNodeIds[edgeToNode(j,1)];
-        DGrad.InsertGlobalValues(1, &rowNum, 2, colNum, edgevals);
-      }
+      edgeNodeVals[2*j]   = -1.0;
+      edgeNodeVals[2*j+1] =  1.0;
     }
 
-   // Edge to face incidence matrix
-   FieldContainer<bool> faceDone2(numFaces);
-   for (int i=0; i<numElems; i++){
+   // Face to edge incidence values: circulation sign of each face edge.
+   // Each owned face takes its orientation from the first element containing
+   // it, as in element-by-element assembly; edgeLocal maps each edge of that
+   // element to its local index, so the correction below needs no search
+    std::vector<double> faceEdgeVals(numEdgesPerFace*numFaces);
+    std::vector<bool>   faceDone(numFaces, false);
+    std::vector<int>    edgeLocal(numEdges, -1);
+    for (int i=0; i<numElems; i++){
+      for (int l=0; l<numEdgesPerElem; l++)
+        edgeLocal[elemToEdge(i,l)] = l;
       for (int k=0; k<numFacesPerElem; k++){
-         int iface=elemToFace(i,k);
-         if (faceIsOwned[iface] && !faceDone2(iface)){
-             double vals[4];
-             int rowNum = globalFaceIds[iface];
-             int colNum[4];
-
-            for (int m=0; m<numEdgesPerFace; m++){
-              colNum[m] = globalEdgeIds[faceToEdge(iface,m)];
-              int indm = m+1;
-              if (indm >= numEdgesPerFace) indm=0;
-              if (edgeToNode(faceToEdge(iface,m),1) == edgeToNode(faceToEdge(iface,indm),0) ||
-                 edgeToNode(faceToEdge(iface,m),1) == edgeToNode(faceToEdge(iface,indm),1)){
-                 vals[m]=1.0;}
-              else vals[m]=-1.0;
-
-            // This is a convoluted way to account for edge orientations that
-            // may be incorrect on the local processor because the edge is
-            // not owned by the local processor.
-             int edgeIndex = -1;
-             if (!edgeIsOwned[faceToEdge(iface,m)]){
-                 for (int l=0; l<numEdgesPerElem; l++){
-                    if (faceToEdge(iface,m)==elemToEdge(i,l))
-                       edgeIndex=l;
-                }
-             }
-               if (edgeIndex != -1 && edgeIndex < 8){
-                 if (edgeIndex < 4 && faceIsOwned[elemToFace(i,4)]){
-                   vals[m]=-1.0*vals[m];
-                 }
-                 else if (edgeIndex > 3 && faceIsOwned[elemToFace(i,5)]){
-                   vals[m]=-1.0*vals[m];
-                 }
-               }
-            } // end loop over face edges
-
-           DCurl.InsertGlobalValues(1, &rowNum, 4, colNum, vals);
-           faceDone2(iface)=1;
-
-       } // end if face is owned and face not done
-    } // end loop over element faces
-  } // end loop over elements
-
-
-    DGrad.GlobalAssemble(globalMapG,globalMapC);
-    DGrad.FillComplete(MassMatrixG.RowMap(),MassMatrixC.RowMap());
+        int iface = elemToFace(i,k);
+        if (!faceIsOwned[iface] || faceDone[iface]) continue;
+        faceDone[iface] = true;
+        for (int m=0; m<numEdgesPerFace; m++){
+          int indm = m+1;
+          if (indm >= numEdgesPerFace) indm=0;
+          int edgem = faceToEdge(iface,m);
+          int edgen = faceToEdge(iface,indm);
+          double val = (edgeToNode(edgem,1) == edgeToNode(edgen,0) ||
+                        edgeToNode(edgem,1) == edgeToNode(edgen,1)) ? 1.0 : -1.0;
+
+         // Correct the orientation of edges not owned by the local processor,
+         // relative to the position of the edge in the face's element
+         // (particular to Pamgen numbering)
+          if (!edgeIsOwned[edgem]){
+            int edgeIndex = edgeLocal[edgem];
+            if (edgeIndex < 4 && faceIsOwned[elemToFace(i,4)])
+              val = -val;
+            else if (edgeIndex > 3 && edgeIndex < 8 && faceIsOwned[elemToFace(i,5)])
+              val = -val;
+          }
+          faceEdgeVals[iface*numEdgesPerFace+m] = val;
+        }
+      }
+    }
 
-    DCurl.GlobalAssemble(globalMapC,globalMapD);
-    DCurl.FillComplete(MassMatrixC.RowMap(),MassMatrixD.RowMap());
+    Teuchos::RCP<Epetra_CrsMatrix> DGradPtr =
+       LSFEM_BuildIncidence(globalMapC, globalMapG, numEdges, edgeIsOwned, edgeToNode,
+                            &edgeNodeVals[0], numNodes, nodeIsOwned, globalNodeIds);
+    Teuchos::RCP<Epetra_CrsMatrix> DCurlPtr =
+       LSFEM_BuildIncidence(globalMapD, globalMapC, numFaces, faceIsOwned, faceToEdge,
+                            &faceEdgeVals[0], numEdges, edgeIsOwned, globalEdgeIds);
+    Epetra_CrsMatrix & DGrad = *DGradPtr;
+    Epetra_CrsMatrix & DCurl = *DCurlPtr;
 
   if(MyPID==0) {std::cout << "Building incidence matrices                 "
                  << Time.ElapsedTime() << " sec \n"  ; Time.ResetStartTime();}
 
+   // The curl of a gradient vanishes: DCurl*DGrad must be exactly zero
+    {
+      Epetra_CrsMatrix curlGrad(Copy, globalMapD, 0);
+      EpetraExt::MatrixMatrix::Multiply(DCurl,false,DGrad,false,curlGrad);
+      double curlGradNorm = curlGrad.NormInf();
+      if(MyPID==0) {std::cout << "\tNorm of DCurl*DGrad:   " << curlGradNorm << "\n";
+                    Time.ResetStartTime();}
+      TEUCHOS_TEST_FOR_EXCEPTION(curlGradNorm != 0.0, std::logic_error,
+        "Incidence matrices are inconsistent: DCurl*DGrad != 0");
+    }
+
 
 /**********************************************************************************/
 /******************** INHOMOGENEOUS BOUNDARY CONDITIONS ***************************/
@@ -1176,17 +1272,120 @@ int main(int argc, char *argv[]) {
   if(MyPID==0) {std::cout << "Boundary Condition Setup                    "
                  << Time.ElapsedTime() << " sec \n\n"; Time.ResetStartTime();}
 
+/**********************************************************************************/
+/************************ BUILD ELEMENT ASSEMBLY LIST *****************************/
+/**********************************************************************************/
+
+  // Collect everything the workset loop needs per element: coordinates, global ids,
+  // edge and face signs, material value and boundary flags
+   LSFEM_ElementList asmElems(numNodesPerElem, numEdgesPerElem, numFacesPerElem, spaceDim);
+   asmElems.Resize(numElems);
+
+   for (int cell=0; cell<numElems; cell++){
+
+      // Physical cell coordinates and global node ids
+       for (int inode=0; inode<numNodesPerElem; inode++) {
+         asmElems.NodeGID(cell,inode) = globalNodeIds[elemToNode(cell,inode)];
+         asmElems.Coord(cell,inode,0) = nodeCoord(elemToNode(cell,inode),0);
+         asmElems.Coord(cell,inode,1) = nodeCoord(elemToNode(cell,inode),1);
+         asmElems.Coord(cell,inode,2) = nodeCoord(elemToNode(cell,inode),2);
+       }
+
+     // Face global ids, boundary flags and signs
+      for (int iface=0; iface<numFacesPerElem; iface++) {
+         asmElems.FaceGID(cell,iface) = globalFaceIds[elemToFace(cell,iface)];
+         asmElems.FaceOnBoundary(cell,iface) = faceOnBoundary(elemToFace(cell,iface));
+         asmElems.FaceSign(cell,iface) = -1.0;
+         for (int i=0; i<numNodesPerFace; i++) {
+           int indf=i+1;
+           if (indf >= numNodesPerFace) indf=0;
+           if (elemToNode(cell,refFaceToNode(iface,0))==faceToNode(elemToFace(cell,iface),i) &&
+               elemToNode(cell,refFaceToNode(iface,1))==faceToNode(elemToFace(cell,iface),indf))
+                asmElems.FaceSign(cell,iface) = 1.0;
+          }
+           if (!faceIsOwned[elemToFace(cell,iface)]){
+              asmElems.FaceSign(cell,iface)=-1.0*asmElems.FaceSign(cell,iface);
+           }
+       }
+
+#ifdef DUMP_DATA
+       for (int iface=0; iface<numFacesPerElem; iface++) {
+          faceSign[iface][cell] = asmElems.FaceSign(cell,iface);
+       }
+#endif
+
+      // Edge global ids and signs
+       for (int iedge=0; iedge<numEdgesPerElem; iedge++) {
+          asmElems.EdgeGID(cell,iedge) = globalEdgeIds[elemToEdge(cell,iedge)];
+          if (elemToNode(cell,refEdgeToNode(iedge,0))==edgeToNode(elemToEdge(cell,iedge),0) &&
+              elemToNode(cell,refEdgeToNode(iedge,1))==edgeToNode(elemToEdge(cell,iedge),1))
+              asmElems.EdgeSign(cell,iedge) = 1.0;
+          else
+              asmElems.EdgeSign(cell,iedge) = -1.0;
+        }
+
+      // modify signs for edges that are owned by another processor
+      // (Note: this is particular to the numbering of edges used in Pamgen!!)
+       for (int iface=0; iface<4; iface++) {
+          if (!faceIsOwned[elemToFace(cell,iface)]) {
+             asmElems.EdgeSign(cell,iface)   = -1.0*asmElems.EdgeSign(cell,iface);
+             asmElems.EdgeSign(cell,iface+4) = -1.0*asmElems.EdgeSign(cell,iface+4);
+          }
+       }
+
+#ifdef DUMP_DATA
+       for (int iedge=0; iedge<numEdgesPerElem; iedge++) {
+          edgeSign[iedge][cell] = asmElems.EdgeSign(cell,iedge);
+       }
+#endif
+
+       asmElems.Mu(cell) = muVal(cell);
+   }
+
+  // Owner computes: add the elements of neighboring processors that touch our nodes
+   if (ownerComputes) {
+      asmElems.ExchangeHalo(Comm, elemToNode, numNodes, num_node_comm_maps,
+                            node_comm_proc_ids, node_cmap_node_cnts, comm_node_ids);
+   }
+   int numAsmElems = asmElems.NumElements();
+
+  if(MyPID==0) {std::cout << "Build element assembly list                 "
+                 << Time.ElapsedTime() << " sec \n"; Time.ResetStartTime();}
+
+   if (ownerComputes) {
+      double ghostElems = asmElems.NumGhostElements(), ghostElemsTot = 0.0;
+      double ghostBytes = asmElems.BytesSent(), ghostBytesTot = 0.0;
+      Comm.SumAll(&ghostElems,&ghostElemsTot,1);
+      Comm.SumAll(&ghostBytes,&ghostBytesTot,1);
+      if (MyPID == 0) {
+        std::cout << "\tOwner computes: redundant ghost elements = " << ghostElemsTot << "\n";
+        std::cout << "\tOwner computes: halo bytes communicated  = " << ghostBytesTot << "\n\n";
+      }
+   }
+
 /**********************************************************************************/
 /******************** DEFINE WORKSETS AND LOOP OVER THEM **************************/
 /**********************************************************************************/
 
 // Define desired workset size and count how many worksets there are on this processor's mesh block
-  int desiredWorksetSize = numElems;                      // change to desired workset size!
+  int desiredWorksetSize = numAsmElems;                      // change to desired workset size!
   //int desiredWorksetSize = 100;                      // change to desired workset size!
-  int numWorksets        = numElems/desiredWorksetSize;
+  int numWorksets        = numAsmElems/desiredWorksetSize;
+
+  // When numAsmElems is not divisible by desiredWorksetSize, increase workset count by 1
+  if(numWorksets*desiredWorksetSize < numAsmElems) numWorksets += 1;
 
-  // When numElems is not divisible by desiredWorksetSize, increase workset count by 1
-  if(numWorksets*desiredWorksetSize < numElems) numWorksets += 1;
+  // Off-processor entries left for GlobalAssemble to ship (FECrs mode)
+  LSFEM_OffProcEntries offProcG, offProcC, offProcD, offProcRhs;
+
+  // Element matrices saved for re-assembly with the scatter plan
+  FieldContainer<double> elemMassG, elemMassC, elemMassD, elemStiffD;
+  if (numReassemblies > 0) {
+     elemMassG.resize(numAsmElems, numFieldsG, numFieldsG);
+     elemMassC.resize(numAsmElems, numFieldsC, numFieldsC);
+     elemMassD.resize(numAsmElems, numFieldsD, numFieldsD);
+     elemStiffD.resize(numAsmElems, numFieldsD, numFieldsD);
+  }
 
  if (MyPID == 0) {
     std::cout << "Building discretization matrix and right hand side... \n\n";
@@ -1202,8 +1401,8 @@ int main(int argc, char *argv[]) {
     int worksetBegin = (workset + 0)*desiredWorksetSize;
     int worksetEnd   = (workset + 1)*desiredWorksetSize;
 
-    // When numElems is not divisible by desiredWorksetSize, the last workset ends at numElems
-     worksetEnd   = (worksetEnd <= numElems) ? worksetEnd : numElems;
+    // When numAsmElems is not divisible by desiredWorksetSize, the last workset ends at numAsmElems
+     worksetEnd   = (worksetEnd <= numAsmElems) ? worksetEnd : numAsmElems;
 
     // Now we know the actual workset size and can allocate the array for the cell nodes
      worksetSize  = worksetEnd - worksetBegin;
@@ -1217,65 +1416,21 @@ int main(int argc, char *argv[]) {
 
       // Physical cell coordinates
        for (int inode=0; inode<numNodesPerElem; inode++) {
-         cellWorkset(cellCounter,inode,0) = nodeCoord(elemToNode(cell,inode),0);
-         cellWorkset(cellCounter,inode,1) = nodeCoord(elemToNode(cell,inode),1);
-         cellWorkset(cellCounter,inode,2) = nodeCoord(elemToNode(cell,inode),2);
+         cellWorkset(cellCounter,inode,0) = asmElems.Coord(cell,inode,0);
+         cellWorkset(cellCounter,inode,1) = asmElems.Coord(cell,inode,1);
+         cellWorkset(cellCounter,inode,2) = asmElems.Coord(cell,inode,2);
        }
 
      // Face signs
       for (int iface=0; iface<numFacesPerElem; iface++) {
-         worksetFaceSigns(cellCounter,iface) = -1.0;
-         for (int i=0; i<numNodesPerFace; i++) {
-           int indf=i+1;
-           if (indf >= numNodesPerFace) indf=0;
-           if (elemToNode(cell,refFaceToNode(iface,0))==faceToNode(elemToFace(cell,iface),i) &&
-               elemToNode(cell,refFaceToNode(iface,1))==faceToNode(elemToFace(cell,iface),indf))
-                worksetFaceSigns(cellCounter,iface) = 1.0;
-          }
-           if (!faceIsOwned[elemToFace(cell,iface)]){
-              worksetFaceSigns(cellCounter,iface)=-1.0*worksetFaceSigns(cellCounter,iface);
-           }
+         worksetFaceSigns(cellCounter,iface) = asmElems.FaceSign(cell,iface);
        }
 
-#ifdef DUMP_DATA
-       for (int iface=0; iface<numFacesPerElem; iface++) {
-          faceSign[iface][cell] = worksetFaceSigns(cellCounter,iface);
-       }
-#endif
-
       // Edge signs
        for (int iedge=0; iedge<numEdgesPerElem; iedge++) {
-          if (elemToNode(cell,refEdgeToNode(iedge,0))==edgeToNode(elemToEdge(cell,iedge),0) &&
-              elemToNode(cell,refEdgeToNode(iedge,1))==edgeToNode(elemToEdge(cell,iedge),1))
-              worksetEdgeSigns(cellCounter,iedge) = 1.0;
-          else
-              worksetEdgeSigns(cellCounter,iedge) = -1.0;
+          worksetEdgeSigns(cellCounter,iedge) = asmElems.EdgeSign(cell,iedge);
         }
 
-      // modify signs for edges that are owned by another processor
-      // (Note: this is particular to the numbering of edges used in Pamgen!!)
-       if (!faceIsOwned[elemToFace(cell,0)]) {
-            worksetEdgeSigns(cellCounter,0)=-1.0*worksetEdgeSigns(cellCounter,0);
-            worksetEdgeSigns(cellCounter,4)=-1.0*worksetEdgeSigns(cellCounter,4);
-        }
-       if (!faceIsOwned[elemToFace(cell,1)]) {
-            worksetEdgeSigns(cellCounter,1)=-1.0*worksetEdgeSigns(cellCounter,1);
-            worksetEdgeSigns(cellCounter,5)=-1.0*worksetEdgeSigns(cellCounter,5);
-        }
-       if (!faceIsOwned[elemToFace(cell,2)]) {
-            worksetEdgeSigns(cellCounter,2)=-1.0*worksetEdgeSigns(cellCounter,2);
-            worksetEdgeSigns(cellCounter,6)=-1.0*worksetEdgeSigns(cellCounter,6);
-        }
-       if (!faceIsOwned[elemToFace(cell,3)]) {
-            worksetEdgeSigns(cellCounter,3)=-1.0*worksetEdgeSigns(cellCounter,3);
-            worksetEdgeSigns(cellCounter,7)=-1.0*worksetEdgeSigns(cellCounter,7);
-        }
-
-#ifdef DUMP_DATA
-       for (int iedge=0; iedge<numEdgesPerElem; iedge++) {
-          edgeSign[iedge][cell] = worksetEdgeSigns(cellCounter,iedge);
-       }
-#endif
         cellCounter++;
 
      } // end loop over workset cells
@@ -1364,7 +1519,7 @@ int main(int argc, char *argv[]) {
       cellCounter = 0;
       for(int cell = worksetBegin; cell < worksetEnd; cell++){
          for (int nPt = 0; nPt < numCubPoints; nPt++){
-          weightedMeasureMu(cellCounter,nPt) = weightedMeasure(cellCounter,nPt) * muVal(cell);
+          weightedMeasureMu(cellCounter,nPt) = weightedMeasure(cellCounter,nPt) * asmElems.Mu(cell);
         }
         cellCounter++;
       }
@@ -1473,7 +1628,7 @@ int main(int argc, char *argv[]) {
               double z = worksetCubPoints(worksetCellOrdinal,nPt,2);
               double du1, du2, du3;
 
-              evalCurlCurlu(du1, du2, du3, x, y, z, muVal(cell));
+              evalCurlCurlu(du1, du2, du3, x, y, z, asmElems.Mu(cell));
               rhsDatag(worksetCellOrdinal,nPt,0) = du1;
               rhsDatag(worksetCellOrdinal,nPt,1) = du2;
               rhsDatag(worksetCellOrdinal,nPt,2) = du3;
@@ -1504,7 +1659,7 @@ int main(int argc, char *argv[]) {
 
         // evaluate boundary term
           for (int iface = 0; iface < numFacesPerElem; iface++){
-             if (faceOnBoundary(elemToFace(cell,iface))){
+             if (asmElems.FaceOnBoundary(cell,iface)){
 
                // cell nodal coordinates
                 for (int inode =0; inode < numNodesPerElem; inode++){
@@ -1553,7 +1708,7 @@ int main(int argc, char *argv[]) {
                    double z = worksetFacePoints(0, nPt, 2);
 
                    evalCurlu(curluFace(0,nPt,0), curluFace(0,nPt,1),
-                             curluFace(0,nPt,2), x, y, z, muVal(cell));
+                             curluFace(0,nPt,2), x, y, z, asmElems.Mu(cell));
                  }
 
                // compute the cross product of curluFace with basis and multiply by weights
@@ -1604,20 +1759,39 @@ int main(int argc, char *argv[]) {
       // Compute cell ordinal relative to the current workset
       int worksetCellOrdinal = cell - worksetBegin;
 
+      // Save element matrices for re-assembly
+      if (numReassemblies > 0) {
+        for (int i = 0; i < numFieldsG; i++)
+          for (int j = 0; j < numFieldsG; j++)
+            elemMassG(cell,i,j) = massMatrixHGrad(worksetCellOrdinal,i,j);
+        for (int i = 0; i < numFieldsC; i++)
+          for (int j = 0; j < numFieldsC; j++)
+            elemMassC(cell,i,j) = massMatrixHCurl(worksetCellOrdinal,i,j);
+        for (int i = 0; i < numFieldsD; i++)
+          for (int j = 0; j < numFieldsD; j++) {
+            elemMassD(cell,i,j)  = massMatrixHDiv (worksetCellOrdinal,i,j);
+            elemStiffD(cell,i,j) = stiffMatrixHDiv(worksetCellOrdinal,i,j);
+          }
+      }
+
 
       /*** Assemble H(grad) mass matrix ***/
 
       // loop over nodes for matrix row
       for (int cellNodeRow = 0; cellNodeRow < numFieldsG; cellNodeRow++){
 
-        int localNodeRow  = elemToNode(cell, cellNodeRow);
-        int globalNodeRow = globalNodeIds[localNodeRow];
+        LSFEM_GO globalNodeRow = asmElems.NodeGID(cell, cellNodeRow);
+
+       // owner computes: rows of other processors are assembled by their owners
+        if (!globalMapG.MyGID(globalNodeRow)) {
+          if (ownerComputes) continue;
+          for (int j = 0; j < numFieldsG; j++) offProcG.Add(globalNodeRow, asmElems.NodeGID(cell, j));
+        }
 
        // loop over nodes for matrix column
         for (int cellNodeCol = 0; cellNodeCol < numFieldsG; cellNodeCol++){
 
-          int localNodeCol  = elemToNode(cell, cellNodeCol);
-          int globalNodeCol = globalNodeIds[localNodeCol];
+          LSFEM_GO globalNodeCol = asmElems.NodeGID(cell, cellNodeCol);
           double massGContribution = massMatrixHGrad(worksetCellOrdinal, cellNodeRow, cellNodeCol);
 
           MassMatrixG.InsertGlobalValues(1, &globalNodeRow, 1, &globalNodeCol, &massGContribution);
@@ -1631,14 +1805,18 @@ int main(int argc, char *argv[]) {
       // loop over edges for matrix row
       for (int cellEdgeRow = 0; cellEdgeRow < numFieldsC; cellEdgeRow++){
 
-        int localEdgeRow  = elemToEdge(cell, cellEdgeRow);
-        int globalEdgeRow = globalEdgeIds[localEdgeRow];
+        LSFEM_GO globalEdgeRow = asmElems.EdgeGID(cell, cellEdgeRow);
+
+       // owner computes: rows of other processors are assembled by their owners
+        if (!globalMapC.MyGID(globalEdgeRow)) {
+          if (ownerComputes) continue;
+          for (int j = 0; j < numFieldsC; j++) offProcC.Add(globalEdgeRow, asmElems.EdgeGID(cell, j));
+        }
 
        // loop over edges for matrix column
         for (int cellEdgeCol = 0; cellEdgeCol < numFieldsC; cellEdgeCol++){
 
-          int localEdgeCol  = elemToEdge(cell, cellEdgeCol);
-          int globalEdgeCol = globalEdgeIds[localEdgeCol];
+          LSFEM_GO globalEdgeCol = asmElems.EdgeGID(cell, cellEdgeCol);
 
           double massCContribution  = massMatrixHCurl (worksetCellOrdinal, cellEdgeRow, cellEdgeCol);
 
@@ -1653,17 +1831,22 @@ int main(int argc, char *argv[]) {
       // loop over faces for matrix row
       for (int cellFaceRow = 0; cellFaceRow < numFieldsD; cellFaceRow++){
 
-        int localFaceRow  = elemToFace(cell, cellFaceRow);
-        int globalFaceRow = globalFaceIds[localFaceRow];
+        LSFEM_GO globalFaceRow = asmElems.FaceGID(cell, cellFaceRow);
         double rhsContribution = gD(worksetCellOrdinal, cellFaceRow) + hD(worksetCellOrdinal, cellFaceRow);
 
+       // owner computes: rows of other processors are assembled by their owners
+        if (!globalMapD.MyGID(globalFaceRow)) {
+          if (ownerComputes) continue;
+          for (int j = 0; j < numFieldsD; j++) offProcD.Add(globalFaceRow, asmElems.FaceGID(cell, j));
+          offProcRhs.Add(globalFaceRow, 0);
+        }
+
         rhsVector.SumIntoGlobalValues(1, &globalFaceRow, &rhsContribution);
 
        // loop over faces for matrix column
         for (int cellFaceCol = 0; cellFaceCol < numFieldsD; cellFaceCol++){
 
-          int localFaceCol  = elemToFace(cell, cellFaceCol);
-          int globalFaceCol = globalFaceIds[localFaceCol];
+          LSFEM_GO globalFaceCol = asmElems.FaceGID(cell, cellFaceCol);
 
           double massDContribution  = massMatrixHDiv (worksetCellOrdinal, cellFaceRow, cellFaceCol);
           double stiffDContribution = stiffMatrixHDiv(worksetCellOrdinal, cellFaceRow, cellFaceCol);
@@ -1697,6 +1880,144 @@ int main(int argc, char *argv[]) {
   if(MyPID==0) {std::cout << "Global assembly                             "
                  << Time.ElapsedTime() << " sec \n"; Time.ResetStartTime();}
 
+   if (!ownerComputes) {
+      // GlobalAssemble merges repeated contributions to an entry and then
+      // ships a column id and a value per entry and a row id and a length
+      // per row; the right-hand side ships an id and a value per row
+      offProcG.Merge(); offProcC.Merge(); offProcD.Merge(); offProcRhs.Merge();
+      double offProc[3] = {offProcG.NumEntries() + offProcC.NumEntries() + 2.0*offProcD.NumEntries(),
+                           offProcG.NumRows() + offProcC.NumRows() + 2.0*offProcD.NumRows(),
+                           (double)offProcRhs.NumRows()};
+      double offProcTot[3];
+      Comm.SumAll(offProc,offProcTot,3);
+      if (MyPID == 0) {
+        std::cout << "\tFECrs: off-processor matrix entries      = " << offProcTot[0]
+                  << " in " << offProcTot[1] << " rows\n";
+        std::cout << "\tFECrs: off-processor rhs entries         = " << offProcTot[2] << "\n";
+        std::cout << "\tFECrs: assembly bytes communicated       = "
+                  << offProcTot[0]*(sizeof(LSFEM_GO)+sizeof(double))
+                   + offProcTot[1]*(sizeof(LSFEM_GO)+sizeof(int))
+                   + offProcTot[2]*(sizeof(LSFEM_GO)+sizeof(double)) << "\n\n";
+      }
+   }
+
+
+/**********************************************************************************/
+/********************** RE-ASSEMBLE WITH SCATTER PLAN *****************************/
+/**********************************************************************************/
+
+   if (numReassemblies > 0) {
+
+     // Offsets of every element entry in the CRS value arrays, computed once
+      LSFEM_ScatterPlan scatterPlanG(MassMatrixG,  numAsmElems, numFieldsG, &asmElems.NodeGID(0,0));
+      LSFEM_ScatterPlan scatterPlanC(MassMatrixC,  numAsmElems, numFieldsC, &asmElems.EdgeGID(0,0));
+      LSFEM_ScatterPlan scatterPlanD(MassMatrixD,  numAsmElems, numFieldsD, &asmElems.FaceGID(0,0));
+      LSFEM_ScatterPlan scatterPlanS(StiffMatrixD, numAsmElems, numFieldsD, &asmElems.FaceGID(0,0));
+
+      if(MyPID==0) {std::cout << "Build scatter plans                         "
+                     << Time.ElapsedTime() << " sec \n";
+                    std::cout << "\tElement colors (G, C, D):  " << scatterPlanG.NumColors()
+                     << ", " << scatterPlanC.NumColors() << ", " << scatterPlanD.NumColors() << "\n";
+                    Time.ResetStartTime();}
+
+      std::vector<double> valuesG = LSFEM_ScatterPlan::Values(MassMatrixG);
+      std::vector<double> valuesC = LSFEM_ScatterPlan::Values(MassMatrixC);
+      std::vector<double> valuesD = LSFEM_ScatterPlan::Values(MassMatrixD);
+      std::vector<double> valuesS = LSFEM_ScatterPlan::Values(StiffMatrixD);
+      Time.ResetStartTime();
+
+      for (int n = 0; n < numReassemblies; n++) {
+         MassMatrixG.PutScalar(0.0);
+         MassMatrixC.PutScalar(0.0);
+         MassMatrixD.PutScalar(0.0);
+         StiffMatrixD.PutScalar(0.0);
+         scatterPlanG.Assemble(&elemMassG[0],  MassMatrixG);
+         scatterPlanC.Assemble(&elemMassC[0],  MassMatrixC);
+         scatterPlanD.Assemble(&elemMassD[0],  MassMatrixD);
+         scatterPlanS.Assemble(&elemStiffD[0], StiffMatrixD);
+      }
+
+      double reassemblyTime = Time.ElapsedTime()/numReassemblies;
+      int numThreads = 1;
+#ifdef _OPENMP
+      numThreads = omp_get_max_threads();
+#endif
+
+      // Re-assembled matrices should match the originals entry by entry, up to
+      // summation order
+      double entryDiff = LSFEM_ScatterPlan::MaxDifference(MassMatrixG, valuesG);
+      entryDiff = std::max(entryDiff, LSFEM_ScatterPlan::MaxDifference(MassMatrixC, valuesC));
+      entryDiff = std::max(entryDiff, LSFEM_ScatterPlan::MaxDifference(MassMatrixD, valuesD));
+      entryDiff = std::max(entryDiff, LSFEM_ScatterPlan::MaxDifference(StiffMatrixD, valuesS));
+
+      if(MyPID==0) {std::cout << "Re-assemble with scatter plan (per pass)    "
+                     << reassemblyTime << " sec, " << numThreads << " threads\n";
+                    std::cout << "\tLargest change in matrix entries: " << entryDiff << "\n\n";
+                    Time.ResetStartTime();}
+   }
+
+
+/**********************************************************************************/
+/******************* FUSED APPLY OF a*M2 + b*K2 ON THE SHARED GRAPH ***************/
+/**********************************************************************************/
+
+   if (numFusedApplies > 0) {
+
+      Epetra_SharedGraphMatrices familyD(MassMatrixD.Graph());
+      int idM = familyD.AddMatrix(MassMatrixD);
+      int idK = familyD.AddMatrix(StiffMatrixD);
+
+      if (idM < 0 || idK < 0) {
+         if(MyPID==0) std::cout << "Fused apply: MassMatrixD and StiffMatrixD do not share a graph, skipped\n\n";
+      }
+      else {
+         // Coefficients of a backward Euler step M2 + dt*K2
+         double coeffs[2] = {1.0, 0.1};
+         Epetra_Vector x(globalMapD), yTwo(globalMapD), yFused(globalMapD), tmp(globalMapD);
+         x.Random();
+
+         Time.ResetStartTime();
+         for (int n = 0; n < numFusedApplies; n++) {
+            MassMatrixD.Multiply(false, x, yTwo);
+            StiffMatrixD.Multiply(false, x, tmp);
+            yTwo.Update(coeffs[1], tmp, coeffs[0]);
+         }
+         double twoMultiplyTime = Time.ElapsedTime()/numFusedApplies;
+
+         Time.ResetStartTime();
+         for (int n = 0; n < numFusedApplies; n++)
+            familyD.Apply(coeffs, x, yFused);
+         double fusedTime = Time.ElapsedTime()/numFusedApplies;
+
+         // Materialize M2 + dt*K2 by overwriting values only
+         Time.ResetStartTime();
+         Epetra_CrsMatrix combinedD(Copy, familyD.Graph());
+         combinedD.FillComplete(MassMatrixD.DomainMap(), MassMatrixD.RangeMap());
+         double combineSetupTime = Time.ElapsedTime();
+         Time.ResetStartTime();
+         familyD.Combine(coeffs, combinedD);
+         double combineTime = Time.ElapsedTime();
+
+         double normTwo, diffFused, diffCombined;
+         yTwo.Norm2(&normTwo);
+         tmp.Update(1.0, yFused, -1.0, yTwo, 0.0);
+         tmp.Norm2(&diffFused);
+         combinedD.Multiply(false, x, tmp);
+         tmp.Update(-1.0, yTwo, 1.0);
+         tmp.Norm2(&diffCombined);
+
+         if(MyPID==0) {std::cout << "Apply M2 + dt*K2, two Multiply (per apply)  "
+                        << twoMultiplyTime << " sec \n";
+                       std::cout << "Apply M2 + dt*K2, fused (per apply)         "
+                        << fusedTime << " sec \n";
+                       std::cout << "Combine M2 + dt*K2 values                   "
+                        << combineTime << " sec (matrix setup " << combineSetupTime << " sec)\n";
+                       std::cout << "\tRelative difference, fused:    " << diffFused/normTwo << "\n";
+                       std::cout << "\tRelative difference, combined: " << diffCombined/normTwo << "\n\n";
+                       Time.ResetStartTime();}
+      }
+   }
+
 
 #ifdef DUMP_DATA
     // Node Coordinates
@@ -1727,8 +2048,8 @@ int main(int argc, char *argv[]) {
       DiagC[i]=1.0/DiagC[i];
     }
     for(int i=0; i<DiagC.MyLength(); i++) {
-      int CID=MassMatrixC.GCID(i);
-      MassMatrixCinv.InsertGlobalValues(MassMatrixC.GRID(i),1,&(DiagC[i]),&CID);
+      LSFEM_GO CID=(LSFEM_GO)MassMatrixC.GCID64(i);
+      MassMatrixCinv.InsertGlobalValues((LSFEM_GO)MassMatrixC.GRID64(i),1,&(DiagC[i]),&CID);
     }
     MassMatrixCinv.FillComplete();
 
@@ -1736,17 +2057,23 @@ int main(int argc, char *argv[]) {
     for(int i=0;i<numEdges;i++) {
        if (edgeOnBoundary(i)){
           double val=0.0;
-          int index = globalEdgeIds[i];
+          LSFEM_GO index = globalEdgeIds[i];
           MassMatrixCinv.ReplaceGlobalValues(index,1,&val,&index);
        }
     }
 
-   // Get the full operator matrix
-   ML_Epetra::ML_RefMaxwell_11_Operator MatrixD(StiffMatrixD,DCurl,MassMatrixCinv,MassMatrixD);
+   // Get the full operator matrix (ML is 32-bit only: assembled with 64-bit ids)
+#ifndef LSFEM_64BIT_GLOBAL_IDS
+   Teuchos::RCP<Epetra_Operator> MatrixD =
+     Teuchos::rcp(new ML_Epetra::ML_RefMaxwell_11_Operator(StiffMatrixD,DCurl,MassMatrixCinv,MassMatrixD));
+#else
+   Teuchos::RCP<Epetra_Operator> MatrixD =
+     LSFEM_BuildRefMaxwell11(StiffMatrixD,DCurl,MassMatrixCinv,MassMatrixD);
+#endif
 
   // Apply it to v
    Epetra_MultiVector rhsDir(globalMapD,true);
-   MatrixD.Apply(v,rhsDir);
+   MatrixD->Apply(v,rhsDir);
 
    // Update right-hand side
    rhsVector.Update(-1.0,rhsDir,1.0);
@@ -1766,8 +2093,13 @@ int main(int argc, char *argv[]) {
 
    // Zero out rows and columns of stiffness and mass matrix corresponding to Dirichlet faces
    //  and add one to diagonal.
+#ifndef LSFEM_64BIT_GLOBAL_IDS
      ML_Epetra::Apply_OAZToMatrix(BCFaces, numBCFaces, StiffMatrixD);
      ML_Epetra::Apply_OAZToMatrix(BCFaces, numBCFaces, MassMatrixD);
+#else
+     LSFEM_ApplyOAZToMatrix(BCFaces, numBCFaces, StiffMatrixD);
+     LSFEM_ApplyOAZToMatrix(BCFaces, numBCFaces, MassMatrixD);
+#endif
 
      delete [] BCFaces;
 
@@ -1802,9 +2134,11 @@ int main(int argc, char *argv[]) {
 /*********************************** SOLVE ****************************************/
 /**********************************************************************************/
 
+   double TotalErrorResidual=0, TotalErrorExactSol=0;
+
+#ifndef LSFEM_64BIT_GLOBAL_IDS
    // Parameter list for ML
    Teuchos::ParameterList MLList,dummy,dummy2;
-   double TotalErrorResidual=0, TotalErrorExactSol=0;
    ML_Epetra::SetDefaultsRefMaxwell(MLList);
    Teuchos::ParameterList MLList2=MLList.get("refmaxwell: 11list",MLList);
    MLList2.set("aggregation: type","Uncoupled-MIS");
@@ -1839,6 +2173,7 @@ int main(int argc, char *argv[]) {
   if (MyPID == 0) {
    cout<<MLList2<<endl;
   }
+#endif
 
    Epetra_FEVector xh(rhsVector);
    MassMatrixG.SetLabel("M0");
@@ -1851,11 +2186,17 @@ int main(int argc, char *argv[]) {
 
    char probType[12] = "div_lsfem";
 
+#ifndef LSFEM_64BIT_GLOBAL_IDS
    TestMultiLevelPreconditioner_DivLSFEM(probType, MLList2, StiffMatrixD,
                                          DGrad, DCurl, FaceNode,
                                          MassMatrixC, MassMatrixCinv,
                                          MassMatrixD, xh, rhsVector,
                                          TotalErrorResidual, TotalErrorExactSol);
+#else
+   TestIfpackPreconditioner_DivLSFEM(probType, StiffMatrixD, DCurl,
+                                     MassMatrixCinv, MassMatrixD, xh, rhsVector,
+                                     TotalErrorResidual, TotalErrorExactSol);
+#endif
 
 /**********************************************************************************/
 /**************************** CALCULATE ERROR *************************************/
@@ -1872,7 +2213,9 @@ int main(int argc, char *argv[]) {
 
 #ifdef HAVE_MPI
    // Import solution onto current processor
-     Epetra_Map  solnMap(numFacesGlobal, numFacesGlobal, 0, Comm);
+   // (overlapping map of the faces of this processor's elements)
+     std::vector<LSFEM_GO> localFaceGIDs(globalFaceIds, globalFaceIds+numFaces);
+     Epetra_Map  solnMap((LSFEM_GO)-1, numFaces, &localFaceGIDs[0], (LSFEM_GO)0, Comm);
      Epetra_Import  solnImporter(solnMap, globalMapD);
      Epetra_FEVector  uCoeff(solnMap);
      uCoeff.Import(xh, solnImporter, Insert);
@@ -1968,11 +2311,11 @@ int main(int argc, char *argv[]) {
           double uApprox3 = 0.0;
           double divuApprox = 0.0;
           for (int i = 0; i < numFieldsD; i++){
-             int rowIndex = globalFaceIds[elemToFace(k,i)];
+             int rowIndex = elemToFace(k,i);
 #ifdef HAVE_MPI
              double uh1 = uCoeff.Values()[rowIndex];
 #else
-             double uh1 = xh.Values()[rowIndex];
+             double uh1 = xh.Values()[globalFaceIds[rowIndex]];
 #endif
              uApprox1 += uh1*uhDValsTrans(0,i,nPt,0)*hexFaceSigns(0,i);
              uApprox2 += uh1*uhDValsTrans(0,i,nPt,1)*hexFaceSigns(0,i);
@@ -2328,6 +2671,70 @@ void TestMultiLevelPreconditioner_DivLSFEM(char ProblemType[],
   delete [] BCfaces;
 }
 
+/*************************************************************************************/
+/************************** IFPACK PRECONDITIONER ************************************/
+/*************************************************************************************/
+void TestIfpackPreconditioner_DivLSFEM(char ProblemType[],
+                                       Epetra_CrsMatrix   & GradDiv,
+                                       Epetra_CrsMatrix   & D1clean,
+                                       Epetra_CrsMatrix   & M1inv,
+                                       Epetra_CrsMatrix   & M2,
+                                       Epetra_MultiVector & xh,
+                                       Epetra_MultiVector & b,
+                                       double & TotalErrorResidual,
+                                       double & TotalErrorExactSol){
+
+  /* Get the BC faces, nuke their rows of D1 and OAZ M2 */
+  std::vector<int> BCfaces = LSFEM_FindDirichletRows(GradDiv);
+  int numBCfaces = (int)BCfaces.size();
+  Epetra_CrsMatrix D1(D1clean);
+  LSFEM_ZeroRows(numBCfaces ? &BCfaces[0] : 0, numBCfaces, D1);
+  LSFEM_ApplyOAZToMatrix(numBCfaces ? &BCfaces[0] : 0, numBCfaces, M2);
+
+  if(!GradDiv.Comm().MyPID())
+    cout<<"Total number of rows = "<<GradDiv.NumGlobalRows64()<<endl;
+
+  /* Assemble the (1,1) Block Operator */
+  Teuchos::RCP<Epetra_CrsMatrix> Operator11 = LSFEM_BuildRefMaxwell11(GradDiv,D1,M1inv,M2);
+
+  /* Build the AztecOO stuff */
+  Epetra_MultiVector x(xh);
+  x.PutScalar(0.0);
+
+  Epetra_LinearProblem Problem(Operator11.get(),&x,&b);
+  Epetra_MultiVector* lhs = Problem.GetLHS();
+  Epetra_MultiVector* rhs = Problem.GetRHS();
+
+  Epetra_Time Time(GradDiv.Comm());
+
+  /* Build the Ifpack Preconditioner */
+  Ifpack Factory;
+  Teuchos::RCP<Ifpack_Preconditioner> Prec =
+    Teuchos::rcp(Factory.Create("point relaxation stand-alone", Operator11.get()));
+  Teuchos::ParameterList IfpackList;
+  IfpackList.set("relaxation: type", "symmetric Gauss-Seidel");
+  IfpackList.set("relaxation: sweeps", 2);
+  Prec->SetParameters(IfpackList);
+  Prec->Initialize();
+  Prec->Compute();
+
+  /* Solve! */
+  AztecOO solver(Problem);
+  solver.SetPrecOperator(Prec.get());
+  solver.SetAztecOption(AZ_solver, AZ_cg);
+  solver.SetAztecOption(AZ_output, 32);
+  solver.Iterate(2000, 1e-10);
+
+  Epetra_MultiVector xexact(xh);
+  xexact.PutScalar(0.0);
+
+  // accuracy check
+  string msg = ProblemType;
+  solution_test(msg,*Operator11,*lhs,*rhs,xexact,Time,TotalErrorExactSol,TotalErrorResidual);
+
+  xh = *lhs;
+}
+
 /**********************************************************************************/
 /************ USER DEFINED FUNCTIONS FOR EXACT SOLUTION ***************************/
 /**********************************************************************************/
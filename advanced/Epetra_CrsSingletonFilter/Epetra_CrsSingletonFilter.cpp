@@ -61,8 +61,11 @@
 #include "Ifpack_IlukGraph.h"
 #include "Ifpack_CrsRiluk.h"
 
-void BiCGSTAB(Epetra_CrsMatrix &A, Epetra_Vector &x, Epetra_Vector &b,
-	      Ifpack_CrsRiluk *M,
+#include "SparseApproximateInverse.hpp"
+#include "Epetra_ChunkedMigration.hpp"
+
+int BiCGSTAB(Epetra_CrsMatrix &A, Epetra_Vector &x, Epetra_Vector &b,
+	      const Epetra_Operator *M,
 	      int Maxiter, double Tolerance,
 	      double *residual, bool verbose);
 int Statistics(const Epetra_CrsSingletonFilter & filter);
@@ -85,13 +88,14 @@ int main(int argc, char *argv[]) {
 
   if(argc < 2 && verbose) {
     cerr << "Usage: " << argv[0]
-	 << " HB_filename [level_fill [level_overlap [absolute_threshold [ relative_threshold]]]]" << endl
+	 << " HB_filename [level_fill [level_overlap [absolute_threshold [ relative_threshold [chunk_rows]]]]]" << endl
 	 << "where:" << endl
 	 << "HB_filename        - filename and path of a Harwell-Boeing data set" << endl
 	 << "level_fill         - The amount of fill to use for ILU(k) preconditioner (default 0)" << endl
 	 << "level_overlap      - The amount of overlap used for overlapping Schwarz subdomains (default 0)" << endl
 	 << "absolute_threshold - The minimum value to place on the diagonal prior to factorization (default 0.0)" << endl
-	 << "relative_threshold - The relative amount to perturb the diagonal prior to factorization (default 1.0)" << endl << endl
+	 << "relative_threshold - The relative amount to perturb the diagonal prior to factorization (default 1.0)" << endl
+	 << "chunk_rows         - Rows per processor moved at once when distributing the matrix, 0 for a single Export (default 4096)" << endl << endl
 	 << "To specify a non-default value for one of these parameters, you must specify all" << endl
 	 << " preceding values but not any subsequent parameters. Example:" << endl
 	 << "ifpackHpcSerialMsr.exe mymatrix.hpc 1  - loads mymatrix.hpc, uses level fill of one, all other values are defaults" << endl
@@ -117,10 +121,21 @@ int main(int argc, char *argv[]) {
   // Create uniform distributed map
   Epetra_Map map(readMap->NumGlobalElements(), 0, Comm);
 
-  // Create Exporter to distribute read-in matrix and vectors
+  // Create Exporter to distribute read-in vectors; the matrix is moved
+  // in chunks of rows (Epetra_ChunkedMigration), which bounds the
+  // communication buffers by one chunk and allocates the target once.
+  // The product with the matrix read in is formed first, so that matrix
+  // and the read-in vectors can be released as soon as they are moved.
+
+  int ChunkRows = 4096;
+  if (argc > 6) ChunkRows = atoi(argv[6]);
+
+  Epetra_Vector readAxexact(*readMap);
+  readA->Multiply(false, *readxexact, readAxexact);
+  double readNorm;
+  readAxexact.Norm2(&readNorm);
 
   Epetra_Export exporter(*readMap, map);
-  Epetra_CrsMatrix A(Copy, map, 0);
   Epetra_Vector x(map);
   Epetra_Vector b(map);
   Epetra_Vector xexact(map);
@@ -131,26 +146,47 @@ int main(int argc, char *argv[]) {
   xexact.Export(*readxexact, exporter, Add);
   Comm.Barrier();
   double vectorRedistributeTime = FillTimer.ElapsedTime();
-  A.Export(*readA, exporter, Add);
-  Comm.Barrier();
-  double matrixRedistributeTime = FillTimer.ElapsedTime() - vectorRedistributeTime;
-  assert(A.FillComplete()==0);
-  Comm.Barrier();
-  double fillCompleteTime = FillTimer.ElapsedTime() - matrixRedistributeTime;
+  Epetra_CrsMatrix * Aptr = 0;
+  double matrixRedistributeTime, fillCompleteTime = 0.0;
+  if (ChunkRows > 0) {
+    // FillComplete() is part of Migrate()
+    {
+      Epetra_ChunkedMigration<int> migration(*readA, ChunkRows);
+      int migrateErr = migration.Migrate(map, Aptr);
+      assert(migrateErr==0);
+    }
+    Comm.Barrier();
+    matrixRedistributeTime = FillTimer.ElapsedTime() - vectorRedistributeTime;
+    delete readA;
+  }
+  else {
+    Aptr = new Epetra_CrsMatrix(Copy, map, 0);
+    Aptr->Export(*readA, exporter, Add);
+    Comm.Barrier();
+    matrixRedistributeTime = FillTimer.ElapsedTime() - vectorRedistributeTime;
+    delete readA;
+    assert(Aptr->FillComplete()==0);
+    Comm.Barrier();
+    fillCompleteTime = FillTimer.ElapsedTime() - matrixRedistributeTime;
+  }
+  delete readx;
+  delete readb;
+  delete readxexact;
+  Epetra_CrsMatrix & A = *Aptr;
+  double myPeakRSS = Epetra_ChunkedMigration<int>::PeakRSS(), peakRSS;
+  Comm.MaxAll(&myPeakRSS, &peakRSS, 1);
   if (Comm.MyPID()==0)	{
     cout << "\n\n****************************************************" << endl;
     cout << "\n Vector redistribute  time (sec) = " << vectorRedistributeTime<< endl;
     cout << "    Matrix redistribute time (sec) = " << matrixRedistributeTime << endl;
-    cout << "    Transform to Local  time (sec) = " << fillCompleteTime << endl<< endl;
+    cout << "    Transform to Local  time (sec) = " << fillCompleteTime << endl;
+    cout << "    Peak RSS after redistribute (MB, largest processor) = " << peakRSS/(1024.0*1024.0)
+	 << (ChunkRows > 0 ? "  (chunked)" : "  (single Export)") << endl << endl;
   }
-  Epetra_Vector tmp1(*readMap);
   Epetra_Vector tmp2(map);
-  readA->Multiply(false, *readxexact, tmp1);
-
   A.Multiply(false, xexact, tmp2);
   double residual;
-  tmp1.Norm2(&residual);
-  if (verbose) cout << "Norm of Ax from file            = " << residual << endl;
+  if (verbose) cout << "Norm of Ax from file            = " << readNorm << endl;
   tmp2.Norm2(&residual);
   if (verbose) cout << "Norm of Ax after redistribution = " << residual << endl << endl << endl;
 
@@ -158,10 +194,6 @@ int main(int argc, char *argv[]) {
 
   //cout << "A after dist = " << A << endl << endl << endl;
 
-  delete readA;
-  delete readx;
-  delete readb;
-  delete readxexact;
   delete readMap;
 
   Comm.Barrier();
@@ -298,9 +330,10 @@ int main(int argc, char *argv[]) {
     cout << "Inf norm of Reduced Matrix = " << normreduceda << endl
 	 << "Inf norm of Reduced RHS    = " << normreducedb << endl;
 
-  BiCGSTAB(*Ap, *xp, *bp, ILUK, Maxiter, Tolerance, &residual, verbose);
+  int iluIters = BiCGSTAB(*Ap, *xp, *bp, ILUK, Maxiter, Tolerance, &residual, verbose);
 
   elapsed_time = timer.ElapsedTime() - elapsed_time;
+  double iluSolveTime = elapsed_time;
   total_flops = counter.Flops();
   MFLOPs = total_flops/elapsed_time/1000000.0;
   if (verbose) cout << "Time to compute solution = "
@@ -308,6 +341,43 @@ int main(int argc, char *argv[]) {
 		    << "Number of operations in solve = " << total_flops << endl
 		    << "MFLOPS for Solve = " << MFLOPs<< endl << endl;
 
+  // Compare with a sparse approximate inverse on the reduced problem: its
+  // setup is a least squares problem per column (threaded) and its apply a
+  // single matvec, against the sequential triangular solves of ILU
+  {
+    elapsed_time = timer.ElapsedTime();
+    SparseApproximateInverse Spai(Teuchos::rcp(Ap, false));
+    assert(Spai.Compute()==0);
+    double spaiSetupTime = timer.ElapsedTime() - elapsed_time;
+
+    Epetra_Vector z(*xp);
+    double iluApplyTime = 0.0, spaiApplyTime;
+    if (ILUK!=0) {
+      elapsed_time = timer.ElapsedTime();
+      for (int i=0; i<10; i++) ILUK->ApplyInverse(*bp, z);
+      iluApplyTime = (timer.ElapsedTime() - elapsed_time)/10.0;
+    }
+    elapsed_time = timer.ElapsedTime();
+    for (int i=0; i<10; i++) Spai.ApplyInverse(*bp, z);
+    spaiApplyTime = (timer.ElapsedTime() - elapsed_time)/10.0;
+
+    Epetra_Vector xspai(*xp);
+    xspai.PutScalar(0.0);
+    double spaiResidual;
+    elapsed_time = timer.ElapsedTime();
+    int spaiIters = BiCGSTAB(*Ap, xspai, *bp, &Spai, Maxiter, Tolerance, &spaiResidual, false);
+    double spaiSolveTime = timer.ElapsedTime() - elapsed_time;
+
+    if (verbose)
+      cout << "Preconditioner comparison on the reduced problem:" << endl
+	   << "  ILU(" << LevelFill << ") apply time = " << iluApplyTime
+	   << ", BiCGSTAB iterations = " << iluIters << ", solve time = " << iluSolveTime << endl
+	   << "  SPAI  setup time = " << spaiSetupTime << " (" << Spai.NumFailedColumns()
+	   << " failed columns on PE 0), apply time = " << spaiApplyTime << endl
+	   << "        BiCGSTAB iterations = " << spaiIters << ", solve time = " << spaiSolveTime
+	   << ", residual = " << spaiResidual << endl << endl;
+  }
+
   SingletonFilter.ComputeFullSolution();
 
   if (smallProblem)
@@ -439,6 +509,7 @@ int main(int argc, char *argv[]) {
 
   if (ILUK!=0) delete ILUK;
   if (IlukGraph!=0) delete IlukGraph;
+  delete Aptr;
 				
 #ifdef EPETRA_MPI
   MPI_Finalize() ;
@@ -446,10 +517,10 @@ int main(int argc, char *argv[]) {
 
 return 0 ;
 }
-void BiCGSTAB(Epetra_CrsMatrix &A,
+int BiCGSTAB(Epetra_CrsMatrix &A,
 	      Epetra_Vector &x,
 	      Epetra_Vector &b,
-	      Ifpack_CrsRiluk *M,
+	      const Epetra_Operator *M,
 	      int Maxiter,
 	      double Tolerance,
 	      double *residual, bool verbose) {
@@ -480,7 +551,8 @@ void BiCGSTAB(Epetra_CrsMatrix &A,
 		    << " Scaled residual = " << scaled_r_norm << endl;
 
 
-  for (int i=0; i<Maxiter; i++) { // Main iteration loop
+  int i;
+  for (i=0; i<Maxiter; i++) { // Main iteration loop
 
     double beta = (rhon/rhonm1) * (alpha/omega);
     rhonm1 = rhon;
@@ -495,7 +567,7 @@ void BiCGSTAB(Epetra_CrsMatrix &A,
     if (M==0)
       phat.Scale(1.0, p);
     else
-      M->Solve(false, p, phat);
+      M->ApplyInverse(p, phat);
     A.Multiply(false, phat, v);
 
 
@@ -510,7 +582,7 @@ void BiCGSTAB(Epetra_CrsMatrix &A,
     if (M==0)
       shat.Scale(1.0, s);
     else
-      M->Solve(false, s, shat);
+      M->ApplyInverse(s, shat);
     A.Multiply(false, shat, r);
 
     r.Dot(s, &omega_num);
@@ -532,7 +604,8 @@ void BiCGSTAB(Epetra_CrsMatrix &A,
 
     if (r_norm < Tolerance) break;
   }
-  return;
+  *residual = r_norm;
+  return(i < Maxiter ? i+1 : Maxiter);
 }
 //==============================================================================
 int Statistics(const Epetra_CrsSingletonFilter & filter) {
@@ -0,0 +1,157 @@
+// @HEADER
+// ************************************************************************
+//
+//                           Intrepid Package
+//                 Copyright (2007) Sandia Corporation
+//
+// Under terms of Contract DE-AC04-94AL85000, there is a non-exclusive
+// license for use of this work by or on behalf of the U.S. Government.
+//
+// This library is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation; either version 2.1 of the
+// License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+// USA
+//
+// ************************************************************************
+// @HEADER
+
+/** \file   LSFEM_AssembledOperator.hpp
+    \brief  Assembled RefMaxwell (1,1) operator and Dirichlet utilities for
+            the LSFEM examples.
+
+    ML supports 32-bit global ids only.  With LSFEM_64BIT_GLOBAL_IDS the
+    examples cannot use ML_Epetra::ML_RefMaxwell_11_Operator or the
+    ML_Epetra Dirichlet utilities, so these functions provide the same
+    operations on Epetra_CrsMatrix: the (1,1) operator
+    \f$ S + M D M_0^{-1} D^T M \f$ is formed explicitly with
+    EpetraExt::MatrixMatrix, and the Dirichlet rows are found and eliminated
+    using local indices only.  All of them work for either global id width.
+ **/
+
+#ifndef LSFEM_ASSEMBLEDOPERATOR_HPP
+#define LSFEM_ASSEMBLEDOPERATOR_HPP
+
+#include <vector>
+
+#include "Teuchos_RCP.hpp"
+#include "Epetra_CrsMatrix.h"
+#include "Epetra_Vector.h"
+#include "Epetra_Import.h"
+#include "EpetraExt_MatrixMatrix.h"
+
+
+/** \brief Local indices of the Dirichlet rows of a matrix, i.e. the rows whose
+           only nonzero entry is on the diagonal (the counterpart of
+           ML_Epetra::FindLocalDiricheltRowsFromOnesAndZeros).
+
+    \param  A                 [in]    fill-complete matrix
+
+    \return local row indices, in increasing order
+ */
+inline std::vector<int> LSFEM_FindDirichletRows(const Epetra_CrsMatrix & A)
+{
+  std::vector<int> rows;
+  for (int i=0; i<A.NumMyRows(); i++) {
+    int numEntries, *indices;
+    double *values;
+    A.ExtractMyRowView(i, numEntries, values, indices);
+    bool dirichlet = true;
+    for (int j=0; j<numEntries && dirichlet; j++)
+      if (A.GCID64(indices[j]) != A.GRID64(i) && values[j] != 0.0) dirichlet = false;
+    if (dirichlet) rows.push_back(i);
+  }
+  return rows;
+}
+
+/** \brief Zero the given local rows of a matrix (the counterpart of
+           ML_Epetra::Apply_BCsToGradient).
+
+    \param  rows              [in]    local row indices
+    \param  numRows           [in]    number of rows
+    \param  A                 [in/out] fill-complete matrix
+ */
+inline void LSFEM_ZeroRows(const int * rows, int numRows, Epetra_CrsMatrix & A)
+{
+  for (int k=0; k<numRows; k++) {
+    int numEntries, *indices;
+    double *values;
+    A.ExtractMyRowView(rows[k], numEntries, values, indices);
+    for (int j=0; j<numEntries; j++) values[j] = 0.0;
+  }
+}
+
+/** \brief Zero the rows and columns of the given local rows and put one on
+           their diagonal (the counterpart of ML_Epetra::Apply_OAZToMatrix).
+
+    The matrix must be square with matching row and domain maps, as the
+    LSFEM stiffness and mass matrices are.
+
+    \param  rows              [in]    local row indices
+    \param  numRows           [in]    number of rows
+    \param  A                 [in/out] fill-complete matrix
+ */
+inline void LSFEM_ApplyOAZToMatrix(const int * rows, int numRows, Epetra_CrsMatrix & A)
+{
+ // Flag the Dirichlet rows and bring the flags to the column map
+  Epetra_Vector rowFlag(A.RowMap());
+  for (int k=0; k<numRows; k++) rowFlag[rows[k]] = 1.0;
+  Epetra_Vector colFlag(A.ColMap());
+  if (A.Importer())
+    colFlag.Import(rowFlag, *A.Importer(), Insert);
+  else
+    for (int i=0; i<A.NumMyRows(); i++) colFlag[i] = rowFlag[i];
+
+  for (int i=0; i<A.NumMyRows(); i++) {
+    int numEntries, *indices;
+    double *values;
+    A.ExtractMyRowView(i, numEntries, values, indices);
+    for (int j=0; j<numEntries; j++) {
+      if (rowFlag[i] != 0.0)
+        values[j] = (A.GCID64(indices[j]) == A.GRID64(i)) ? 1.0 : 0.0;
+      else if (colFlag[indices[j]] != 0.0)
+        values[j] = 0.0;
+    }
+  }
+}
+
+/** \brief Assemble the RefMaxwell (1,1) operator S + M D Minv D^T M.
+
+    \param  S                 [in]    stiffness matrix
+    \param  D                 [in]    incidence matrix (rows match S)
+    \param  Minv              [in]    inverse of the lower-space mass matrix
+    \param  M                 [in]    mass matrix (symmetric, rows match S)
+
+    \return fill-complete operator with the row, domain and range maps of S
+ */
+inline Teuchos::RCP<Epetra_CrsMatrix>
+LSFEM_BuildRefMaxwell11(const Epetra_CrsMatrix & S, const Epetra_CrsMatrix & D,
+                        const Epetra_CrsMatrix & Minv, const Epetra_CrsMatrix & M)
+{
+  Epetra_CrsMatrix MD(Copy, M.RowMap(), 0);
+  EpetraExt::MatrixMatrix::Multiply(M, false, D, false, MD);
+  Epetra_CrsMatrix MDMinv(Copy, M.RowMap(), 0);
+  EpetraExt::MatrixMatrix::Multiply(MD, false, Minv, false, MDMinv);
+
+ // (M D)^T = D^T M, since M is symmetric
+  Epetra_CrsMatrix P(Copy, M.RowMap(), 0);
+  EpetraExt::MatrixMatrix::Multiply(MDMinv, false, MD, true, P);
+
+  Epetra_CrsMatrix * A = 0;
+  EpetraExt::MatrixMatrix::Add(S, false, 1.0, P, false, 1.0, A);
+  A->FillComplete(S.DomainMap(), S.RangeMap());
+  A->OptimizeStorage();
+
+  return Teuchos::rcp(A);
+}
+
+#endif
@@ -0,0 +1,259 @@
+// @HEADER
+// ************************************************************************
+//
+//                           Intrepid Package
+//                 Copyright (2007) Sandia Corporation
+//
+// Under terms of Contract DE-AC04-94AL85000, there is a non-exclusive
+// license for use of this work by or on behalf of the U.S. Government.
+//
+// This library is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation; either version 2.1 of the
+// License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+// USA
+//
+// ************************************************************************
+// @HEADER
+
+/** \file   LSFEM_ElementList.hpp
+    \brief  Per-element assembly data for the LSFEM examples, with an optional
+            one-layer halo of elements owned by neighboring processors.
+
+    The LSFEM drivers assemble into Epetra_FECrsMatrix by default: elements
+    on the processor boundary contribute to rows owned by other processors,
+    and GlobalAssemble() ships and merges those contributions.
+
+    In "Owner Computes" mode every processor also receives each
+    off-processor element that shares a node with its part of the mesh.  It
+    computes those elements redundantly and inserts only the rows it owns, so
+    no matrix or right-hand side entries cross processor boundaries during
+    assembly.  The only communication is the one-time element halo exchange
+    done by ExchangeHalo().
+
+    Element data is stored flat (element-major), so the workset loop reads
+    local and ghost elements the same way.
+ **/
+
+#ifndef LSFEM_ELEMENTLIST_HPP
+#define LSFEM_ELEMENTLIST_HPP
+
+#include <vector>
+#include <map>
+
+#include "Epetra_Comm.h"
+#ifdef HAVE_MPI
+#include "mpi.h"
+#include "Epetra_MpiComm.h"
+#endif
+
+#include "Intrepid_FieldContainer.hpp"
+
+
+class LSFEM_ElementList {
+
+ public:
+
+  /** \brief Constructor
+
+      \param  numNodesPerElem   [in]    nodes per element
+      \param  numEdgesPerElem   [in]    edges per element
+      \param  numFacesPerElem   [in]    faces per element
+      \param  spaceDim          [in]    spatial dimension
+   */
+  LSFEM_ElementList(int numNodesPerElem, int numEdgesPerElem,
+                    int numFacesPerElem, int spaceDim)
+    : numNodes_(numNodesPerElem), numEdges_(numEdgesPerElem),
+      numFaces_(numFacesPerElem), spaceDim_(spaceDim),
+      numElems_(0), numLocalElems_(0), bytesSent_(0.0)
+  {}
+
+  //! Resize to hold \c numElems elements (contents of new elements are zero)
+  void Resize(int numElems) {
+    numElems_ = numElems;
+    numLocalElems_ = numElems;
+    nodeGIDs_.resize(numElems*numNodes_, 0);
+    coords_.resize(numElems*numNodes_*spaceDim_, 0.0);
+    edgeGIDs_.resize(numElems*numEdges_, 0);
+    edgeSigns_.resize(numElems*numEdges_, 0.0);
+    faceGIDs_.resize(numElems*numFaces_, 0);
+    faceSigns_.resize(numElems*numFaces_, 0.0);
+    faceOnBoundary_.resize(numElems*numFaces_, 0);
+    mu_.resize(numElems, 0.0);
+  }
+
+  //! Total number of elements (local plus ghost)
+  int NumElements() const {return numElems_;}
+
+  //! Number of elements from this processor's part of the mesh
+  int NumLocalElements() const {return numLocalElems_;}
+
+  //! Number of elements received from neighboring processors
+  int NumGhostElements() const {return numElems_ - numLocalElems_;}
+
+  //! Bytes sent by this processor during ExchangeHalo()
+  double BytesSent() const {return bytesSent_;}
+
+  long long & NodeGID(int e, int i)          {return nodeGIDs_[e*numNodes_+i];}
+  double    & Coord(int e, int i, int d)     {return coords_[(e*numNodes_+i)*spaceDim_+d];}
+  long long & EdgeGID(int e, int i)          {return edgeGIDs_[e*numEdges_+i];}
+  double    & EdgeSign(int e, int i)         {return edgeSigns_[e*numEdges_+i];}
+  long long & FaceGID(int e, int i)          {return faceGIDs_[e*numFaces_+i];}
+  double    & FaceSign(int e, int i)         {return faceSigns_[e*numFaces_+i];}
+  int       & FaceOnBoundary(int e, int i)   {return faceOnBoundary_[e*numFaces_+i];}
+  double    & Mu(int e)                      {return mu_[e];}
+
+  /** \brief Append every off-processor element that shares a node with this
+             processor's part of the mesh.
+
+      Must be called once, after the local elements have been filled in.
+      Each local element is sent to every processor listed in the node
+      communication maps of any of its nodes, so the receiving processor gets
+      all elements that touch the degrees of freedom it owns.
+
+      \param  Comm                 [in]    communicator
+      \param  elemToNode           [in]    local element to local node map
+      \param  numNodes             [in]    number of local nodes
+      \param  numNodeCommMaps      [in]    number of Pamgen node comm maps
+      \param  nodeCommProcIds      [in]    neighbor processor of each comm map
+      \param  nodeCmapNodeCnts     [in]    number of nodes in each comm map
+      \param  commNodeIds          [in]    (1-based) local node ids in each comm map
+   */
+  void ExchangeHalo(const Epetra_Comm & Comm,
+                    const Intrepid::FieldContainer<int> & elemToNode,
+                    int numNodes,
+                    long long numNodeCommMaps,
+                    const long long * nodeCommProcIds,
+                    const long long * nodeCmapNodeCnts,
+                    long long ** commNodeIds)
+  {
+#ifdef HAVE_MPI
+    const Epetra_MpiComm & mpiComm = dynamic_cast<const Epetra_MpiComm &>(Comm);
+    MPI_Comm comm = mpiComm.Comm();
+
+    int numNbrs = (int)numNodeCommMaps;
+    if (numNbrs <= 0) return;
+
+    const int gidRecLen = numNodes_ + numEdges_ + 2*numFaces_;
+    const int valRecLen = numNodes_*spaceDim_ + numEdges_ + numFaces_ + 1;
+
+   // Neighbor list (comm map index) for every shared local node
+    std::vector<std::vector<int> > nodeNbrs(numNodes);
+    for (int j=0; j<numNbrs; j++)
+      for (long long k=0; k<nodeCmapNodeCnts[j]; k++)
+        nodeNbrs[commNodeIds[j][k]-1].push_back(j);
+
+   // Pack each boundary element once for every neighbor that shares one of its nodes
+    std::vector<std::vector<long long> > sendGIDs(numNbrs);
+    std::vector<std::vector<double> >    sendVals(numNbrs);
+    std::vector<int> sendCounts(numNbrs,0);
+    std::vector<int> elemNbrs;
+    for (int e=0; e<numLocalElems_; e++) {
+      elemNbrs.clear();
+      for (int i=0; i<numNodes_; i++) {
+        const std::vector<int> & nbrs = nodeNbrs[elemToNode(e,i)];
+        for (unsigned n=0; n<nbrs.size(); n++) {
+          bool found = false;
+          for (unsigned m=0; m<elemNbrs.size(); m++)
+            if (elemNbrs[m] == nbrs[n]) found = true;
+          if (!found) elemNbrs.push_back(nbrs[n]);
+        }
+      }
+      for (unsigned m=0; m<elemNbrs.size(); m++) {
+        Pack(e, sendGIDs[elemNbrs[m]], sendVals[elemNbrs[m]]);
+        sendCounts[elemNbrs[m]]++;
+      }
+    }
+
+   // Exchange element counts with each neighbor
+    std::vector<int> recvCounts(numNbrs,0);
+    std::vector<MPI_Request> requests(4*numNbrs);
+    for (int j=0; j<numNbrs; j++) {
+      MPI_Irecv(&recvCounts[j], 1, MPI_INT, (int)nodeCommProcIds[j], 1001, comm, &requests[j]);
+      MPI_Isend(&sendCounts[j], 1, MPI_INT, (int)nodeCommProcIds[j], 1001, comm, &requests[numNbrs+j]);
+    }
+    MPI_Waitall(2*numNbrs, &requests[0], MPI_STATUSES_IGNORE);
+
+   // Exchange the element records
+    std::vector<std::vector<long long> > recvGIDs(numNbrs);
+    std::vector<std::vector<double> >    recvVals(numNbrs);
+    for (int j=0; j<numNbrs; j++) {
+      int nbr = (int)nodeCommProcIds[j];
+      recvGIDs[j].resize(recvCounts[j]*gidRecLen + 1);
+      recvVals[j].resize(recvCounts[j]*valRecLen + 1);
+      sendGIDs[j].push_back(0);  // keep &buf[0] valid for empty messages
+      sendVals[j].push_back(0.0);
+      MPI_Irecv(&recvGIDs[j][0], recvCounts[j]*gidRecLen, MPI_LONG_LONG, nbr, 1002, comm, &requests[4*j]);
+      MPI_Irecv(&recvVals[j][0], recvCounts[j]*valRecLen, MPI_DOUBLE,    nbr, 1003, comm, &requests[4*j+1]);
+      MPI_Isend(&sendGIDs[j][0], sendCounts[j]*gidRecLen, MPI_LONG_LONG, nbr, 1002, comm, &requests[4*j+2]);
+      MPI_Isend(&sendVals[j][0], sendCounts[j]*valRecLen, MPI_DOUBLE,    nbr, 1003, comm, &requests[4*j+3]);
+      bytesSent_ += sendCounts[j]*(gidRecLen*sizeof(long long) + valRecLen*sizeof(double));
+    }
+    MPI_Waitall(4*numNbrs, &requests[0], MPI_STATUSES_IGNORE);
+
+   // Append the ghost elements
+    int numGhost = 0;
+    for (int j=0; j<numNbrs; j++) numGhost += recvCounts[j];
+    int e = numLocalElems_;
+    Resize(numLocalElems_ + numGhost);
+    numLocalElems_ = e;
+    for (int j=0; j<numNbrs; j++)
+      for (int k=0; k<recvCounts[j]; k++, e++)
+        Unpack(e, &recvGIDs[j][k*gidRecLen], &recvVals[j][k*valRecLen]);
+#endif
+  }
+
+ private:
+
+  void Pack(int e, std::vector<long long> & gids, std::vector<double> & vals) {
+    for (int i=0; i<numNodes_; i++) gids.push_back(NodeGID(e,i));
+    for (int i=0; i<numEdges_; i++) gids.push_back(EdgeGID(e,i));
+    for (int i=0; i<numFaces_; i++) gids.push_back(FaceGID(e,i));
+    for (int i=0; i<numFaces_; i++) gids.push_back(FaceOnBoundary(e,i));
+    for (int i=0; i<numNodes_; i++)
+      for (int d=0; d<spaceDim_; d++) vals.push_back(Coord(e,i,d));
+    for (int i=0; i<numEdges_; i++) vals.push_back(EdgeSign(e,i));
+    for (int i=0; i<numFaces_; i++) vals.push_back(FaceSign(e,i));
+    vals.push_back(Mu(e));
+  }
+
+  void Unpack(int e, const long long * gids, const double * vals) {
+    for (int i=0; i<numNodes_; i++) NodeGID(e,i) = *gids++;
+    for (int i=0; i<numEdges_; i++) EdgeGID(e,i) = *gids++;
+    for (int i=0; i<numFaces_; i++) FaceGID(e,i) = *gids++;
+    for (int i=0; i<numFaces_; i++) FaceOnBoundary(e,i) = (int)*gids++;
+    for (int i=0; i<numNodes_; i++)
+      for (int d=0; d<spaceDim_; d++) Coord(e,i,d) = *vals++;
+    for (int i=0; i<numEdges_; i++) EdgeSign(e,i) = *vals++;
+    for (int i=0; i<numFaces_; i++) FaceSign(e,i) = *vals++;
+    Mu(e) = *vals++;
+  }
+
+  int numNodes_;
+  int numEdges_;
+  int numFaces_;
+  int spaceDim_;
+  int numElems_;
+  int numLocalElems_;
+  double bytesSent_;
+
+  std::vector<long long> nodeGIDs_;
+  std::vector<double>    coords_;
+  std::vector<long long> edgeGIDs_;
+  std::vector<double>    edgeSigns_;
+  std::vector<long long> faceGIDs_;
+  std::vector<double>    faceSigns_;
+  std::vector<int>       faceOnBoundary_;
+  std::vector<double>    mu_;
+};
+
+#endif
@@ -0,0 +1,55 @@
+// @HEADER
+// ************************************************************************
+//
+//                           Intrepid Package
+//                 Copyright (2007) Sandia Corporation
+//
+// Under terms of Contract DE-AC04-94AL85000, there is a non-exclusive
+// license for use of this work by or on behalf of the U.S. Government.
+//
+// This library is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation; either version 2.1 of the
+// License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+// USA
+//
+// ************************************************************************
+// @HEADER
+
+/** \file   LSFEM_GlobalOrdinal.hpp
+    \brief  Global id type used for the Epetra maps of the LSFEM examples.
+
+    By default the examples build 32-bit Epetra maps, which limits a mesh to
+    about 2.1 billion nodes, edges or faces.  Define LSFEM_64BIT_GLOBAL_IDS
+    (CMake option of the same name, or add it to DEFINES in the Makefiles) to
+    build long long maps instead; this requires an Epetra built with 64-bit
+    global indices.
+
+    ML supports 32-bit global ids only.  With LSFEM_64BIT_GLOBAL_IDS the
+    examples apply the boundary conditions with the Epetra-only utilities of
+    LSFEM_AssembledOperator.hpp and solve the assembled (1,1) operator with
+    AztecOO CG and an Ifpack symmetric Gauss-Seidel preconditioner instead
+    of the ML RefMaxwell preconditioner; the error computation is the same.
+    CMake builds the *_64 variants of both examples and runs them as tests
+    when Epetra supports 64-bit global ids.
+ **/
+
+#ifndef LSFEM_GLOBALORDINAL_HPP
+#define LSFEM_GLOBALORDINAL_HPP
+
+#ifdef LSFEM_64BIT_GLOBAL_IDS
+typedef long long LSFEM_GO;
+#else
+typedef int LSFEM_GO;
+#endif
+
+#endif
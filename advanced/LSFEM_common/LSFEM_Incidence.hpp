@@ -0,0 +1,160 @@
+// @HEADER
+// ************************************************************************
+//
+//                           Intrepid Package
+//                 Copyright (2007) Sandia Corporation
+//
+// Under terms of Contract DE-AC04-94AL85000, there is a non-exclusive
+// license for use of this work by or on behalf of the U.S. Government.
+//
+// This library is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation; either version 2.1 of the
+// License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+// USA
+//
+// ************************************************************************
+// @HEADER
+
+/** \file   LSFEM_Incidence.hpp
+    \brief  Direct CRS construction of the discrete gradient and curl
+            incidence matrices used by the LSFEM examples.
+
+    The incidence matrices have a fixed number of entries per row (2 nodes
+    per edge, 4 edges per face) known from the mesh connectivity, so they can
+    be written straight into the CRS arrays of an Epetra_CrsMatrix and
+    completed with ExpertStaticFillComplete().  This avoids the
+    Epetra_FECrsMatrix insertion path (per-entry global-to-local
+    translation, row searches and GlobalAssemble) entirely.
+
+    Orientations are left to the caller, who passes one value per row entry.
+ **/
+
+#ifndef LSFEM_INCIDENCE_HPP
+#define LSFEM_INCIDENCE_HPP
+
+#include <vector>
+#include <stdexcept>
+
+#include "Teuchos_RCP.hpp"
+#include "Teuchos_TestForException.hpp"
+#include "Epetra_Comm.h"
+#include "Epetra_Map.h"
+#include "Epetra_CrsMatrix.h"
+#include "Epetra_IntSerialDenseVector.h"
+
+#include "Intrepid_FieldContainer.hpp"
+
+#include "LSFEM_GlobalOrdinal.hpp"
+
+
+/** \brief Build a fill-complete incidence matrix directly in CRS form.
+
+    Rows are the locally owned row entities (edges or faces), in local order;
+    this must be the order used to build \c rangeMap.  Column entities owned
+    by this processor come first in the column map, in local order (the order
+    used to build \c domainMap), followed by the off-processor columns in the
+    order they are first referenced.
+
+    \param  rangeMap          [in]    row (and range) map
+    \param  domainMap         [in]    domain map
+    \param  numRowEnts        [in]    number of local row entities
+    \param  rowIsOwned        [in]    ownership flag for each local row entity
+    \param  rowToCol          [in]    local column entities of each row entity
+                                      (numRowEnts x entriesPerRow)
+    \param  vals              [in]    value of each entry, row-major
+                                      (numRowEnts x entriesPerRow)
+    \param  numColEnts        [in]    number of local column entities
+    \param  colIsOwned        [in]    ownership flag for each local column entity
+    \param  colGIDs           [in]    global id of each local column entity
+
+    \return fill-complete incidence matrix with optimized storage
+ */
+inline Teuchos::RCP<Epetra_CrsMatrix>
+LSFEM_BuildIncidence(const Epetra_Map & rangeMap, const Epetra_Map & domainMap,
+                     int numRowEnts, const bool * rowIsOwned,
+                     const Intrepid::FieldContainer<int> & rowToCol,
+                     const double * vals,
+                     int numColEnts, const bool * colIsOwned,
+                     const long long * colGIDs)
+{
+  const int entriesPerRow = rowToCol.dimension(1);
+
+ // Local column ids: owned columns first (domain map order), then ghosts
+  std::vector<int> colLID(numColEnts, -1);
+  std::vector<LSFEM_GO> colMapGIDs;
+  colMapGIDs.reserve(domainMap.NumMyElements());
+  for (int c=0; c<numColEnts; c++) {
+    if (colIsOwned[c]) {
+      colLID[c] = (int)colMapGIDs.size();
+      colMapGIDs.push_back((LSFEM_GO)colGIDs[c]);
+    }
+  }
+  TEUCHOS_TEST_FOR_EXCEPTION((int)colMapGIDs.size() != domainMap.NumMyElements(),
+    std::logic_error, "LSFEM_BuildIncidence: owned columns do not match the domain map");
+
+  int numMyRows = 0;
+  for (int r=0; r<numRowEnts; r++) {
+    if (!rowIsOwned[r]) continue;
+    numMyRows++;
+    for (int m=0; m<entriesPerRow; m++) {
+      int c = rowToCol(r,m);
+      if (colLID[c] < 0) {
+        colLID[c] = (int)colMapGIDs.size();
+        colMapGIDs.push_back((LSFEM_GO)colGIDs[c]);
+      }
+    }
+  }
+  TEUCHOS_TEST_FOR_EXCEPTION(numMyRows != rangeMap.NumMyElements(),
+    std::logic_error, "LSFEM_BuildIncidence: owned rows do not match the range map");
+
+  Epetra_Map colMap((LSFEM_GO)-1, (int)colMapGIDs.size(),
+                    colMapGIDs.size() ? &colMapGIDs[0] : 0, (LSFEM_GO)0, rangeMap.Comm());
+
+ // Fill the CRS arrays directly, with sorted column indices in each row
+  Teuchos::RCP<Epetra_CrsMatrix> A = Teuchos::rcp(new Epetra_CrsMatrix(Copy, rangeMap, colMap, 0));
+  A->ExpertMakeUniqueCrsGraphData();
+
+  const int nnz = numMyRows*entriesPerRow;
+  Epetra_IntSerialDenseVector & rowPtr = A->ExpertExtractIndexOffset();
+  Epetra_IntSerialDenseVector & colInd = A->ExpertExtractIndices();
+  double *& values = A->ExpertExtractValues();
+  rowPtr.Resize(numMyRows+1);
+  colInd.Resize(nnz);
+  delete [] values;
+  values = new double[nnz];
+
+  rowPtr[0] = 0;
+  for (int r=0, row=0; r<numRowEnts; r++) {
+    if (!rowIsOwned[r]) continue;
+    int begin = row*entriesPerRow;
+    for (int m=0; m<entriesPerRow; m++) {
+      int    col = colLID[rowToCol(r,m)];
+      double val = vals[r*entriesPerRow+m];
+      int k = begin + m;
+      while (k > begin && colInd[k-1] > col) {
+        colInd[k] = colInd[k-1];
+        values[k] = values[k-1];
+        k--;
+      }
+      colInd[k] = col;
+      values[k] = val;
+    }
+    rowPtr[++row] = begin + entriesPerRow;
+  }
+
+  A->ExpertStaticFillComplete(domainMap, rangeMap);
+
+  return A;
+}
+
+#endif
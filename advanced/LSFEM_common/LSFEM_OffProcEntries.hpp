@@ -0,0 +1,80 @@
+// @HEADER
+// ************************************************************************
+//
+//                           Intrepid Package
+//                 Copyright (2007) Sandia Corporation
+//
+// Under terms of Contract DE-AC04-94AL85000, there is a non-exclusive
+// license for use of this work by or on behalf of the U.S. Government.
+//
+// This library is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation; either version 2.1 of the
+// License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+// USA
+//
+// ************************************************************************
+// @HEADER
+
+/** \file   LSFEM_OffProcEntries.hpp
+    \brief  Count of the matrix entries Epetra_FECrsMatrix::GlobalAssemble()
+            sends to other processors.
+
+    Contributions to rows owned by another processor are buffered by the
+    FE matrix, and repeated contributions to the same (row, column) entry
+    are summed there before GlobalAssemble() exports them.  Counting every
+    SumInto/InsertGlobalValues call overstates the traffic by the number of
+    elements sharing an entry; this class records the (row, column) pairs
+    and counts them after merging.
+ **/
+
+#ifndef LSFEM_OFFPROCENTRIES_HPP
+#define LSFEM_OFFPROCENTRIES_HPP
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <algorithm>
+
+#include "LSFEM_GlobalOrdinal.hpp"
+
+
+class LSFEM_OffProcEntries {
+
+ public:
+
+  //! Record a contribution to entry (row, col) of a row owned elsewhere
+  void Add(LSFEM_GO row, LSFEM_GO col) {entries_.push_back(std::make_pair(row, col));}
+
+  //! Merge repeated contributions, as the FE matrix does
+  void Merge() {
+    std::sort(entries_.begin(), entries_.end());
+    entries_.erase(std::unique(entries_.begin(), entries_.end()), entries_.end());
+  }
+
+  //! Number of distinct entries (after Merge())
+  int NumEntries() const {return((int)entries_.size());}
+
+  //! Number of distinct rows (after Merge())
+  int NumRows() const {
+    int numRows = 0;
+    for (std::size_t k=0; k<entries_.size(); k++)
+      if (k == 0 || entries_[k].first != entries_[k-1].first) numRows++;
+    return(numRows);
+  }
+
+ private:
+
+  std::vector<std::pair<LSFEM_GO,LSFEM_GO> > entries_;
+};
+
+#endif
@@ -0,0 +1,228 @@
+// @HEADER
+// ************************************************************************
+//
+//                           Intrepid Package
+//                 Copyright (2007) Sandia Corporation
+//
+// Under terms of Contract DE-AC04-94AL85000, there is a non-exclusive
+// license for use of this work by or on behalf of the U.S. Government.
+//
+// This library is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as
+// published by the Free Software Foundation; either version 2.1 of the
+// License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+// USA
+//
+// ************************************************************************
+// @HEADER
+
+/** \file   LSFEM_ScatterPlan.hpp
+    \brief  Precomputed scatter of element matrices into a fill-complete
+            Epetra_CrsMatrix.
+
+    Once the matrix graph is fixed, every entry (element, local row, local
+    col) of an element matrix lands at a fixed position of the CRS value
+    array.  LSFEM_ScatterPlan looks these positions up once, so re-assembly
+    in Newton or time-stepping loops is a plain
+
+    \verbatim
+      values[offset[k]] += elementMatrix[k]
+    \endverbatim
+
+    pass with no global-to-local translation and no row searches.
+
+    Elements are greedily colored so that no two elements of the same color
+    share a locally owned row; elements of one color are scattered in
+    parallel when OpenMP is enabled.
+
+    Rows that are not owned by this processor get offset -1 and are skipped,
+    so the plan is meant for owner computes assembly (see
+    LSFEM_ElementList::ExchangeHalo), where every processor computes all
+    elements touching its rows.
+ **/
+
+#ifndef LSFEM_SCATTERPLAN_HPP
+#define LSFEM_SCATTERPLAN_HPP
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+
+#include "Teuchos_TestForException.hpp"
+#include "Epetra_BlockMap.h"
+#include "Epetra_CrsMatrix.h"
+
+
+class LSFEM_ScatterPlan {
+
+ public:
+
+  /** \brief Build the plan for a fill-complete, storage optimized matrix.
+
+      \param  A                 [in]    matrix whose graph has been fixed
+      \param  numElems          [in]    number of elements
+      \param  numDofsPerElem    [in]    degrees of freedom per element
+      \param  elemDofGIDs       [in]    global dof ids, element-major
+                                        (numElems x numDofsPerElem)
+   */
+  LSFEM_ScatterPlan(const Epetra_CrsMatrix & A, int numElems, int numDofsPerElem,
+                    const long long * elemDofGIDs)
+    : numElems_(numElems), numDofs_(numDofsPerElem), numSkipped_(0)
+  {
+    // Entry positions are formed in std::size_t: numElems x numDofs^2
+    // overflows int long before the matrix itself does
+    const std::size_t nn = (std::size_t)numDofs_*numDofs_;
+    offsets_.assign(numElems_*nn, -1);
+
+    int * indexOffset; int * indices; double * values;
+    TEUCHOS_TEST_FOR_EXCEPTION(A.ExtractCrsDataPointers(indexOffset, indices, values) != 0,
+      std::logic_error, "LSFEM_ScatterPlan: matrix must be fill-complete with optimized storage");
+
+    const Epetra_BlockMap & rowMap = A.RowMap();
+    const Epetra_BlockMap & colMap = A.ColMap();
+    std::vector<int> rowLIDs(numDofs_), colLIDs(numDofs_);
+
+   // Offsets into the CRS value array
+    for (int e=0; e<numElems_; e++) {
+      const long long * dofs = &elemDofGIDs[(std::size_t)e*numDofs_];
+      for (int i=0; i<numDofs_; i++) {
+        rowLIDs[i] = LID(rowMap, dofs[i]);
+        colLIDs[i] = LID(colMap, dofs[i]);
+      }
+      for (int i=0; i<numDofs_; i++) {
+        if (rowLIDs[i] < 0) {numSkipped_ += numDofs_; continue;}
+        int rowBegin = indexOffset[rowLIDs[i]];
+        int rowEnd   = indexOffset[rowLIDs[i]+1];
+        int * rowOffsets = &offsets_[e*nn + (std::size_t)i*numDofs_];
+        for (int j=0; j<numDofs_; j++) {
+          for (int k=rowBegin; k<rowEnd; k++) {
+            if (indices[k] == colLIDs[j]) {rowOffsets[j] = k; break;}
+          }
+          TEUCHOS_TEST_FOR_EXCEPTION(rowOffsets[j] < 0, std::logic_error,
+            "LSFEM_ScatterPlan: element entry is not in the matrix graph");
+        }
+      }
+    }
+
+   // Greedy coloring: elements sharing an owned row get different colors
+    std::vector<std::vector<int> > rowColors(rowMap.NumMyElements());
+    std::vector<int> elemColor(numElems_);
+    std::vector<bool> used;
+    int numColors = 0;
+    for (int e=0; e<numElems_; e++) {
+      used.assign(numColors+1, false);
+      const long long * dofs = &elemDofGIDs[(std::size_t)e*numDofs_];
+      for (int i=0; i<numDofs_; i++) {
+        int lid = LID(rowMap, dofs[i]);
+        if (lid < 0) continue;
+        for (unsigned c=0; c<rowColors[lid].size(); c++) used[rowColors[lid][c]] = true;
+      }
+      int color = 0;
+      while (used[color]) color++;
+      if (color == numColors) numColors++;
+      elemColor[e] = color;
+      for (int i=0; i<numDofs_; i++) {
+        int lid = LID(rowMap, dofs[i]);
+        if (lid >= 0) rowColors[lid].push_back(color);
+      }
+    }
+
+   // Group elements by color
+    colorPtr_.assign(numColors+1, 0);
+    for (int e=0; e<numElems_; e++) colorPtr_[elemColor[e]+1]++;
+    for (int c=0; c<numColors; c++) colorPtr_[c+1] += colorPtr_[c];
+    colorElems_.resize(numElems_);
+    std::vector<int> next(colorPtr_.begin(), colorPtr_.end()-1);
+    for (int e=0; e<numElems_; e++) colorElems_[next[elemColor[e]]++] = e;
+  }
+
+  //! Number of element colors
+  int NumColors() const {return (int)colorPtr_.size() - 1;}
+
+  //! Number of element matrix entries in rows owned by other processors
+  long long NumSkipped() const {return numSkipped_;}
+
+  /** \brief Sum element matrices into the values of \c A.
+
+      \param  elemMats   [in]      element matrices, element-major
+                                   (numElems x numDofsPerElem x numDofsPerElem)
+      \param  A          [in/out]  matrix the plan was built for (or one with an
+                                   identical graph)
+
+      Values are added to what is already in \c A; call A.PutScalar(0.0)
+      first for a fresh assembly.
+   */
+  void Assemble(const double * elemMats, Epetra_CrsMatrix & A) const
+  {
+    int * indexOffset; int * indices; double * values;
+    A.ExtractCrsDataPointers(indexOffset, indices, values);
+
+    const std::size_t nn = (std::size_t)numDofs_*numDofs_;
+    for (int c=0; c<NumColors(); c++) {
+      const int colorBegin = colorPtr_[c];
+      const int colorEnd   = colorPtr_[c+1];
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+      for (int k=colorBegin; k<colorEnd; k++) {
+        const int e = colorElems_[k];
+        const int    * off = &offsets_[e*nn];
+        const double * Ke  = &elemMats[e*nn];
+        for (std::size_t m=0; m<nn; m++)
+          if (off[m] >= 0) values[off[m]] += Ke[m];
+      }
+    }
+  }
+
+  //! Copy of the CRS values of a fill-complete, storage optimized matrix
+  static std::vector<double> Values(const Epetra_CrsMatrix & A)
+  {
+    int * indexOffset; int * indices; double * values;
+    A.ExtractCrsDataPointers(indexOffset, indices, values);
+    return std::vector<double>(values, values + indexOffset[A.NumMyRows()]);
+  }
+
+  /** \brief Largest entrywise difference between \c A and values saved with
+             Values() from a matrix with the same graph (collective).
+   */
+  static double MaxDifference(const Epetra_CrsMatrix & A, const std::vector<double> & saved)
+  {
+    int * indexOffset; int * indices; double * values;
+    A.ExtractCrsDataPointers(indexOffset, indices, values);
+    double myDiff = 0.0, diff = 0.0;
+    for (int k=0; k<indexOffset[A.NumMyRows()]; k++)
+      myDiff = std::max(myDiff, std::abs(values[k] - saved[k]));
+    A.Comm().MaxAll(&myDiff, &diff, 1);
+    return diff;
+  }
+
+ private:
+
+  static int LID(const Epetra_BlockMap & map, long long gid) {
+#ifndef EPETRA_NO_64BIT_GLOBAL_INDICES
+    if (map.GlobalIndicesLongLong()) return map.LID(gid);
+#endif
+    return map.LID((int)gid);
+  }
+
+  int numElems_;
+  int numDofs_;
+  long long numSkipped_;
+
+  std::vector<int> offsets_;
+  std::vector<int> colorPtr_;
+  std::vector<int> colorElems_;
+};
+
+#endif
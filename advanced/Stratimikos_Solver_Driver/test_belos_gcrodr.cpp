@@ -6,6 +6,11 @@
 
 #include <string>
 #include <iostream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <unistd.h>
 
 #ifdef HAVE_MPI
    #include "Epetra_MpiComm.h"
@@ -33,6 +38,9 @@
 
 #include "Stratimikos_DefaultLinearSolverBuilder.hpp"
 
+#include "InitialGuessProjector.hpp"
+#include "RecycleSpace.hpp"
+
 using Teuchos::RCP;
 using Teuchos::rcp;
 
@@ -185,3 +193,206 @@ TEUCHOS_UNIT_TEST(belos_gcrodr, 2x2_multiple_solves)
    status = Thyra::solve<double>(*lows, Thyra::NOTRANS, *tb, tx0.ptr());
    status = Thyra::solve<double>(*lows, Thyra::NOTRANS, *tb, tx1.ptr());
 }
+
+// Iteration count reported by the Belos adapter (-1 if not available)
+static int getIterationCount(const Thyra::SolveStatus<double> & status)
+{
+   if(Teuchos::nonnull(status.extraParameters) && status.extraParameters->isParameter("Belos/Iteration Count"))
+      return status.extraParameters->get<int>("Belos/Iteration Count");
+   return -1;
+}
+
+TEUCHOS_UNIT_TEST(belos_gcrodr, projected_initial_guess)
+{
+   // build global (or serial communicator)
+   #ifdef HAVE_MPI
+      Epetra_MpiComm Comm(MPI_COMM_WORLD);
+   #else
+      Epetra_SerialComm Comm;
+   #endif
+
+   // build and allocate linear system
+   Teuchos::RCP<Epetra_CrsMatrix> mat = buildMatrix(100,Comm);
+   Teuchos::RCP<Epetra_Vector> x = rcp(new Epetra_Vector(mat->OperatorDomainMap()));
+   Teuchos::RCP<Epetra_Vector> b = rcp(new Epetra_Vector(mat->OperatorRangeMap()));
+   Epetra_Vector u(mat->OperatorDomainMap());
+   Epetra_Vector v(mat->OperatorDomainMap());
+   u.Random();
+
+   // build Thyra wrappers
+   RCP<const Thyra::LinearOpBase<double> >
+      tA = Thyra::epetraLinearOp( mat );
+   RCP<Thyra::VectorBase<double> >
+      tx = Thyra::create_Vector( x, tA->domain() );
+   RCP<const Thyra::VectorBase<double> >
+      tb = Thyra::create_Vector( b, tA->range() );
+
+   // now comes Stratimikos; converge relative to ||b|| so a good initial
+   // guess shows up as fewer iterations
+   RCP<Teuchos::ParameterList> paramList = Teuchos::getParametersFromXmlFile("BelosGCRODRTest.xml");
+   Teuchos::ParameterList & gcrodrList = paramList->sublist("Linear Solver Types").sublist("Belos")
+                                                   .sublist("Solver Types").sublist("GCRODR");
+   gcrodrList.set("Implicit Residual Scaling","Norm of RHS");
+   gcrodrList.set("Explicit Residual Scaling","Norm of RHS");
+   Stratimikos::DefaultLinearSolverBuilder linearSolverBuilder;
+   linearSolverBuilder.setParameterList(paramList);
+
+   RCP<Thyra::LinearOpWithSolveFactoryBase<double> > lowsFactory =
+         linearSolverBuilder.createLinearSolveStrategy("");
+
+   // one solver started from zero, one from the projected initial guess
+   RCP<Thyra::LinearOpWithSolveBase<double> > lowsZero =
+         Thyra::linearOpWithSolve(*lowsFactory, tA);
+   RCP<Thyra::LinearOpWithSolveBase<double> > lowsProj =
+         Thyra::linearOpWithSolve(*lowsFactory, tA);
+
+   InitialGuessProjector projector(mat->OperatorDomainMap(), 5);
+
+   // solve a sequence of systems whose solutions are small perturbations of u
+   int numSolves = 6;
+   int totalZero = 0, totalProj = 0;
+   Thyra::SolveStatus<double> status;
+   for(int k=0;k<numSolves;k++) {
+      v.Random();
+      v.Update(1.0,u,1.0e-2);
+      mat->Apply(v,*b);
+
+      x->PutScalar(0.0);
+      status = Thyra::solve<double>(*lowsZero, Thyra::NOTRANS, *tb, tx.ptr());
+      int itersZero = getIterationCount(status);
+
+      projector.ComputeInitialGuess(*b,*x);
+      status = Thyra::solve<double>(*lowsProj, Thyra::NOTRANS, *tb, tx.ptr());
+      int itersProj = getIterationCount(status);
+      projector.AddSolution(*mat,*x);
+
+      out << "solve " << k << ": iterations " << itersZero << " (zero guess), "
+          << itersProj << " (projected guess)" << std::endl;
+      totalZero += itersZero;
+      totalProj += itersProj;
+   }
+
+   out << "total iterations saved by projection: " << totalZero-totalProj << std::endl;
+   TEST_ASSERT(totalProj <= totalZero);
+}
+
+TEUCHOS_UNIT_TEST(belos_gcrodr, persisted_recycle_space)
+{
+   // build global (or serial communicator)
+   #ifdef HAVE_MPI
+      Epetra_MpiComm Comm(MPI_COMM_WORLD);
+   #else
+      Epetra_SerialComm Comm;
+   #endif
+
+   // build and allocate linear system
+   Teuchos::RCP<Epetra_CrsMatrix> mat = buildMatrix(100,Comm);
+   const Epetra_Map & map = mat->OperatorDomainMap();
+   Teuchos::RCP<Epetra_Vector> x = rcp(new Epetra_Vector(map));
+   Teuchos::RCP<Epetra_Vector> y = rcp(new Epetra_Vector(map));
+   Teuchos::RCP<Epetra_Vector> b = rcp(new Epetra_Vector(map));
+   Teuchos::RCP<Epetra_Vector> r = rcp(new Epetra_Vector(map));
+
+   // build Thyra wrappers
+   RCP<const Thyra::LinearOpBase<double> >
+      tA = Thyra::epetraLinearOp( mat );
+   RCP<Thyra::VectorBase<double> >
+      tx = Thyra::create_Vector( x, tA->domain() );
+   RCP<const Thyra::VectorBase<double> >
+      tb = Thyra::create_Vector( b, tA->range() );
+
+   // converge relative to ||b||, as for the projected initial guess
+   RCP<Teuchos::ParameterList> paramList = Teuchos::getParametersFromXmlFile("BelosGCRODRTest.xml");
+   Teuchos::ParameterList & gcrodrList = paramList->sublist("Linear Solver Types").sublist("Belos")
+                                                   .sublist("Solver Types").sublist("GCRODR");
+   gcrodrList.set("Implicit Residual Scaling","Norm of RHS");
+   gcrodrList.set("Explicit Residual Scaling","Norm of RHS");
+   Stratimikos::DefaultLinearSolverBuilder linearSolverBuilder;
+   linearSolverBuilder.setParameterList(paramList);
+
+   RCP<Thyra::LinearOpWithSolveFactoryBase<double> > lowsFactory =
+         linearSolverBuilder.createLinearSolveStrategy("");
+   Thyra::SolveStatus<double> status;
+
+   // recycle space files go to the temporary directory, under a name unique
+   // to this run (the process id of rank 0)
+   int pid = (int)getpid();
+   Comm.Broadcast(&pid,1,0);
+   std::ostringstream recycleFile;
+   recycleFile << (std::getenv("TMPDIR") ? std::getenv("TMPDIR") : "/tmp")
+               << "/gcrodr_recycle_" << pid;
+
+   // "Run 1": cold solve, then save the recycle space for the next run
+   {
+      b->Random();
+      x->PutScalar(0.0);
+      RCP<Thyra::LinearOpWithSolveBase<double> > lows =
+            Thyra::linearOpWithSolve(*lowsFactory, tA);
+      status = Thyra::solve<double>(*lows, Thyra::NOTRANS, *tb, tx.ptr());
+      out << "run 1: iterations " << getIterationCount(status) << " (cold)" << std::endl;
+
+      RecycleSpace space(map);
+      TEST_EQUALITY(space.Compute(*mat,*b,5,40),0);
+      TEST_EQUALITY(space.Write(recycleFile.str()),0);
+   }
+
+   // "Run 2": reload the space and warm start the first solve of a new right hand side
+   b->Random();
+
+   x->PutScalar(0.0);
+   RCP<Thyra::LinearOpWithSolveBase<double> > lowsCold =
+         Thyra::linearOpWithSolve(*lowsFactory, tA);
+   status = Thyra::solve<double>(*lowsCold, Thyra::NOTRANS, *tb, tx.ptr());
+   int itersCold = getIterationCount(status);
+
+   RCP<RecycleSpace> space = rcp(new RecycleSpace(map));
+   TEST_EQUALITY(space->Read(recycleFile.str()),0);
+   out << "recycle space of " << space->NumVectors() << " vectors read" << std::endl;
+
+   // x0 = U C^T b, solve (I - C C^T) A y = b - A x0, then correct x
+   space->InitialGuess(*b,*x);
+   mat->Apply(*x,*r);
+   r->Update(1.0,*b,-1.0);
+   y->PutScalar(0.0);
+   RCP<const Thyra::LinearOpBase<double> >
+      tPA = Thyra::epetraLinearOp( rcp(new RecycleSpace::DeflatedOperator(mat,space)) );
+   RCP<Thyra::VectorBase<double> >
+      ty = Thyra::create_Vector( y, tPA->domain() );
+   RCP<const Thyra::VectorBase<double> >
+      tr = Thyra::create_Vector( r, tPA->range() );
+   RCP<Thyra::LinearOpWithSolveBase<double> > lowsWarm =
+         Thyra::linearOpWithSolve(*lowsFactory, tPA);
+   status = Thyra::solve<double>(*lowsWarm, Thyra::NOTRANS, *tr, ty.ptr());
+   int itersWarm = getIterationCount(status);
+   space->Correct(*mat,*y,*x);
+
+   // the corrected solution must solve the original system
+   double bnorm, rnorm;
+   mat->Apply(*x,*r);
+   r->Update(1.0,*b,-1.0);
+   r->Norm2(&rnorm);
+   b->Norm2(&bnorm);
+
+   out << "run 2: iterations " << itersCold << " (cold), " << itersWarm
+       << " (recycled), saved " << itersCold-itersWarm << std::endl;
+   TEST_ASSERT(itersWarm <= itersCold);
+   TEST_ASSERT(rnorm <= 1.0e-4*bnorm);
+
+   // a space saved for another map is rejected: other length ...
+   Teuchos::RCP<Epetra_CrsMatrix> other = buildMatrix(50,Comm);
+   RecycleSpace otherSpace(other->OperatorDomainMap());
+   TEST_EQUALITY(otherSpace.Read(recycleFile.str()),-2);
+   TEST_EQUALITY(otherSpace.NumVectors(),0);
+
+   // ... or same length and distribution, but other global ids (each
+   // process's ids in reverse order)
+   std::vector<int> reversedGIDs(map.MyGlobalElements(), map.MyGlobalElements()+map.NumMyElements());
+   std::reverse(reversedGIDs.begin(), reversedGIDs.end());
+   Epetra_Map reversedMap(map.NumGlobalElements(), map.NumMyElements(),
+                          reversedGIDs.empty() ? 0 : &reversedGIDs[0], 0, Comm);
+   RecycleSpace reversedSpace(reversedMap);
+   TEST_EQUALITY(reversedSpace.Read(recycleFile.str()),-2);
+   TEST_EQUALITY(reversedSpace.NumVectors(),0);
+
+   TEST_EQUALITY(space->Remove(recycleFile.str()),0);
+}
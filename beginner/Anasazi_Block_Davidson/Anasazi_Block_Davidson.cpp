@@ -17,6 +17,9 @@
 // The Trilinos package Galeri has many example problems.
 #include "Galeri_Maps.h"
 #include "Galeri_CrsMatrices.h"
+#include "Epetra_Vector.h"
+// Warm-started solves along a parameter sweep
+#include "EigenSweep.hpp"
 // Include selected communicator class required by Epetra objects
 #ifdef EPETRA_MPI
 #  include "Epetra_MpiComm.h"
@@ -178,6 +181,23 @@ main (int argc, char *argv[])
     cout << "------------------------------------------------------" << endl;
   }
 
+  // Parameter sweep: A(t) = A + t V, where V = diag(x) is a potential
+  // growing along the x direction, for t = 0, dt, ..., (numSteps-1)*dt.
+  // Each step is solved once from random vectors and once from the
+  // eigenvectors of the previous step, and the work of both is compared.
+  const int numSteps = 6;
+  const double dt = 0.1;
+  RCP<Epetra_CrsMatrix> L = Teuchos::rcp_dynamic_cast<Epetra_CrsMatrix> (A);
+  Epetra_Vector potential (*Map);
+  for (int i=0; i<Map->NumMyElements (); ++i) {
+    potential[i] = static_cast<double> (Map->GID (i) % nx) / (nx - 1);
+  }
+  Teuchos::ParameterList sweepPL (anasaziPL);
+  sweepPL.set ("Verbosity", Anasazi::Errors + Anasazi::Warnings);
+  DiagonalShift sweepOperator (L, potential);
+  CompareWarmStart<Anasazi::BlockDavidsonSolMgr<double, MV, OP> > (sweepPL, nev, sweepOperator, numSteps, dt,
+                                                                   "eigenvectors", true);
+
 #ifdef EPETRA_MPI
   MPI_Finalize () ;
 #endif // EPETRA_MPI
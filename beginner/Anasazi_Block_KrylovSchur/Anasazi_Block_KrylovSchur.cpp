@@ -36,8 +36,11 @@
 #  include "Epetra_SerialComm.h"
 #endif
 #include "Epetra_Map.h"
+#include "Epetra_Vector.h"
 
 #include "../../aprepro_vhelp.h"
+// Warm-started solves along a parameter sweep
+#include "EigenSweep.hpp"
 //
 // Use Block Krylov-Schur iteration on A^T (A x) = (sigma)^2 x to
 // compute the approximate SVD of A.
@@ -96,6 +99,32 @@ buildSparseMatrix (const Epetra_Comm& Comm,
                    const int m, 
                    const int n);
 
+//
+// Operators A(t)^T A(t) of the parameter sweep in main(), where
+// A(t) = A D(t) and D(t) = diag(1 + t j/n) scales the columns of A.
+//
+class ColumnScalingSweep {
+public:
+  ColumnScalingSweep (const Teuchos::RCP<const Epetra_CrsMatrix>& A, const int n) :
+    A_ (A), n_ (n)
+  {}
+
+  Teuchos::RCP<const Epetra_Operator> operator() (const double t) const {
+    const Epetra_Map& ColMap = A_->DomainMap ();
+    Epetra_Vector scaling (ColMap);
+    for (int j = 0; j < ColMap.NumMyElements (); ++j) {
+      scaling[j] = 1.0 + t * ColMap.GID (j) / n_;
+    }
+    Teuchos::RCP<Epetra_CrsMatrix> At = Teuchos::rcp (new Epetra_CrsMatrix (*A_));
+    At->RightScale (scaling);
+    return Teuchos::rcp (new Anasazi::EpetraSymOp (At));
+  }
+
+private:
+  Teuchos::RCP<const Epetra_CrsMatrix> A_;
+  int n_;
+};
+
 //
 // The "main" driver routine.
 //
@@ -256,6 +285,24 @@ main (int argc, char *argv[])
       }
     }
 
+  // Parameter sweep: A(t) = A D(t), with D(t) = diag(1 + t j/n) scaling
+  // the columns, for t = 0, dt, ..., (numSteps-1)*dt.  The singular values
+  // of each A(t) are computed once from a random block and once from the
+  // right singular vectors of the previous step.  The block size is the
+  // number of singular values, so that Krylov-Schur, which only uses the
+  // first block of initial vectors, is started from all of them.
+  {
+    const int numSteps = 6;
+    const double dt = 0.1;
+    RCP<ParameterList> sweepPL = getParameterList (numSingularValues);
+    sweepPL->set ("Convergence Tolerance", 1.0e-10);
+    sweepPL->set ("Verbosity", Anasazi::Errors + Anasazi::Warnings);
+    typedef Anasazi::BlockKrylovSchurSolMgr<double, Epetra_MultiVector, Epetra_Operator> SolMgr;
+    ColumnScalingSweep sweepOperator (A, n);
+    CompareWarmStart<SolMgr> (*sweepPL, numSingularValues, sweepOperator, numSteps, dt,
+                              "singular vectors", true);
+  }
+
 #ifdef EPETRA_MPI
   MPI_Finalize() ;
 #endif
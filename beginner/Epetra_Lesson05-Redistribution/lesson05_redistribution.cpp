@@ -21,12 +21,17 @@
 #include <Epetra_CrsMatrix.h>
 #include <Epetra_Export.h>
 #include <Epetra_Map.h>
+#include <Epetra_Time.h>
 #include <Epetra_Vector.h>
 #include <Epetra_Version.h>
 
+#include <cmath>
+#include <cstdlib>
 #include <sstream>
 #include <stdexcept>
 
+#include "Epetra_ChunkedMigration.hpp"
+
 
 // The type of global indices.  You could just set this to int,
 // but we want the example to work for Epetra64 as well.
@@ -49,17 +54,15 @@ typedef long long global_ordinal_type;
 #endif // EPETRA_NO_32BIT_GLOBAL_INDICES
 
 
-// Create and return a pointer to an example CrsMatrix, with row
-// distribution over the given Map.  The caller is responsible for
-// freeing the result.
-Epetra_CrsMatrix*
-createCrsMatrix (const Epetra_Map& map)
+// Insert the rows of the example matrix that the given Map puts on
+// this process into sink, one row at a time.  The sink is either an
+// Epetra_CrsMatrix or an Epetra_ChunkedMigration; both have an
+// InsertGlobalValues method with the same arguments.  Returns the
+// first nonzero error code of the insertions.
+template<class RowSinkType>
+int
+insertRows (const Epetra_Map& map, RowSinkType& sink)
 {
-  const Epetra_Comm& comm = map.Comm ();
-
-  // Create an Epetra_CrsMatrix using the Map, with dynamic allocation.
-  Epetra_CrsMatrix* A = new Epetra_CrsMatrix (Copy, map, 3);
-
   // The list of global indices owned by this MPI process.
 
   const global_ordinal_type* myGblElts = NULL;
@@ -86,7 +89,6 @@ createCrsMatrix (const Epetra_Map& map)
   // Local error code for use below.
   int lclerr = 0;
 
-  // Fill the sparse matrix, one row at a time.
   double tempVals[3];
   global_ordinal_type tempGblInds[3];
   for (int i = 0; i < numMyElts; ++i) {
@@ -97,7 +99,7 @@ createCrsMatrix (const Epetra_Map& map)
       tempGblInds[0] = myGblElts[i];
       tempGblInds[1] = myGblElts[i] + 1;
       if (lclerr == 0) {
-        lclerr = A->InsertGlobalValues (myGblElts[i], 2, tempVals, tempGblInds);
+        lclerr = sink.InsertGlobalValues (myGblElts[i], 2, tempVals, tempGblInds);
       }
       if (lclerr != 0) {
         break;
@@ -110,7 +112,7 @@ createCrsMatrix (const Epetra_Map& map)
       tempGblInds[0] = myGblElts[i] - 1;
       tempGblInds[1] = myGblElts[i];
       if (lclerr == 0) {
-        lclerr = A->InsertGlobalValues (myGblElts[i], 2, tempVals, tempGblInds);
+        lclerr = sink.InsertGlobalValues (myGblElts[i], 2, tempVals, tempGblInds);
       }
       if (lclerr != 0) {
         break;
@@ -125,7 +127,7 @@ createCrsMatrix (const Epetra_Map& map)
       tempGblInds[1] = myGblElts[i];
       tempGblInds[2] = myGblElts[i] + 1;
       if (lclerr == 0) {
-        lclerr = A->InsertGlobalValues (myGblElts[i], 3, tempVals, tempGblInds);
+        lclerr = sink.InsertGlobalValues (myGblElts[i], 3, tempVals, tempGblInds);
       }
       if (lclerr != 0) {
         break;
@@ -133,6 +135,24 @@ createCrsMatrix (const Epetra_Map& map)
     }
   }
 
+  return lclerr;
+}
+
+
+// Create and return a pointer to an example CrsMatrix, with row
+// distribution over the given Map.  The caller is responsible for
+// freeing the result.
+Epetra_CrsMatrix*
+createCrsMatrix (const Epetra_Map& map)
+{
+  const Epetra_Comm& comm = map.Comm ();
+
+  // Create an Epetra_CrsMatrix using the Map, with dynamic allocation.
+  Epetra_CrsMatrix* A = new Epetra_CrsMatrix (Copy, map, 3);
+
+  // Fill the sparse matrix, one row at a time.
+  int lclerr = insertRows (map, *A);
+
   // If any process failed to insert at least one entry, throw.
   int gblerr = 0;
   (void) comm.MaxAll (&lclerr, &gblerr, 1);
@@ -158,13 +178,72 @@ createCrsMatrix (const Epetra_Map& map)
 }
 
 
+// Build the same matrix as createCrsMatrix (sourceMap), but stage its
+// rows in an Epetra_ChunkedMigration instead of a CrsMatrix, and move
+// them to targetMap in chunks of at most chunkRows rows per process.
+// Each chunk of staged rows is freed as soon as it has been sent, so
+// the whole matrix never exists twice, and the communication buffers
+// only ever hold one chunk.  The caller is responsible for freeing the
+// result.
+Epetra_CrsMatrix*
+redistributeInChunks (const Epetra_Map& sourceMap,
+                      const Epetra_Map& targetMap,
+                      const int chunkRows)
+{
+  const Epetra_Comm& comm = sourceMap.Comm ();
+  Epetra_ChunkedMigration<global_ordinal_type> migration (comm, chunkRows);
+
+  int lclerr = (insertRows (sourceMap, migration) == 0) ? 0 : 1;
+  int gblerr = 0;
+  (void) comm.MaxAll (&lclerr, &gblerr, 1);
+  if (gblerr != 0) {
+    throw std::runtime_error ("Some process failed to stage an entry.");
+  }
+
+  // Migrate() has collective semantics and returns the same error
+  // code on all processes.  The result is already fill complete.
+  Epetra_CrsMatrix* B = NULL;
+  gblerr = migration.Migrate (targetMap, B);
+  if (gblerr != 0) {
+    std::ostringstream os;
+    os << "Migrate() failed with error code " << gblerr << ".";
+    throw std::runtime_error (os.str ());
+  }
+  return B;
+}
+
+
+// Make sure that B is the example matrix with numGblElts rows: it
+// must be fill complete, with 3*numGblElts - 2 entries, whose squares
+// sum to 4*numGblElts + 2*(numGblElts - 1).
+void
+checkMatrix (const Epetra_CrsMatrix& B, const global_ordinal_type numGblElts)
+{
+#ifdef EXAMPLE_USES_64BIT_GLOBAL_INDICES
+  const global_ordinal_type numGblEnt = B.NumGlobalNonzeros64 ();
+#else
+  const global_ordinal_type numGblEnt = B.NumGlobalNonzeros ();
+#endif // EXAMPLE_USES_64BIT_GLOBAL_INDICES
+  const double normF = B.NormFrobenius ();
+  const double expectedNormF = std::sqrt (6.0 * numGblElts - 2.0);
+
+  if (! B.Filled () || numGblEnt != 3 * numGblElts - 2 ||
+      std::fabs (normF - expectedNormF) > 1.0e-12 * expectedNormF) {
+    throw std::runtime_error ("The redistributed matrix differs from the "
+                              "original.");
+  }
+}
+
+
 void
-example (const Epetra_Comm& comm)
+example (const Epetra_Comm& comm, const int numLclRows, const int chunkRows)
 {
   // The global number of rows in the matrix A to create.  We scale
   // this relative to the number of (MPI) processes, so that no matter
-  // how many MPI processes you run, every process will have 10 rows.
-  const global_ordinal_type numGblElts = 10 * comm.NumProc ();
+  // how many MPI processes you run, every process will have
+  // numLclRows rows (10 by default).
+  const global_ordinal_type numGblElts =
+    static_cast<global_ordinal_type> (numLclRows) * comm.NumProc ();
   // The global min global index in all the Maps here.
   const global_ordinal_type indexBase = 0;
 
@@ -197,6 +276,16 @@ example (const Epetra_Comm& comm)
   // equations on each processor.
   Epetra_Map globalMap (numGblElts, indexBase, comm);
 
+  // With chunkRows > 0, the matrix is never built on procZeroMap as a
+  // whole; its rows go to globalMap in chunks as they are generated.
+  if (chunkRows > 0) {
+    Epetra_CrsMatrix* B = redistributeInChunks (procZeroMap, globalMap,
+                                                chunkRows);
+    checkMatrix (*B, numGblElts);
+    delete B;
+    return;
+  }
+
   // Create a sparse matrix using procZeroMap.
   Epetra_CrsMatrix* A = createCrsMatrix (procZeroMap);
   if (A == NULL) {
@@ -282,6 +371,8 @@ example (const Epetra_Comm& comm)
     throw std::runtime_error ("B.FillComplete() failed on at least one process.");
   }
 
+  checkMatrix (B, numGblElts);
+
   if (A != NULL) {
     delete A;
   }
@@ -310,7 +401,34 @@ main (int argc, char *argv[])
          << "Total number of processes: " << numProcs << endl;
   }
 
-  example (comm); // Run the whole example.
+  // Usage: Epetra_lesson05_redistribution [rows per process [chunk rows]]
+  //
+  // With chunk rows > 0, the matrix is redistributed in chunks by
+  // Epetra_ChunkedMigration instead of by a single Export.  Peak memory
+  // is a property of the whole run, so compare the two in separate
+  // runs ("make bench").
+  const int numLclRows = (argc > 1) ? std::atoi (argv[1]) : 10;
+  const int chunkRows = (argc > 2) ? std::atoi (argv[2]) : 0;
+
+  Epetra_Time timer (comm);
+  example (comm, numLclRows, chunkRows); // Run the whole example.
+  const double elapsed = timer.ElapsedTime ();
+
+  // The process with the largest peak; with either method, that is
+  // Process 0, which creates the whole matrix.
+  double lclPeak = Epetra_ChunkedMigration<global_ordinal_type>::PeakRSS ();
+  double gblPeak = 0.0;
+  (void) comm.MaxAll (&lclPeak, &gblPeak, 1);
+  if (myRank == 0) {
+    cout << "Redistribution: ";
+    if (chunkRows > 0) {
+      cout << "chunks of " << chunkRows << " rows";
+    } else {
+      cout << "single Export";
+    }
+    cout << ", " << numLclRows << " rows per process, " << elapsed
+         << " s, peak RSS " << gblPeak / (1024.0 * 1024.0) << " MB" << endl;
+  }
 
   // This tells the Trilinos test framework that the test passed.
   if (myRank == 0) {
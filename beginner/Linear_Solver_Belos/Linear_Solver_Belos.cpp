@@ -9,7 +9,13 @@
 #include "Ifpack_AdditiveSchwarz.h"
 #include "BelosLinearProblem.hpp"
 #include "BelosBlockGmresSolMgr.hpp"
+#include "BelosPseudoBlockCGSolMgr.hpp"
 #include "BelosEpetraAdapter.hpp"
+#include "AnasaziLOBPCGSolMgr.hpp"
+#include "AnasaziBasicEigenproblem.hpp"
+#include "AnasaziEpetraAdapter.hpp"
+#include "Epetra_Time.h"
+#include <cstdlib>
 #ifdef HAVE_MPI
 #include "Epetra_MpiComm.h"
 #else
@@ -17,6 +23,8 @@
 #endif
 
 #include "../../aprepro_vhelp.h"
+#include "DeflationPreconditioner.hpp"
+#include "PolynomialPreconditioner.hpp"
 
 int
 main (int argc, char *argv[])
@@ -35,6 +43,16 @@ main (int argc, char *argv[])
 #endif
   const int myRank = Comm.MyPID();
 
+  // Usage: Linear_Solver_Belos [ILU|Chebyshev|GMRESPoly] [degree]
+  //
+  // selects the right preconditioner of GMRES.  Chebyshev and GMRESPoly
+  // are polynomial preconditioners (see PolynomialPreconditioner.hpp),
+  // applied with matvecs and vector updates only.
+  std::string GmresPrecType = "ILU";
+  int degree = 8;
+  if (argc > 1) GmresPrecType = argv[1];
+  if (argc > 2) degree = atoi (argv[2]);
+
   ParameterList GaleriList;
 
   // The problem is defined on a 2D grid, global size is nx * nx.
@@ -100,7 +118,23 @@ main (int argc, char *argv[])
   // Create the Belos preconditioned operator from the Ifpack preconditioner.
   // NOTE:  This is necessary because Belos expects an operator to apply the
   //        preconditioner with Apply() NOT ApplyInverse().
-  RCP<Belos::EpetraPrecOp> belosPrec = rcp (new Belos::EpetraPrecOp (Prec));
+  RCP<Belos::EpetraPrecOp> iluPrec = rcp (new Belos::EpetraPrecOp (Prec));
+
+  // Or use a polynomial preconditioner for GMRES.
+  Epetra_Time timer (Comm);
+  RCP<Belos::EpetraPrecOp> belosPrec = iluPrec;
+  if (GmresPrecType == "Chebyshev" || GmresPrecType == "GMRESPoly") {
+    PolynomialPreconditioner::Type polyType = (GmresPrecType == "Chebyshev") ?
+      PolynomialPreconditioner::Chebyshev : PolynomialPreconditioner::GmresPoly;
+    RCP<PolynomialPreconditioner> PolyPrec =
+      rcp (new PolynomialPreconditioner (A, polyType, degree));
+    IFPACK_CHK_ERR(PolyPrec->Compute ());
+    belosPrec = rcp (new Belos::EpetraPrecOp (PolyPrec));
+    if (myRank == 0) {
+      cout << "Using a " << PolyPrec->Label () << " preconditioner of degree " << degree
+           << " (setup " << timer.ElapsedTime () << " s)" << endl;
+    }
+  }
 
   // =================================================== //
   // E N D   O F   I F P A C K   C O N S T R U C T I O N //
@@ -154,7 +188,9 @@ main (int argc, char *argv[])
   Belos::BlockGmresSolMgr<double,MV,OP> belosSolver (problem, belosList);
 
   // Perform solve.
+  timer.ResetStartTime ();
   Belos::ReturnType ret = belosSolver.solve();
+  const double gmresTime = timer.ElapsedTime ();
 
   // Did we converge?
   if (myRank == 0) {
@@ -163,6 +199,98 @@ main (int argc, char *argv[])
     } else {
       std::cout << "Belos did not converge." << std::endl;
     }
+    std::cout << "GMRES with " << GmresPrecType << ": " << belosSolver.getNumIters ()
+              << " iterations in " << gmresTime << " s" << std::endl;
+  }
+
+  // =================================================================== //
+  // D E F L A T E D   C G   O V E R   M A N Y   R I G H T - H A N D   //
+  // S I D E S                                                          //
+  // =================================================================== //
+
+  // A is symmetric positive definite, so it can be solved with CG.
+  // CG's convergence is held back by the smallest eigenvalues of the
+  // preconditioned operator, which ILU does little about.  Compute
+  // approximations to the eigenvectors of the numEigs smallest
+  // eigenvalues of A once with Anasazi (as in the Anasazi_LOBPCG
+  // example, but asking for the smallest eigenvalues and a loose
+  // tolerance), and project them out of CG with a
+  // DeflationPreconditioner wrapped around the ILU preconditioner.
+  // The eigenvectors cost a setup time that pays off after enough
+  // right-hand sides.
+  const int numEigs = 8;
+  const int numRHS = 20;
+  timer.ResetStartTime ();
+
+  RCP<MV> eigInit = rcp (new MV (A->OperatorDomainMap (), 4));
+  eigInit->Random ();
+  RCP<Anasazi::BasicEigenproblem<double,MV,OP> > eigProblem =
+    rcp (new Anasazi::BasicEigenproblem<double,MV,OP> (A, eigInit));
+  eigProblem->setHermitian (true);
+  eigProblem->setNEV (numEigs);
+  eigProblem->setProblem ();
+
+  ParameterList anasaziList;
+  anasaziList.set ("Which", "SM");
+  anasaziList.set ("Block Size", 4);
+  anasaziList.set ("Maximum Iterations", 500);
+  anasaziList.set ("Convergence Tolerance", 1e-4);
+  anasaziList.set ("Use Locking", true);
+  anasaziList.set ("Verbosity", Anasazi::Errors + Anasazi::Warnings);
+  Anasazi::LOBPCGSolMgr<double,MV,OP> eigSolver (eigProblem, anasaziList);
+  eigSolver.solve ();
+  RCP<const MV> Z = eigProblem->getSolution ().Evecs;
+  const double eigTime = timer.ElapsedTime ();
+
+  TEUCHOS_TEST_FOR_EXCEPTION(Z == Teuchos::null || Z->NumVectors () == 0, std::runtime_error,
+                     "Anasazi did not return any eigenvectors.");
+
+  timer.ResetStartTime ();
+  RCP<DeflationPreconditioner> Deflation =
+    rcp (new DeflationPreconditioner (A, Z, Prec));
+  const double deflationSetupTime = timer.ElapsedTime ();
+
+  // Solve the same random right-hand sides with both preconditioners.
+  RCP<MV> cgRHS = rcp (new MV (A->OperatorDomainMap (), numRHS));
+  cgRHS->Random ();
+  RCP<ParameterList> cgList = rcp (new ParameterList ());
+  cgList->set ("Maximum Iterations", 1000);
+  cgList->set ("Convergence Tolerance", 1e-8);
+  cgList->set ("Verbosity", Belos::Errors + Belos::Warnings);
+
+  int cgIters[2] = {0, 0};
+  double cgTime[2] = {0.0, 0.0};
+  for (int useDeflation = 0; useDeflation < 2; ++useDeflation) {
+    RCP<Belos::EpetraPrecOp> cgPrec = (useDeflation == 0) ?
+      iluPrec : rcp (new Belos::EpetraPrecOp (Deflation));
+    for (int j = 0; j < numRHS; ++j) {
+      RCP<MV> x = rcp (new MV (A->OperatorDomainMap (), 1));
+      RCP<MV> b = rcp (new MV (View, *cgRHS, j, 1));
+      RCP<Belos::LinearProblem<double,MV,OP> > cgProblem =
+        rcp (new Belos::LinearProblem<double,MV,OP> (A, x, b));
+      cgProblem->setLeftPrec (cgPrec);
+      cgProblem->setProblem ();
+      Belos::PseudoBlockCGSolMgr<double,MV,OP> cgSolver (cgProblem, cgList);
+      timer.ResetStartTime ();
+      cgSolver.solve ();
+      cgTime[useDeflation] += timer.ElapsedTime ();
+      cgIters[useDeflation] += cgSolver.getNumIters ();
+    }
+  }
+
+  if (myRank == 0) {
+    const double setupTime = eigTime + deflationSetupTime;
+    const double savedPerRHS = (cgTime[0] - cgTime[1]) / numRHS;
+    cout << endl << "CG with ILU over " << numRHS << " right-hand sides:" << endl
+         << "  without deflation: " << cgIters[0] << " iterations, " << cgTime[0] << " s" << endl
+         << "  with " << Deflation->NumVectors () << " deflation vectors: "
+         << cgIters[1] << " iterations, " << cgTime[1] << " s" << endl
+         << "  setup (eigenvectors " << eigTime << " s, deflation " << deflationSetupTime << " s)";
+    if (savedPerRHS > 0.0) {
+      cout << " pays off after " << setupTime / savedPerRHS << " right-hand sides" << endl;
+    } else {
+      cout << " does not pay off for this problem size" << endl;
+    }
   }
 
   // Print out the preconditioner.  IFPACK preconditioner objects know
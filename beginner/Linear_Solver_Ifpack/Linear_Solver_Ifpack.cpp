@@ -15,8 +15,40 @@
 #include "AztecOO.h"
 #include "Ifpack.h"
 #include "Ifpack_AdditiveSchwarz.h"
+#include "Epetra_Time.h"
+#include <cstdlib>
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "../../aprepro_vhelp.h"
+#include "PolynomialPreconditioner.hpp"
+#include "SparseApproximateInverse.hpp"
+#include "MixedPrecisionGmres.hpp"
+
+// Solve with restarted GMRES storing the Krylov basis in BasisScalar, and
+// report basis memory, time per iteration and convergence
+template<class BasisScalar>
+void RunMixedPrecisionGmres(const char * BasisName, const Teuchos::RCP<const Epetra_Operator> & A,
+                            const Teuchos::RCP<const Epetra_Operator> & M, int Restart,
+                            const Epetra_Vector & RHS, const Epetra_Comm & Comm)
+{
+  Epetra_Vector LHS(A->OperatorDomainMap());
+  MixedPrecisionGmres<BasisScalar> Gmres(A, M, Restart);
+
+  Epetra_Time Time(Comm);
+  int ierr = Gmres.Solve(RHS, LHS, 1550, 1e-8);
+  double SolveTime = Time.ElapsedTime();
+
+  double MyBytes = Gmres.BasisBytes(), Bytes;
+  Comm.SumAll(&MyBytes, &Bytes, 1);
+  if (Comm.MyPID() == 0)
+    std::cout << "GMRES(" << Restart << ") with " << BasisName << " basis: "
+              << Bytes/1048576.0 << " MB basis, " << Gmres.NumIters() << " iterations, "
+              << SolveTime/std::max(Gmres.NumIters(), 1) << " s per iteration, relative residual "
+              << Gmres.AchievedTol() << ((ierr != 0) ? " (not converged)" : "") << std::endl;
+}
 
 int main(int argc, char *argv[])
 {
@@ -28,10 +60,32 @@ int main(int argc, char *argv[])
   Epetra_SerialComm Comm;
 #endif
 
+  // Usage: Linear_Solver_Ifpack [ILU|ILU0|Chebyshev|GMRESPoly|SPAI] [degree] [nx] [restart]
+  //
+  // ILU is ILU(1), ILU0 is ILU(0).  Chebyshev and GMRESPoly are
+  // polynomial preconditioners (see PolynomialPreconditioner.hpp),
+  // applied with matvecs and vector updates only.  SPAI is a sparse
+  // approximate inverse (see SparseApproximateInverse.hpp), applied as
+  // one matvec.  To compare them across ranks and threads, run e.g.
+  // "make bench".
+  //
+  // If a restart length is given, the problem is solved again after the
+  // AztecOO solve by restarted GMRES with the Krylov basis stored in double
+  // and in float (see MixedPrecisionGmres.hpp); "make bench_gmres" compares
+  // restart lengths.
+  std::string PrecType = "ILU"; // incomplete LU
+  int degree = 8;
+  if (argc > 1) PrecType = argv[1];
+  if (argc > 2) degree = atoi(argv[2]);
+
   Teuchos::ParameterList GaleriList;
 
   // The problem is defined on a 2D grid, global size is nx * nx.
   int nx = 30; 
+  if (argc > 3) nx = atoi(argv[3]);
+  int Restart = 30;
+  bool MixedPrecision = (argc > 4);
+  if (MixedPrecision) Restart = atoi(argv[4]);
   GaleriList.set("n", nx * nx);
   GaleriList.set("nx", nx);
   GaleriList.set("ny", nx);
@@ -50,30 +104,46 @@ int main(int argc, char *argv[])
 
   // create the preconditioner. For valid PrecType values,
   // please check the documentation
-  std::string PrecType = "ILU"; // incomplete LU
   int OverlapLevel = 1; // must be >= 0. If Comm.NumProc() == 1,
                         // it is ignored.
 
-  Teuchos::RCP<Ifpack_Preconditioner> Prec = Teuchos::rcp( Factory.Create(PrecType, &*A, OverlapLevel) );
-  assert(Prec != Teuchos::null);
-
-  // specify parameters for ILU
-  List.set("fact: drop tolerance", 1e-9);
-  List.set("fact: level-of-fill", 1);
-  // the combine mode is on the following:
-  // "Add", "Zero", "Insert", "InsertAdd", "Average", "AbsMax"
-  // Their meaning is as defined in file Epetra_CombineMode.h   
-  List.set("schwarz: combine mode", "Add");
-  // sets the parameters
-  IFPACK_CHK_ERR(Prec->SetParameters(List));
-
-  // initialize the preconditioner. At this point the matrix must
-  // have been FillComplete()'d, but actual values are ignored.
-  IFPACK_CHK_ERR(Prec->Initialize());
-
-  // Builds the preconditioners, by looking for the values of 
-  // the matrix.
-  IFPACK_CHK_ERR(Prec->Compute());
+  Epetra_Time Time(Comm);
+  Teuchos::RCP<Ifpack_Preconditioner> Prec;
+  Teuchos::RCP<PolynomialPreconditioner> PolyPrec;
+  Teuchos::RCP<SparseApproximateInverse> SpaiPrec;
+  if (PrecType == "SPAI") {
+    SpaiPrec = Teuchos::rcp( new SparseApproximateInverse(Teuchos::rcp_dynamic_cast<const Epetra_CrsMatrix>(A)) );
+    IFPACK_CHK_ERR(SpaiPrec->Compute());
+  }
+  else if (PrecType == "Chebyshev" || PrecType == "GMRESPoly") {
+    PolynomialPreconditioner::Type polyType = (PrecType == "Chebyshev") ?
+      PolynomialPreconditioner::Chebyshev : PolynomialPreconditioner::GmresPoly;
+    PolyPrec = Teuchos::rcp( new PolynomialPreconditioner(A, polyType, degree) );
+    IFPACK_CHK_ERR(PolyPrec->Compute());
+  }
+  else {
+    Prec = Teuchos::rcp( Factory.Create((PrecType == "ILU0") ? "ILU" : PrecType, &*A, OverlapLevel) );
+    assert(Prec != Teuchos::null);
+
+    // specify parameters for ILU
+    List.set("fact: drop tolerance", 1e-9);
+    List.set("fact: level-of-fill", (PrecType == "ILU0") ? 0 : 1);
+    // the combine mode is on the following:
+    // "Add", "Zero", "Insert", "InsertAdd", "Average", "AbsMax"
+    // Their meaning is as defined in file Epetra_CombineMode.h   
+    List.set("schwarz: combine mode", "Add");
+    // sets the parameters
+    IFPACK_CHK_ERR(Prec->SetParameters(List));
+
+    // initialize the preconditioner. At this point the matrix must
+    // have been FillComplete()'d, but actual values are ignored.
+    IFPACK_CHK_ERR(Prec->Initialize());
+
+    // Builds the preconditioners, by looking for the values of 
+    // the matrix.
+    IFPACK_CHK_ERR(Prec->Compute());
+  }
+  double SetupTime = Time.ElapsedTime();
 
   // =================================================== //
   // E N D   O F   I F P A C K   C O N S T R U C T I O N //
@@ -102,15 +172,51 @@ int main(int argc, char *argv[])
 
   // specify solver
   Solver.SetAztecOption(AZ_solver,AZ_gmres);
+  Solver.SetAztecOption(AZ_kspace,Restart);
   Solver.SetAztecOption(AZ_output,32);
 
   // HERE WE SET THE IFPACK PRECONDITIONER
-  Solver.SetPrecOperator(&*Prec);
+  if (PolyPrec != Teuchos::null) Solver.SetPrecOperator(&*PolyPrec);
+  else if (SpaiPrec != Teuchos::null) Solver.SetPrecOperator(&*SpaiPrec);
+  else Solver.SetPrecOperator(&*Prec);
 
   // .. and here we solve
+  Time.ResetStartTime();
   Solver.Iterate(1550,1e-8);
-
-  std::cout << *Prec;
+  double SolveTime = Time.ElapsedTime();
+
+  if (Prec != Teuchos::null) std::cout << *Prec;
+
+  // Time of one preconditioner application
+  const Epetra_Operator * PrecOp;
+  if (PolyPrec != Teuchos::null) PrecOp = &*PolyPrec;
+  else if (SpaiPrec != Teuchos::null) PrecOp = &*SpaiPrec;
+  else PrecOp = &*Prec;
+  double ApplyTime;
+  {
+    Epetra_Vector PrecIn(RHS), PrecOut(LHS);
+    Time.ResetStartTime();
+    for (int i=0; i<10; i++) PrecOp->ApplyInverse(PrecIn, PrecOut);
+    ApplyTime = Time.ElapsedTime()/10.0;
+  }
+
+  int NumThreads = 1;
+#ifdef _OPENMP
+  NumThreads = omp_get_max_threads();
+#endif
+  if (Comm.MyPID() == 0) {
+    std::cout << "Preconditioner " << PrecType;
+    if (PolyPrec != Teuchos::null) std::cout << " (degree " << degree << ")";
+    std::cout << ", " << Comm.NumProc() << " processes, " << NumThreads << " threads, "
+              << nx << " x " << nx << " grid: setup " << SetupTime << " s, apply " << ApplyTime << " s, "
+              << Solver.NumIters() << " iterations in " << SolveTime << " s" << std::endl;
+  }
+
+  // Same problem and preconditioner, Krylov basis in double and in float
+  if (MixedPrecision) {
+    RunMixedPrecisionGmres<double>("double", A, Teuchos::rcp(PrecOp, false), Restart, RHS, Comm);
+    RunMixedPrecisionGmres<float>("float", A, Teuchos::rcp(PrecOp, false), Restart, RHS, Comm);
+  }
 
 #ifdef HAVE_MPI
   MPI_Finalize() ; 
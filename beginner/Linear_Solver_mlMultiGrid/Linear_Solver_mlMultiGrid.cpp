@@ -21,6 +21,7 @@
 
 // includes required by ML
 #include "ml_epetra_preconditioner.h"
+#include "ml_include.h"
 
 #include "Trilinos_Util_CrsMatrixGallery.h"
 
@@ -28,6 +29,25 @@ using namespace Teuchos;
 using namespace Trilinos_Util;
 
 #include <iostream>
+#include <vector>
+#include <cstdlib>
+
+// Rows of the coarsest level on this process, and the average time of one
+// coarse solve (collective)
+static double CoarseSolveTime(const ML * ml, const Epetra_Comm & Comm, int & coarseRows)
+{
+  int level = ml->ML_coarsest_level;
+  coarseRows = ml->Amat[level].outvec_leng;
+  std::vector<double> rhs(coarseRows+1, 1.0), sol(coarseRows+1, 0.0);
+
+  int numSolves = 10;
+  Comm.Barrier();
+  Epetra_Time Time(Comm);
+  for (int i=0; i<numSolves; i++)
+    ML_CSolve_Apply(ml->SingleLevel[level].csolve, coarseRows, &rhs[0], coarseRows, &sol[0]);
+  Comm.Barrier();
+  return(Time.ElapsedTime()/numSolves);
+}
 
 int main(int argc, char *argv[])
 {
@@ -40,12 +60,23 @@ int main(int argc, char *argv[])
 
 #endif
 
+  // Usage: Linear_Solver_mlMultiGrid [agglomeration factor] [problem size]
+  //
+  // With agglomeration factor f > 1, the coarse operator is moved onto
+  // about NumProc/f processes (ML repartitioning) before the KLU solve, so
+  // fewer processes take part in its gather and scatter.  To compare the
+  // coarse solve time over process counts and factors, run "make bench".
+  int AggFactor = 1;
+  int ProblemSize = 1000;
+  if (argc > 1) AggFactor = atoi(argv[1]);
+  if (argc > 2) ProblemSize = atoi(argv[2]);
+
   Epetra_Time Time(Comm);
 
   // initialize an Gallery object
   CrsMatrixGallery Gallery("laplace_3d", Comm);
 
-  Gallery.Set("problem_size", 1000);
+  Gallery.Set("problem_size", ProblemSize);
 
   // retrieve pointers to matrix and linear problem
   Epetra_RowMatrix * A = Gallery.GetMatrix();
@@ -84,8 +115,44 @@ int main(int argc, char *argv[])
   // coarsening options:  Uncoupled, MIS, Uncoupled-MIS (uncoupled on the finer grids, then switch to MIS)
   MLList.set("aggregation: type", "Uncoupled");
 
+  // coarse grid agglomeration: the coarse solve should run on
+  // ceil(NumProc/f) processes.  Amesos-KLU ignores "coarse: max processes";
+  // the process count is set by ML repartitioning instead, which moves each
+  // level onto about (global rows)/(min per proc) processes.  The coarse size
+  // is taken from a hierarchy built without repartitioning, and the levels
+  // are repartitioned with Zoltan (hypergraph, so no coordinates are needed).
+  int NumCoarseProcs = Comm.NumProc();
+  if (AggFactor > 1 && Comm.NumProc() > 1) {
+    NumCoarseProcs = (Comm.NumProc() + AggFactor - 1)/AggFactor;
+
+    Teuchos::ParameterList ProbeList(MLList);
+    ProbeList.set("ML output", 0);
+    ML_Epetra::MultiLevelPreconditioner * Probe = new ML_Epetra::MultiLevelPreconditioner(*A, ProbeList);
+    int MyProbeRows = Probe->GetML()->Amat[Probe->GetML()->ML_coarsest_level].outvec_leng;
+    int ProbeRows;
+    Comm.SumAll(&MyProbeRows, &ProbeRows, 1);
+    delete Probe;
+
+    int MinPerProc = (ProbeRows + NumCoarseProcs - 1)/NumCoarseProcs;
+    MLList.set("repartition: enable", 1);
+    MLList.set("repartition: start level", 1);
+    MLList.set("repartition: min per proc", MinPerProc);
+    MLList.set("repartition: max min ratio", 1.0);
+    MLList.set("repartition: partitioner", "Zoltan");
+    MLList.set("repartition: Zoltan type", "hypergraph");
+  }
+
   // create the preconditioner object based on options in MLList and compute hierarchy
+  double SetupTime = Time.ElapsedTime();
   ML_Epetra::MultiLevelPreconditioner * MLPrec = new ML_Epetra::MultiLevelPreconditioner(*A, MLList);
+  SetupTime = Time.ElapsedTime() - SetupTime;
+
+  // size, distribution and solve time of the coarse problem
+  int MyCoarseRows, CoarseRows, ActiveProcs, MyActive;
+  double CoarseTime = CoarseSolveTime(MLPrec->GetML(), Comm, MyCoarseRows);
+  MyActive = (MyCoarseRows > 0) ? 1 : 0;
+  Comm.SumAll(&MyCoarseRows, &CoarseRows, 1);
+  Comm.SumAll(&MyActive, &ActiveProcs, 1);
 
   // tell AztecOO to use this preconditioner, then solve
   solver.SetPrecOperator(MLPrec);
@@ -94,7 +161,9 @@ int main(int argc, char *argv[])
   solver.SetAztecOption(AZ_output, 1);
 
   int Niters = 500;
+  double SolveTime = Time.ElapsedTime();
   solver.Iterate(Niters, 1e-12);
+  SolveTime = Time.ElapsedTime() - SolveTime;
 
   // print out some information about the preconditioner
   if( Comm.MyPID() == 0 ) std::cout << MLPrec->GetOutputList();
@@ -114,6 +183,12 @@ int main(int argc, char *argv[])
     std::cout << "||x_exact - x||_2 = " << diff << std::endl;
 
     std::cout << "Total Time = " << Time.ElapsedTime() << std::endl;
+
+    std::cout << "Coarse agglomeration factor " << AggFactor << ", " << Comm.NumProc()
+              << " processes: " << CoarseRows << " coarse rows on " << ActiveProcs
+              << " processes (target " << NumCoarseProcs << "), coarse solve " << CoarseTime
+              << " s, setup " << SetupTime << " s, " << solver.NumIters()
+              << " iterations in " << SolveTime << " s" << std::endl;
   }
 
   if (residual > 1e-5)
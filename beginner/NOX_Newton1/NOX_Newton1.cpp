@@ -16,6 +16,9 @@
 // on that communicator, quieting all the others.
 //
 #include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
 
 #include "Epetra_ConfigDefs.h"
 #ifdef HAVE_MPI
@@ -37,8 +40,10 @@
 #include "NOX_Epetra_Interface_Jacobian.H"
 #include "NOX_Epetra_LinearSystem_AztecOO.H"
 #include "NOX_Epetra_Group.H"
+#include "Teuchos_Time.hpp"
 
 #include "../../aprepro_vhelp.h"
+#include "BatchedNewton.hpp"
 
 // ==========================================================================
 // SimpleProblemInterface, the problem interface in this example,
@@ -53,11 +58,14 @@ public:
 
   // The constructor accepts an initial guess and the exact solution
   // vector (which we know because we created the example).  We make
-  // deep copies of each.
+  // deep copies of each.  The radius of the circle in the first
+  // equation is 1 unless given.
   SimpleProblemInterface (Epetra_Vector& InitialGuess, 
-                          Epetra_Vector& ExactSolution) :
+                          Epetra_Vector& ExactSolution,
+                          const double Radius = 1.0) :
     InitialGuess_ (new Epetra_Vector (InitialGuess)),
-    ExactSolution_ (new Epetra_Vector (ExactSolution))
+    ExactSolution_ (new Epetra_Vector (ExactSolution)),
+    Radius_ (Radius)
   {}
 
   // Destructor.
@@ -70,7 +78,7 @@ public:
             Epetra_Vector & f,
             NOX::Epetra::Interface::Required::FillType F)
   {
-    f[0] = x[0]*x[0] + x[1]*x[1] - 1.0;
+    f[0] = x[0]*x[0] + x[1]*x[1] - Radius_*Radius_;
     f[1] = x[1] - x[0]*x[0];
 
     return true;
@@ -128,8 +136,95 @@ public:
 private:
   Teuchos::RCP<Epetra_Vector> InitialGuess_;
   Teuchos::RCP<Epetra_Vector> ExactSolution_;
+  double Radius_;
 };
 
+// ==========================================================================
+// CircleSystems is the same system for BatchedNewton (see
+// BatchedNewton.hpp), with one radius per system:
+//
+// x(0)^2 + x(1)^2 - r_i^2 = 0
+//      x(1) - x(0)^2 = 0
+// ==========================================================================
+struct CircleSystems {
+  enum {Dim = 2};
+
+  CircleSystems (const double* Radius) : Radius_ (Radius) {}
+
+  void Evaluate (int i, const double x[2], double f[2], double J[4]) const {
+    f[0] = x[0]*x[0] + x[1]*x[1] - Radius_[i]*Radius_[i];
+    f[1] = x[1] - x[0]*x[0];
+    J[0] = 2.0 * x[0];
+    J[1] = 2.0 * x[1];
+    J[2] = - 2.0 * x[0];
+    J[3] = 1.0;
+  }
+
+  const double* Radius_;
+};
+
+// Solve the system of the given radius with NOX, from (0.5, 0.5), as in
+// main(); return the number of Newton iterations, or -1 on failure.
+static int
+SolveWithNOX (const Epetra_Comm& Comm, const double Radius, 
+              const Teuchos::RCP<Teuchos::ParameterList>& params,
+              double& x0, double& x1)
+{
+  using Teuchos::RCP;
+  using Teuchos::rcp;
+
+  Epetra_Map Map (2, 0, Comm);
+  Epetra_Vector ExactSolution (Map);
+  ExactSolution[1] = 0.5 * (sqrt (1.0 + 4.0*Radius*Radius) - 1);
+  ExactSolution[0] = sqrt (ExactSolution[1]);
+  Epetra_Vector InitialGuess (Map);
+  InitialGuess[0] = 0.5;
+  InitialGuess[1] = 0.5;
+
+  RCP<SimpleProblemInterface> interface = 
+    rcp (new SimpleProblemInterface (InitialGuess, ExactSolution, Radius));
+  RCP<NOX::Epetra::Interface::Required> iReq = interface;
+  RCP<NOX::Epetra::Interface::Jacobian> iJac = interface;
+
+  RCP<Epetra_CrsMatrix> A = rcp (new Epetra_CrsMatrix (Copy, Map, 2));
+  {
+    int indices[2] = {0, 1};
+    double values[2] = {1.0, 1.0};
+    A->InsertGlobalValues (0, 2, values, indices);
+    A->InsertGlobalValues (1, 2, values, indices);
+    A->FillComplete ();
+  }
+
+  Teuchos::ParameterList& printParams = params->sublist ("Printing");
+  Teuchos::ParameterList& lsParams = 
+    params->sublist ("Direction").sublist ("Newton").sublist ("Linear Solver");
+  RCP<NOX::Epetra::LinearSystemAztecOO> linSys = 
+    rcp (new NOX::Epetra::LinearSystemAztecOO (printParams, lsParams,
+                                               iReq, iJac, A, InitialGuess));
+  NOX::Epetra::Vector noxInitGuess (InitialGuess, NOX::DeepCopy);
+  RCP<NOX::Epetra::Group> group = 
+    rcp (new NOX::Epetra::Group (printParams, iReq, noxInitGuess, linSys));
+
+  RCP<NOX::StatusTest::NormF> testNormF = 
+    rcp (new NOX::StatusTest::NormF (1.0e-10));
+  RCP<NOX::StatusTest::MaxIters> testMaxIters = 
+    rcp (new NOX::StatusTest::MaxIters (20));
+  RCP<NOX::StatusTest::Combo> combo = 
+    rcp (new NOX::StatusTest::Combo (NOX::StatusTest::Combo::OR, 
+                                     testNormF, testMaxIters));
+  RCP<NOX::Solver::Generic> solver = 
+    NOX::Solver::buildSolver (group, combo, params);
+  NOX::StatusTest::StatusType status = solver->solve ();
+
+  const NOX::Epetra::Group& finalGroup = 
+    dynamic_cast<const NOX::Epetra::Group&>(solver->getSolutionGroup());
+  const Epetra_Vector& finalSolution = 
+    dynamic_cast<const NOX::Epetra::Vector&> (finalGroup.getX ()).getEpetraVector ();
+  x0 = finalSolution[0];
+  x1 = finalSolution[1];
+  return status == NOX::StatusTest::Converged ? solver->getNumIterations () : -1;
+}
+
 // =========== //
 // main driver //
 // =========== //
@@ -347,6 +442,67 @@ main (int argc, char **argv)
         std::cout << "Exact solution: " << std::endl;
       }
       std::cout << ExactSolution;
+
+      //
+      // Batched solves: numSystems copies of the system with radii
+      // spread over [0.8, 1.2], solved by BatchedNewton, against a loop
+      // that solves the first numNOXSystems of them one by one with NOX
+      // as above.  Both take full Newton steps from (0.5, 0.5) down to
+      // ||F||_2 / sqrt(2) < 1e-10.
+      //
+      // Usage: NOX_Newton1 [number of systems] [number of NOX solves]
+      //
+      // The defaults keep the test run short; "make bench" passes sizes
+      // large enough for timing.
+      //
+      int numSystems = 10000;
+      int numNOXSystems = 100;
+      if (argc > 1) numSystems = atoi (argv[1]);
+      if (argc > 2) numNOXSystems = atoi (argv[2]);
+      numNOXSystems = std::min (numNOXSystems, numSystems);
+
+      std::vector<double> radius (numSystems);
+      for (int i = 0; i < numSystems; ++i) {
+        radius[i] = 0.8 + 0.4 * i / std::max (numSystems - 1, 1);
+      }
+
+      BatchedNewton<CircleSystems> batch (numSystems);
+      std::fill (batch.X (0), batch.X (0) + numSystems, 0.5);
+      std::fill (batch.X (1), batch.X (1) + numSystems, 0.5);
+      Teuchos::Time batchTimer ("BatchedNewton");
+      batchTimer.start (true);
+      const int numFailed = batch.Solve (CircleSystems (&radius[0]), 20, 1.0e-10);
+      batchTimer.stop ();
+
+      RCP<ParameterList> noxParams = parameterList (*params);
+      noxParams->sublist ("Printing").set ("Output Information", NOX::Utils::Error);
+      Teuchos::Time noxTimer ("NOX loop");
+      double maxDiff = 0.0;
+      int numNOXFailed = 0;
+      noxTimer.start (true);
+      for (int i = 0; i < numNOXSystems; ++i) {
+        double x0, x1;
+        const int iters = SolveWithNOX (Comm, radius[i], parameterList (*noxParams), x0, x1);
+        if (iters < 0) {
+          ++numNOXFailed;
+          continue;
+        }
+        maxDiff = std::max (maxDiff, std::max (std::fabs (x0 - batch.X (0)[i]), 
+                                               std::fabs (x1 - batch.X (1)[i])));
+      }
+      noxTimer.stop ();
+
+      const double batchRate = numSystems / batchTimer.totalElapsedTime ();
+      const double noxRate = numNOXSystems / noxTimer.totalElapsedTime ();
+      std::cout << std::endl
+                << "BatchedNewton: " << numSystems << " systems in " 
+                << batchTimer.totalElapsedTime () << " s (" << batchRate << " systems/s, "
+                << numFailed << " failed)" << std::endl
+                << "NOX loop     : " << numNOXSystems << " systems in "
+                << noxTimer.totalElapsedTime () << " s (" << noxRate << " systems/s, "
+                << numNOXFailed << " failed)" << std::endl
+                << "Throughput ratio " << batchRate / noxRate 
+                << ", max difference between the solutions " << maxDiff << std::endl;
     }
 
   // Remember how we quieted all MPI processes but Proc 0 above?
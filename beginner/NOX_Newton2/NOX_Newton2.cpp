@@ -21,13 +21,21 @@
 #include "Epetra_RowMatrix.h"
 #include "Epetra_Vector.h"
 
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
 #include "NOX.H"
 #include "NOX_Epetra_Interface_Required.H"
 #include "NOX_Epetra_Interface_Jacobian.H"
 #include "NOX_Epetra_LinearSystem_AztecOO.H"
 #include "NOX_Epetra_Group.H"
+#include "AztecOO.h"
+#include "Teuchos_Time.hpp"
 
 #include "../../aprepro_vhelp.h"
+#include "InitialGuessProjector.hpp"
+#include "AndersonAcceleration.hpp"
 
 //
 // Report the the number of lower, upper, left and right nodes, for
@@ -264,6 +272,16 @@ public:
     return Matrix_;
   }
 
+  // Change lambda, e.g. between the steps of a continuation.  The
+  // matrix (and so the Jacobian's structure) is kept.
+  void SetLambda (const double lambda) {
+    lambda_ = lambda;
+  }
+
+  double GetLambda () const {
+    return lambda_;
+  }
+
 private:
   int nx_, ny_;
   double hx_, hy_;
@@ -286,7 +304,7 @@ public:
 
   // The constructor takes a PDEProblem pointer.
   SimpleProblemInterface (Teuchos::RCP<PDEProblem> Problem) :
-    Problem_(Problem) 
+    Problem_(Problem), NumFEvals_(0), NumJacobians_(0)
   {}
 
   // The destructor doesn't need to do anything, because RCPs are
@@ -299,6 +317,7 @@ public:
             NOX::Epetra::Interface::Required::FillType F)
   {
     Problem_->ComputeF (x, f);
+    ++NumFEvals_;
     return true;
   }
 
@@ -306,6 +325,7 @@ public:
   computeJacobian (const Epetra_Vector& x, Epetra_Operator& Jac)
   {
     Problem_->UpdateJacobian (x);
+    ++NumJacobians_;
     return true;
   }
 
@@ -325,8 +345,122 @@ public:
                               "Epetra_Operator ***");
   }  
 
+  // Number of evaluations of F and of the Jacobian since the last
+  // ResetCounters().
+  int NumFEvals () const { return NumFEvals_; }
+  int NumJacobians () const { return NumJacobians_; }
+  void ResetCounters () { NumFEvals_ = 0; NumJacobians_ = 0; }
+
 private:
   Teuchos::RCP<PDEProblem> Problem_;
+  int NumFEvals_;
+  int NumJacobians_;
+};
+
+// ==========================================================================
+// LaplacianSolve applies the inverse of the (fixed) Laplacian L through
+// ApplyInverse(), by preconditioned CG with an incomplete Cholesky
+// factorization computed once in the constructor.  It is the
+// approximate Jacobian of the Anderson-accelerated fixed point below:
+// x = x - L^{-1} F(x) is the Picard iteration L x = -lambda e^x, which
+// needs no Jacobian evaluations.
+// ==========================================================================
+class LaplacianSolve : public Epetra_Operator
+{
+public:
+
+  LaplacianSolve (const Teuchos::RCP<Epetra_CrsMatrix>& L, const double tol) :
+    L_(L), Tol_(tol), Solver_(new AztecOO ())
+  {
+    Solver_->SetUserMatrix (L_.get ());
+    Solver_->SetAztecOption (AZ_solver, AZ_cg);
+    Solver_->SetAztecOption (AZ_precond, AZ_dom_decomp);
+    Solver_->SetAztecOption (AZ_subdomain_solve, AZ_icc);
+    Solver_->SetAztecOption (AZ_output, AZ_none);
+    double condest;
+    Solver_->ConstructPreconditioner (condest);
+  }
+
+  int Apply (const Epetra_MultiVector& X, Epetra_MultiVector& Y) const {
+    return -1;
+  }
+
+  int ApplyInverse (const Epetra_MultiVector& X, Epetra_MultiVector& Y) const {
+    Epetra_MultiVector B (X);
+    Y.PutScalar (0.0);
+    Solver_->SetLHS (&Y);
+    Solver_->SetRHS (&B);
+    // 0 if CG converged, else AztecOO's status (e.g. 1 for too many
+    // iterations), which the Anderson iteration passes on
+    return Solver_->Iterate (L_->NumGlobalRows (), Tol_);
+  }
+
+  int SetUseTranspose (bool UseTranspose) { return UseTranspose ? -1 : 0; }
+  double NormInf () const { return L_->NormInf (); }
+  const char* Label () const { return "LaplacianSolve"; }
+  bool UseTranspose () const { return false; }
+  bool HasNormInf () const { return true; }
+  const Epetra_Comm& Comm () const { return L_->Comm (); }
+  const Epetra_Map& OperatorDomainMap () const { return L_->OperatorRangeMap (); }
+  const Epetra_Map& OperatorRangeMap () const { return L_->OperatorDomainMap (); }
+
+private:
+  Teuchos::RCP<Epetra_CrsMatrix> L_;
+  double Tol_;
+  Teuchos::RCP<AztecOO> Solver_;
+};
+
+// ==========================================================================
+// ProjectedLinearSystemAztecOO starts every Newton linear solve from the
+// projection of the right-hand side onto the previous Newton steps
+// (see InitialGuessProjector.hpp), instead of from zero.  The Jacobian
+// changes between steps, so the stored images are recomputed with the
+// current Jacobian before each solve.  It also records the number of
+// linear iterations of each solve.  With numVectors = 0 it behaves like
+// NOX::Epetra::LinearSystemAztecOO.
+// ==========================================================================
+class ProjectedLinearSystemAztecOO : public NOX::Epetra::LinearSystemAztecOO
+{
+public:
+
+  ProjectedLinearSystemAztecOO (Teuchos::ParameterList& printParams,
+                                Teuchos::ParameterList& linearSolverParams,
+                                const Teuchos::RCP<NOX::Epetra::Interface::Required>& iReq,
+                                const Teuchos::RCP<NOX::Epetra::Interface::Jacobian>& iJac,
+                                const Teuchos::RCP<Epetra_Operator>& J,
+                                const NOX::Epetra::Vector& cloneVector,
+                                const int numVectors) :
+    NOX::Epetra::LinearSystemAztecOO (printParams, linearSolverParams,
+                                      iReq, iJac, J, cloneVector),
+    Jacobian_(J),
+    Projector_(J->OperatorDomainMap (), numVectors)
+  {}
+
+  bool
+  applyJacobianInverse (Teuchos::ParameterList& params,
+                        const NOX::Epetra::Vector& input,
+                        NOX::Epetra::Vector& result)
+  {
+    // Project the right-hand side onto the previous solutions.
+    Projector_.UpdateOperator (*Jacobian_);
+    Projector_.ComputeInitialGuess (input.getEpetraVector (), result.getEpetraVector ());
+
+    bool status = NOX::Epetra::LinearSystemAztecOO::applyJacobianInverse (params, input, result);
+
+    Projector_.AddSolution (*Jacobian_, result.getEpetraVector ());
+    Iterations_.push_back (params.sublist ("Output").get ("Number of Linear Iterations", 0));
+    return status;
+  }
+
+  // Number of linear iterations of each solve so far.
+  const std::vector<int>& getIterations () const {
+    return Iterations_;
+  }
+
+private:
+  Teuchos::RCP<Epetra_Operator> Jacobian_;
+  InitialGuessProjector Projector_;
+  std::vector<int> Iterations_;
 };
 
 //
@@ -424,6 +558,14 @@ main (int argc, char **argv)
   lsParams.set ("Output Frequency", 50);    
   lsParams.set ("Aztec Preconditioner", "ilu"); 
 
+  // Measure convergence relative to the right-hand side (rather than
+  // the initial residual), so that a better initial guess means fewer
+  // iterations.  With a zero initial guess the two are the same.
+  lsParams.set ("Convergence Test", "rhs");
+
+  // Keep a copy of the parameters for the reference solve below.
+  RCP<ParameterList> refParams = parameterList (*params);
+
   RCP<Epetra_CrsMatrix> A = Problem->GetMatrix();
 
   // Our SimpleProblemInterface implements both Required and
@@ -431,9 +573,13 @@ main (int argc, char **argv)
   RCP<NOX::Epetra::Interface::Required> iReq = interface;
   RCP<NOX::Epetra::Interface::Jacobian> iJac = interface;
 
-  RCP<NOX::Epetra::LinearSystemAztecOO> linSys = 
-    rcp (new NOX::Epetra::LinearSystemAztecOO (printParams, lsParams,
-                                               iReq, iJac, A, InitialGuess));
+  // Start each linear solve from the projection of its right-hand side
+  // onto the last (at most) 5 Newton steps.
+  const int numProjectionVectors = 5;
+  RCP<ProjectedLinearSystemAztecOO> linSys = 
+    rcp (new ProjectedLinearSystemAztecOO (printParams, lsParams,
+                                           iReq, iJac, A, InitialGuess,
+                                           numProjectionVectors));
 
   // Need a NOX::Epetra::Vector for constructor.
   NOX::Epetra::Vector noxInitGuess (InitialGuess, NOX::DeepCopy);
@@ -505,6 +651,236 @@ main (int argc, char **argv)
   // process(es) in the communicator to which they are associated.
   std::cout << finalSolution;
 
+  //
+  // Solve again from the same initial guess, starting every linear
+  // solve from zero, and report the linear iterations saved by the
+  // projected initial guesses.
+  //
+  ParameterList& refPrintParams = refParams->sublist ("Printing");
+  ParameterList& refLsParams = 
+    refParams->sublist ("Direction").sublist ("Newton").sublist ("Linear Solver");
+  RCP<ProjectedLinearSystemAztecOO> refLinSys = 
+    rcp (new ProjectedLinearSystemAztecOO (refPrintParams, refLsParams,
+                                           iReq, iJac, A, InitialGuess, 0));
+  RCP<NOX::Epetra::Group> refGroup = 
+    rcp (new NOX::Epetra::Group (refPrintParams, iReq, noxInitGuess, refLinSys));
+  RCP<NOX::Solver::Generic> refSolver = 
+    NOX::Solver::buildSolver (refGroup, combo, refParams);
+  refSolver->solve();
+
+  if (Comm.MyPID() == 0) {
+    const std::vector<int>& projIters = linSys->getIterations ();
+    const std::vector<int>& zeroIters = refLinSys->getIterations ();
+    std::cout << std::endl << "Linear iterations per Newton step "
+              << "(zero initial guess / projected initial guess):" << std::endl;
+    int zeroTotal = 0, projTotal = 0;
+    for (size_t k = 0; k < std::max (projIters.size (), zeroIters.size ()); ++k) {
+      int zeroK = k < zeroIters.size () ? zeroIters[k] : 0;
+      int projK = k < projIters.size () ? projIters[k] : 0;
+      std::cout << "  step " << k << ": " << zeroK << " / " << projK
+                << "  (saved " << zeroK - projK << ")" << std::endl;
+      zeroTotal += zeroK;
+      projTotal += projK;
+    }
+    std::cout << "  total : " << zeroTotal << " / " << projTotal
+              << "  (saved " << zeroTotal - projTotal << ")" << std::endl;
+  }
+
+  //
+  // Continuation in lambda, from the solution above up to lambdaFinal.
+  // Each step predicts the solution at the next lambda from the last two
+  // by a secant step, corrects it with Newton's method, and adapts the
+  // step length to the Newton iterations of the corrector; a step whose
+  // corrector fails is retried with half the step.  One group, linear
+  // system and Jacobian matrix are reused for all the steps, and the
+  // AztecOO preconditioner is reused until it is older than
+  // maxPrecAge solves.  Every lambda reached is then solved again
+  // independently from a zero initial guess, for comparison.
+  //
+  const double lambdaFinal = 20.0;
+  const double minStep = 1.0e-3;
+  const double maxStep = 10.0;
+  const int targetNewtonIters = 3;
+  const int maxPrecAge = 5;
+  double step = 1.0;
+
+  RCP<ParameterList> coldParams = parameterList (*refParams);
+  coldParams->sublist ("Printing").set ("Output Information",
+                                        NOX::Utils::Warning + NOX::Utils::Error);
+  RCP<ParameterList> contParams = parameterList (*coldParams);
+  ParameterList& contPrintParams = contParams->sublist ("Printing");
+  ParameterList& contLsParams = 
+    contParams->sublist ("Direction").sublist ("Newton").sublist ("Linear Solver");
+  contLsParams.set ("Preconditioner Reuse Policy", "Reuse");
+  contLsParams.set ("Max Age Of Prec", maxPrecAge);
+
+  RCP<ProjectedLinearSystemAztecOO> contLinSys = 
+    rcp (new ProjectedLinearSystemAztecOO (contPrintParams, contLsParams,
+                                           iReq, iJac, A, InitialGuess, 0));
+  RCP<NOX::Epetra::Group> contGroup = 
+    rcp (new NOX::Epetra::Group (contPrintParams, iReq, noxInitGuess, contLinSys));
+  RCP<NOX::Solver::Generic> contSolver = 
+    NOX::Solver::buildSolver (contGroup, combo, contParams);
+
+  Epetra_Vector xPrev (finalSolution);
+  Epetra_Vector xCur (finalSolution);
+  Epetra_Vector xPred (finalSolution);
+  double lambdaPrev = lambda;
+  double lambdaCur = lambda;
+  std::vector<double> contLambdas;
+  std::vector<int> contNewton, contLinear;
+  int numRejected = 0, contNewtonTotal = 0, contLinearTotal = 0;
+
+  while (lambdaCur < lambdaFinal && step >= minStep) {
+    const double lambdaNext = std::min (lambdaCur + step, lambdaFinal);
+
+    // Secant predictor (the previous solution for the first step).
+    xPred.Update (1.0, xCur, 0.0);
+    if (lambdaCur > lambdaPrev) {
+      const double ratio = (lambdaNext - lambdaCur) / (lambdaCur - lambdaPrev);
+      xPred.Update (ratio, xCur, -ratio, xPrev, 1.0);
+    }
+
+    // Newton corrector at lambdaNext.
+    Problem->SetLambda (lambdaNext);
+    const size_t firstSolve = contLinSys->getIterations ().size ();
+    NOX::Epetra::Vector noxPred (xPred, NOX::DeepCopy);
+    contSolver->reset (noxPred);
+    NOX::StatusTest::StatusType contStatus = contSolver->solve ();
+    const int newtonIters = contSolver->getNumIterations ();
+    int linearIters = 0;
+    for (size_t k = firstSolve; k < contLinSys->getIterations ().size (); ++k) {
+      linearIters += contLinSys->getIterations ()[k];
+    }
+    contNewtonTotal += newtonIters;
+    contLinearTotal += linearIters;
+
+    if (contStatus != NOX::StatusTest::Converged) {
+      ++numRejected;
+      step *= 0.5;
+      continue;
+    }
+
+    const NOX::Epetra::Group& contSolution = 
+      dynamic_cast<const NOX::Epetra::Group&> (contSolver->getSolutionGroup ());
+    xPrev.Update (1.0, xCur, 0.0);
+    xCur.Update (1.0, dynamic_cast<const NOX::Epetra::Vector&> 
+                 (contSolution.getX ()).getEpetraVector (), 0.0);
+    lambdaPrev = lambdaCur;
+    lambdaCur = lambdaNext;
+    contLambdas.push_back (lambdaCur);
+    contNewton.push_back (newtonIters);
+    contLinear.push_back (linearIters);
+
+    // Longer steps while the corrector converges quickly, shorter ones
+    // when it struggles.
+    const double factor = static_cast<double> (targetNewtonIters) / std::max (newtonIters, 1);
+    step = std::min (maxStep, step * std::min (2.0, std::max (0.5, factor)));
+  }
+
+  // Independent cold solves at the same values of lambda.
+  ParameterList& coldPrintParams = coldParams->sublist ("Printing");
+  ParameterList& coldLsParams = 
+    coldParams->sublist ("Direction").sublist ("Newton").sublist ("Linear Solver");
+  std::vector<int> coldNewton, coldLinear;
+  int coldNewtonTotal = 0, coldLinearTotal = 0;
+  for (size_t k = 0; k < contLambdas.size (); ++k) {
+    Problem->SetLambda (contLambdas[k]);
+    RCP<ProjectedLinearSystemAztecOO> coldLinSys = 
+      rcp (new ProjectedLinearSystemAztecOO (coldPrintParams, coldLsParams,
+                                             iReq, iJac, A, InitialGuess, 0));
+    RCP<NOX::Epetra::Group> coldGroup = 
+      rcp (new NOX::Epetra::Group (coldPrintParams, iReq, noxInitGuess, coldLinSys));
+    RCP<NOX::Solver::Generic> coldSolver = 
+      NOX::Solver::buildSolver (coldGroup, combo, coldParams);
+    coldSolver->solve ();
+    int linearIters = 0;
+    for (size_t j = 0; j < coldLinSys->getIterations ().size (); ++j) {
+      linearIters += coldLinSys->getIterations ()[j];
+    }
+    coldNewton.push_back (coldSolver->getNumIterations ());
+    coldLinear.push_back (linearIters);
+    coldNewtonTotal += coldNewton.back ();
+    coldLinearTotal += linearIters;
+  }
+  Problem->SetLambda (lambda);
+
+  if (Comm.MyPID() == 0) {
+    std::cout << std::endl << "Continuation in lambda from " << lambda << " to " << lambdaFinal
+              << " (" << contLambdas.size () << " steps, " << numRejected << " rejected)" << std::endl
+              << "Newton / linear iterations per step (continuation / cold):" << std::endl;
+    for (size_t k = 0; k < contLambdas.size (); ++k) {
+      std::cout << "  lambda " << contLambdas[k] << ": "
+                << contNewton[k] << " / " << coldNewton[k] << " Newton, "
+                << contLinear[k] << " / " << coldLinear[k] << " linear" << std::endl;
+    }
+    if (lambdaCur < lambdaFinal) {
+      std::cout << "  stopped at lambda " << lambdaCur << ": step below " << minStep << std::endl;
+    }
+    std::cout << "  total : " << contNewtonTotal << " / " << coldNewtonTotal << " Newton, "
+              << contLinearTotal << " / " << coldLinearTotal << " linear"
+              << " (rejected steps included)" << std::endl;
+  }
+
+  //
+  // Newton's method against Anderson-accelerated fixed-point iterations
+  // (see AndersonAcceleration.hpp), which only evaluate F through the
+  // same SimpleProblemInterface::computeF.  The fixed point is the Picard
+  // iteration with the Laplacian factored once (LaplacianSolve); depth 0
+  // is plain Picard.  Both stop at the NormF tolerance used above.
+  //
+  {
+    const double tolF = 1.0e-4;
+    const int maxFixedPointIters = 200;
+    const int depths[] = {0, 1, 3, 5, 10};
+    RCP<const Epetra_Operator> L = 
+      rcp (new LaplacianSolve (CreateLaplacian (nx, ny, Comm), 1.0e-10));
+
+    // Newton, from zero, with a fresh solver.
+    RCP<ProjectedLinearSystemAztecOO> newtonLinSys = 
+      rcp (new ProjectedLinearSystemAztecOO (coldPrintParams, coldLsParams,
+                                             iReq, iJac, A, InitialGuess, 0));
+    RCP<NOX::Epetra::Group> newtonGroup = 
+      rcp (new NOX::Epetra::Group (coldPrintParams, iReq, noxInitGuess, newtonLinSys));
+    RCP<NOX::Solver::Generic> newtonSolver = 
+      NOX::Solver::buildSolver (newtonGroup, combo, coldParams);
+    interface->ResetCounters ();
+    Teuchos::Time newtonTimer ("Newton");
+    newtonTimer.start (true);
+    NOX::StatusTest::StatusType newtonStatus = newtonSolver->solve ();
+    newtonTimer.stop ();
+    const int newtonFEvals = interface->NumFEvals ();
+    const int newtonJacobians = interface->NumJacobians ();
+
+    if (Comm.MyPID() == 0) {
+      std::cout << std::endl << "Newton vs. Anderson acceleration (lambda = " << lambda << ")" << std::endl
+                << std::setw(22) << "method" << std::setw(8) << "iters"
+                << std::setw(10) << "F evals" << std::setw(11) << "Jacobians"
+                << std::setw(13) << "time (s)" << std::endl
+                << std::setw(22) << "Newton" << std::setw(8) << newtonSolver->getNumIterations ()
+                << std::setw(10) << newtonFEvals << std::setw(11) << newtonJacobians
+                << std::setw(13) << newtonTimer.totalElapsedTime ()
+                << (newtonStatus != NOX::StatusTest::Converged ? "  (unconverged)" : "") << std::endl;
+    }
+
+    for (int d = 0; d < static_cast<int> (sizeof (depths) / sizeof (depths[0])); ++d) {
+      Epetra_Vector x (InitialGuess);
+      AndersonAcceleration anderson (iReq, depths[d], 1.0, L);
+      Teuchos::Time andersonTimer ("Anderson");
+      andersonTimer.start (true);
+      const int andersonStatus = anderson.Solve (x, maxFixedPointIters, tolF);
+      andersonTimer.stop ();
+      if (Comm.MyPID() == 0) {
+        std::ostringstream name;
+        name << "Anderson, depth " << depths[d];
+        std::cout << std::setw(22) << name.str () << std::setw(8) << anderson.NumIters ()
+                  << std::setw(10) << anderson.NumFEvals () << std::setw(11) << 0
+                  << std::setw(13) << andersonTimer.totalElapsedTime ()
+                  << (andersonStatus != 0 ? "  (unconverged)" : "") << std::endl;
+      }
+    }
+  }
+
 #ifdef HAVE_MPI
   MPI_Finalize();
 #endif
@@ -0,0 +1,212 @@
+//@HEADER
+// ************************************************************************
+//
+//            NOX: An Object-Oriented Nonlinear Solver Package
+//                 Copyright (2002) Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact Michael A. Heroux (maherou@sandia.gov)
+//
+// ************************************************************************
+//@HEADER
+
+/** \file   AndersonAcceleration.hpp
+    \brief  Anderson-accelerated fixed-point solver for F(x) = 0 that only
+            evaluates residuals, through the computeF() of a NOX problem
+            interface.
+
+    Newton's method needs a Jacobian (and a preconditioner for it) at
+    every step.  When those are expensive, F(x) = 0 can be written as the
+    fixed point x = G(x) = x + g(x) with
+
+    \verbatim
+      g(x) = -beta M^{-1} F(x)
+    \endverbatim
+
+    for a mixing parameter beta and a fixed approximation M of the
+    Jacobian (e.g. the linear part of the operator, factored once), or
+    M = I.  Anderson acceleration (Anderson mixing, Walker and Ni 2011)
+    keeps the last m differences of iterates dX and of g values dG and
+    takes
+
+    \verbatim
+      gamma   = argmin || g_k - dG gamma ||
+      x_{k+1} = x_k + g_k - (dX + dG) gamma
+    \endverbatim
+
+    which costs one F evaluation (and one M^{-1}) per step and an m x m
+    least squares problem.  The problem is solved through its normal
+    equations, assembled with a single SumAll, by a truncated SVD (GELSS)
+    that ignores directions dG has (numerically) lost.  With m = 0 the
+    iteration is the plain fixed point x_{k+1} = G(x_k).
+
+    The stopping test is the scaled 2-norm of NOX::StatusTest::NormF,
+    ||F(x)||_2 / sqrt(N) < tol.
+ **/
+
+#ifndef ANDERSONACCELERATION_HPP
+#define ANDERSONACCELERATION_HPP
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "Teuchos_RCP.hpp"
+#include "NOX_Epetra_Interface_Required.H"
+#include "Epetra_Operator.h"
+#include "Epetra_Comm.h"
+#include "Epetra_BlockMap.h"
+#include "Epetra_Vector.h"
+#include "Epetra_LAPACK.h"
+
+
+class AndersonAcceleration {
+
+ public:
+
+  /** \brief Constructor
+
+      \param  iReq    [in]    problem interface; only computeF() is called
+      \param  depth   [in]    number m of previous differences kept
+      \param  mixing  [in]    mixing parameter beta
+      \param  M       [in]    approximate Jacobian, applied with ApplyInverse(); null for none
+   */
+  AndersonAcceleration(const Teuchos::RCP<NOX::Epetra::Interface::Required> & iReq,
+                       int depth = 5, double mixing = 1.0,
+                       const Teuchos::RCP<const Epetra_Operator> & M = Teuchos::null)
+    : iReq_(iReq), depth_(depth), mixing_(mixing), M_(M),
+      numIters_(0), numFEvals_(0), normF_(0.0)
+  {}
+
+  /** \brief Solve F(x) = 0, starting from the given x.
+
+      \return  0 if ||F(x)||_2 / sqrt(N) < tol was reached within maxIters
+               iterations, 1 if not, negative if F or M^{-1} failed
+   */
+  int Solve(Epetra_Vector & x, int maxIters, double tol) {
+    const Epetra_BlockMap & map = x.Map();
+    const Epetra_Comm & comm = x.Comm();
+    double scale = 1.0/std::sqrt((double)map.NumGlobalElements());
+    std::vector<Teuchos::RCP<Epetra_Vector> > dX, dG;
+    Epetra_Vector f(map), g(map), xNew(map), gNew(map);
+    int numStored = 0, next = 0, m = depth_;
+    std::vector<double> local(m*m+m), global(m*m+m), gamma(m), sv(m), work(5*m+1);
+    Epetra_LAPACK lapack;
+
+    numIters_ = 0;
+    numFEvals_ = 0;
+    EPETRA_CHK_ERR(Residual(x, f, g));
+
+    while (normF_*scale >= tol && numIters_ < maxIters) {
+      // x_{k+1} = x_k + g_k - (dX + dG) gamma
+      xNew.Update(1.0, x, 1.0, g, 0.0);
+      if (numStored > 0) {
+        int n = numStored;
+        for (int i=0; i<n; i++) {
+          for (int j=0; j<=i; j++) local[i+j*n] = LocalDot(*dG[i], *dG[j]);
+          local[n*n+i] = LocalDot(*dG[i], g);
+        }
+        comm.SumAll(&local[0], &global[0], n*n+n);
+        for (int i=0; i<n; i++)
+          for (int j=0; j<i; j++) global[j+i*n] = global[i+j*n];
+        int rank, info;
+        lapack.GELSS(n, n, 1, &global[0], n, &global[n*n], n, &sv[0], 1.0e-12, &rank,
+                     &work[0], (int)work.size(), &info);
+        if (info == 0) {
+          for (int i=0; i<n; i++) {
+            gamma[i] = global[n*n+i];
+            xNew.Update(-gamma[i], *dX[i], -gamma[i], *dG[i], 1.0);
+          }
+        }
+      }
+
+      EPETRA_CHK_ERR(Residual(xNew, f, gNew));
+      numIters_++;
+
+      // Differences for the next steps; the oldest is overwritten
+      if (m > 0) {
+        if (numStored < m) {
+          dX.push_back(Teuchos::rcp(new Epetra_Vector(map)));
+          dG.push_back(Teuchos::rcp(new Epetra_Vector(map)));
+          numStored++;
+        }
+        dX[next]->Update(1.0, xNew, -1.0, x, 0.0);
+        dG[next]->Update(1.0, gNew, -1.0, g, 0.0);
+        next = (next+1) % m;
+      }
+      x.Update(1.0, xNew, 0.0);
+      g.Update(1.0, gNew, 0.0);
+    }
+    return((normF_*scale < tol) ? 0 : 1);
+  }
+
+  //! Iterations of the last Solve()
+  int NumIters() const {return(numIters_);}
+
+  //! Evaluations of F in the last Solve()
+  int NumFEvals() const {return(numFEvals_);}
+
+  //! ||F(x)||_2 at the end of the last Solve()
+  double NormF() const {return(normF_);}
+
+ private:
+
+  // f = F(x), g = -beta M^{-1} f
+  int Residual(const Epetra_Vector & x, Epetra_Vector & f, Epetra_Vector & g) {
+    if (!iReq_->computeF(x, f, NOX::Epetra::Interface::Required::Residual)) EPETRA_CHK_ERR(-1);
+    numFEvals_++;
+    f.Norm2(&normF_);
+    if (M_ == Teuchos::null) g.Update(-mixing_, f, 0.0);
+    else {
+      EPETRA_CHK_ERR(M_->ApplyInverse(f, g));
+      g.Scale(-mixing_);
+    }
+    return(0);
+  }
+
+  static double LocalDot(const Epetra_Vector & u, const Epetra_Vector & v) {
+    double s = 0.0;
+    for (int i=0; i<u.MyLength(); i++) s += u[i]*v[i];
+    return(s);
+  }
+
+  Teuchos::RCP<NOX::Epetra::Interface::Required> iReq_;
+  int depth_;
+  double mixing_;
+  Teuchos::RCP<const Epetra_Operator> M_;
+
+  int numIters_;
+  int numFEvals_;
+  double normF_;
+};
+
+#endif
@@ -0,0 +1,223 @@
+//@HEADER
+// ************************************************************************
+//
+//            NOX: An Object-Oriented Nonlinear Solver Package
+//                 Copyright (2002) Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact Michael A. Heroux (maherou@sandia.gov)
+//
+// ************************************************************************
+//@HEADER
+
+/** \file   BatchedNewton.hpp
+    \brief  Newton's method for many independent small nonlinear systems of
+            the same (compile-time) dimension, vectorized across systems.
+
+    Solving each of N tiny systems (constitutive updates, a few unknowns
+    each) with a general nonlinear solver spends nearly all of its time in
+    setup: maps, vectors, a sparse Jacobian and a Krylov solver per system.
+    BatchedNewton keeps the N systems in structure-of-arrays storage
+    (component d of all systems is contiguous) and runs one Newton step for
+    a chunk of systems in a single loop over the systems, which the
+    compiler vectorizes (one system per SIMD lane):
+
+    - the problem evaluates F and the Jacobian of one system from scalars,
+    - the Dim x Dim system J dx = F is solved by LU with partial pivoting,
+      fully unrolled for the compile-time Dim; row exchanges are done with
+      selects, so there are no branches in the loop,
+    - each lane carries an active flag: converged (||F||_2 / sqrt(Dim) <
+      tol, the scaled NormF test of NOX) or singular systems stop updating
+      but stay in the loop (masking), and a chunk leaves the Newton loop
+      when none of its systems is active.
+
+    Chunks are distributed over OpenMP threads when available.  The
+    Problem type provides
+
+    \verbatim
+      enum {Dim = ...};
+      void Evaluate(int i, const double x[Dim], double f[Dim], double J[Dim*Dim]) const;
+    \endverbatim
+
+    with J row-major; i is the index of the system, so that per-system data
+    can be read inside Evaluate().  It should be inline and branch-free for
+    the loop to vectorize.  Full Newton steps are taken (no line search).
+ **/
+
+#ifndef BATCHEDNEWTON_HPP
+#define BATCHEDNEWTON_HPP
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+
+template<class Problem>
+class BatchedNewton {
+
+ public:
+
+  enum {Dim = Problem::Dim};
+
+  //! Status of a system after Solve()
+  enum Status {Converged = 0, NotConverged = 1, Singular = 2};
+
+  /** \brief Constructor
+
+      \param  numSystems  [in]    number of systems N
+      \param  chunkSize   [in]    number of systems stepped together
+   */
+  BatchedNewton(int numSystems, int chunkSize = 256)
+    : numSystems_(numSystems), chunkSize_(chunkSize),
+      x_(Dim*(std::size_t)numSystems, 0.0), iters_(numSystems, 0), status_(numSystems, NotConverged)
+  {}
+
+  //! Component d of all the systems (initial guess before Solve(), solution after)
+  double * X(int d) {return(&x_[d*(std::size_t)numSystems_]);}
+  const double * X(int d) const {return(&x_[d*(std::size_t)numSystems_]);}
+
+  /** \brief Solve all the systems, starting from X.
+
+      \return  number of systems that did not converge
+   */
+  int Solve(const Problem & problem, int maxIters, double tol) {
+    int numChunks = (numSystems_ + chunkSize_ - 1)/chunkSize_;
+    int numFailed = 0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) reduction(+:numFailed)
+#endif
+    for (int c=0; c<numChunks; c++) {
+      int begin = c*chunkSize_;
+      int end = std::min(begin + chunkSize_, numSystems_);
+      numFailed += SolveChunk(problem, begin, end, maxIters, tol);
+    }
+    return(numFailed);
+  }
+
+  //! Newton iterations of system i
+  int NumIters(int i) const {return(iters_[i]);}
+
+  //! Status of system i
+  Status GetStatus(int i) const {return((Status)status_[i]);}
+
+ private:
+
+  int SolveChunk(const Problem & problem, int begin, int end, int maxIters, double tol) {
+    const double tol2 = tol*tol*Dim;
+    double * x[Dim];
+    for (int d=0; d<Dim; d++) x[d] = X(d);
+    int * iters = &iters_[0];
+    int * status = &status_[0];
+
+    for (int i=begin; i<end; i++) {
+      iters[i] = 0;
+      status[i] = NotConverged;
+    }
+    std::vector<int> active(end-begin, 1);
+    int * act = &active[0] - begin;
+
+    for (int iter=0; iter<=maxIters; iter++) {
+      int numActive = 0;
+#if defined(_OPENMP) && _OPENMP >= 201307
+#pragma omp simd reduction(+:numActive)
+#endif
+      for (int i=begin; i<end; i++) {
+        double xi[Dim], f[Dim], J[Dim*Dim];
+        for (int d=0; d<Dim; d++) xi[d] = x[d][i];
+        problem.Evaluate(i, xi, f, J);
+
+        double norm2 = 0.0;
+        for (int d=0; d<Dim; d++) norm2 += f[d]*f[d];
+        int converged = (norm2 < tol2);
+        int singular = !LUSolve(J, f);
+
+        // Masked update: only lanes still active, not converged and not
+        // singular take the step (and only while iterations remain)
+        int step = act[i] & !converged & !singular & (iter < maxIters);
+        for (int d=0; d<Dim; d++) x[d][i] -= step ? f[d] : 0.0;
+        status[i] = act[i] ? (converged ? (int)Converged : (singular ? (int)Singular : (int)NotConverged)) : status[i];
+        iters[i] += step;
+        act[i] = step;
+        numActive += step;
+      }
+      if (numActive == 0) break;
+    }
+
+    int numFailed = 0;
+    for (int i=begin; i<end; i++) numFailed += (status[i] != Converged);
+    return(numFailed);
+  }
+
+  // f = J^{-1} f by LU with partial pivoting; returns false if J is singular
+  static inline bool LUSolve(double J[Dim*Dim], double f[Dim]) {
+    bool regular = true;
+    for (int k=0; k<Dim; k++) {
+      // Bring the largest pivot to row k by conditional row exchanges
+      for (int r=k+1; r<Dim; r++) {
+        bool swap = std::fabs(J[r*Dim+k]) > std::fabs(J[k*Dim+k]);
+        for (int j=0; j<Dim; j++) {
+          double a = J[k*Dim+j], b = J[r*Dim+j];
+          J[k*Dim+j] = swap ? b : a;
+          J[r*Dim+j] = swap ? a : b;
+        }
+        double a = f[k], b = f[r];
+        f[k] = swap ? b : a;
+        f[r] = swap ? a : b;
+      }
+      double pivot = J[k*Dim+k];
+      regular = regular && (pivot != 0.0);
+      double inv = 1.0/(pivot != 0.0 ? pivot : 1.0);
+      for (int r=k+1; r<Dim; r++) {
+        double l = J[r*Dim+k]*inv;
+        for (int j=k+1; j<Dim; j++) J[r*Dim+j] -= l*J[k*Dim+j];
+        f[r] -= l*f[k];
+      }
+    }
+    for (int k=Dim-1; k>=0; k--) {
+      double s = f[k];
+      for (int j=k+1; j<Dim; j++) s -= J[k*Dim+j]*f[j];
+      double pivot = J[k*Dim+k];
+      f[k] = s/(pivot != 0.0 ? pivot : 1.0);
+    }
+    return(regular);
+  }
+
+  int numSystems_;
+  int chunkSize_;
+
+  // x_[d*numSystems_ + i] = component d of system i
+  std::vector<double> x_;
+  std::vector<int> iters_;
+  std::vector<int> status_;
+};
+
+#endif
@@ -0,0 +1,252 @@
+//@HEADER
+// ************************************************************************
+//
+//                 Belos: Block Linear Solvers Package
+//                  Copyright 2004 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact Michael A. Heroux (maherou@sandia.gov)
+//
+// ************************************************************************
+//@HEADER
+
+/** \file   BlockOrthogonalization.hpp
+    \brief  Communication-avoiding orthonormalization of a block of vectors:
+            tall skinny QR (TSQR) and CholQR2.
+
+    The Belos and Anasazi orthogonalization managers normalize a block of k
+    vectors column by column (Gram-Schmidt inside the block), which takes
+    O(k) global reductions and works with level-1/level-2 kernels.  Both
+    methods here take a fixed number of reductions, whatever k is, and do
+    their local work with LAPACK and level-3 BLAS:
+
+    - TSQR: each processor computes the QR factorization of its rows, the
+      k x k R factors are gathered (one GatherAll, i.e. a flat reduction
+      tree) and factored again, and each processor multiplies its local Q by
+      its k x k block of the second Q.  Unconditionally stable.
+    - CholQR2: R is the Cholesky factor of the Gram matrix X^H X (one
+      SumAll) and X is replaced with X R^{-1}; a second pass restores the
+      orthogonality lost in the first one.  Two reductions and the cheapest
+      local work, but it fails (returns the POTRF error) when X is
+      numerically rank deficient (condition number above about 1e8).
+
+    On return X holds Q and R the k x k upper triangular factor with
+    X_in = Q R.  The vectors are given as an array of local column pointers,
+    so any multivector whose columns are stored contiguously per processor
+    can be used; overloads for Epetra_MultiVector are provided.  Pass a null
+    communicator for vectors that live on one processor (e.g. MyMultiVec).
+    ScalarType is double or std::complex<double>; Epetra_MultiVector is real,
+    so its overloads always work in double, whatever ScalarType is.
+ **/
+
+#ifndef BLOCKORTHOGONALIZATION_HPP
+#define BLOCKORTHOGONALIZATION_HPP
+
+#include <vector>
+#include <algorithm>
+
+#include "Teuchos_BLAS.hpp"
+#include "Teuchos_LAPACK.hpp"
+#include "Teuchos_SerialDenseMatrix.hpp"
+#include "Epetra_Comm.h"
+#include "Epetra_MultiVector.h"
+
+
+template<class ScalarType>
+class BlockOrthogonalization {
+
+ public:
+
+  typedef Teuchos::SerialDenseMatrix<int,ScalarType> DenseMatrix;
+
+  /** \brief X = Q R by TSQR.
+
+      \param  localLength  [in]     number of local rows
+      \param  cols         [in/out] local column pointers of X, overwritten with Q
+      \param  R            [out]    upper triangular factor (reshaped to k x k)
+      \param  comm         [in]     communicator of X, or 0 if X is not distributed
+      \return 0, or the LAPACK error code
+   */
+  static int TSQR(int localLength, const std::vector<ScalarType*> & cols, DenseMatrix & R,
+                  const Epetra_Comm * comm = 0) {
+    Teuchos::BLAS<int,ScalarType> blas;
+    Teuchos::LAPACK<int,ScalarType> lapack;
+    int k = (int)cols.size();
+    int numProc = (comm == 0) ? 1 : comm->NumProc();
+    int myPID = (comm == 0) ? 0 : comm->MyPID();
+    R.shape(k, k);
+    if (k == 0) return(0);
+
+    // Local QR; fewer local rows than columns are padded with zero rows
+    int m = std::max(localLength, k), info = 0;
+    std::vector<ScalarType> W(m*k, ScalarType(0.0)), tau(k), work(1);
+    Gather(localLength, cols, &W[0], m);
+    int lwork = Lwork(std::max(m, numProc*k), k);
+    work.resize(lwork);
+    lapack.GEQRF(m, k, &W[0], m, &tau[0], &work[0], lwork, &info);
+    if (info != 0) return(info);
+
+    // Gather the local R factors into a (numProc*k) x k stack and factor it
+    int ms = numProc*k;
+    std::vector<ScalarType> myR(k*k, ScalarType(0.0)), S(ms*k);
+    for (int j=0; j<k; j++)
+      for (int i=0; i<=j; i++) myR[i+j*k] = W[i+j*m];
+    if (comm == 0) S = myR;
+    else {
+      std::vector<ScalarType> allR(ms*k);
+      int scale = sizeof(ScalarType)/sizeof(double);
+      comm->GatherAll((double*)&myR[0], (double*)&allR[0], scale*k*k);
+      for (int p=0; p<numProc; p++)
+        for (int j=0; j<k; j++)
+          for (int i=0; i<k; i++) S[p*k+i + j*ms] = allR[p*k*k + i+j*k];
+    }
+    std::vector<ScalarType> tauS(k);
+    lapack.GEQRF(ms, k, &S[0], ms, &tauS[0], &work[0], lwork, &info);
+    if (info != 0) return(info);
+    for (int j=0; j<k; j++)
+      for (int i=0; i<=j; i++) R(i,j) = S[i+j*ms];
+
+    // Q = Q_local * (my k x k block of the stack's Q)
+    lapack.UNGQR(ms, k, k, &S[0], ms, &tauS[0], &work[0], lwork, &info);
+    if (info != 0) return(info);
+    lapack.UNGQR(m, k, k, &W[0], m, &tau[0], &work[0], lwork, &info);
+    if (info != 0) return(info);
+    std::vector<ScalarType> Q(m*k);
+    blas.GEMM(Teuchos::NO_TRANS, Teuchos::NO_TRANS, m, k, k, ScalarType(1.0), &W[0], m,
+              &S[myPID*k], ms, ScalarType(0.0), &Q[0], m);
+    Scatter(localLength, &Q[0], m, cols);
+    return(0);
+  }
+
+  /** \brief X = Q R by CholQR2 (two passes of Cholesky QR).
+
+      \param  localLength  [in]     number of local rows
+      \param  cols         [in/out] local column pointers of X, overwritten with Q
+      \param  R            [out]    upper triangular factor (reshaped to k x k)
+      \param  comm         [in]     communicator of X, or 0 if X is not distributed
+      \return 0, or the POTRF error code if X is numerically rank deficient
+              (X is then left partly updated)
+   */
+  static int CholQR2(int localLength, const std::vector<ScalarType*> & cols, DenseMatrix & R,
+                     const Epetra_Comm * comm = 0) {
+    Teuchos::BLAS<int,ScalarType> blas;
+    int k = (int)cols.size();
+    R.shape(k, k);
+    if (k == 0) return(0);
+    int m = std::max(localLength, 1);
+    std::vector<ScalarType> W(m*k, ScalarType(0.0)), R1(k*k), R2(k*k);
+    Gather(localLength, cols, &W[0], m);
+
+    int info = CholQR(localLength, m, k, &W[0], &R1[0], comm);
+    if (info != 0) return(info);
+    info = CholQR(localLength, m, k, &W[0], &R2[0], comm);
+    if (info != 0) return(info);
+
+    // R = R2 R1
+    blas.TRMM(Teuchos::LEFT_SIDE, Teuchos::UPPER_TRI, Teuchos::NO_TRANS, Teuchos::NON_UNIT_DIAG,
+              k, k, ScalarType(1.0), &R2[0], k, &R1[0], k);
+    for (int j=0; j<k; j++)
+      for (int i=0; i<=j; i++) R(i,j) = R1[i+j*k];
+    Scatter(localLength, &W[0], m, cols);
+    return(0);
+  }
+
+  //! TSQR of an Epetra_MultiVector (real)
+  static int TSQR(Epetra_MultiVector & X, Teuchos::SerialDenseMatrix<int,double> & R) {
+    std::vector<double*> cols;
+    ColumnPointers(X, cols);
+    return(BlockOrthogonalization<double>::TSQR(X.MyLength(), cols, R, &X.Comm()));
+  }
+
+  //! CholQR2 of an Epetra_MultiVector (real)
+  static int CholQR2(Epetra_MultiVector & X, Teuchos::SerialDenseMatrix<int,double> & R) {
+    std::vector<double*> cols;
+    ColumnPointers(X, cols);
+    return(BlockOrthogonalization<double>::CholQR2(X.MyLength(), cols, R, &X.Comm()));
+  }
+
+ private:
+
+  static void ColumnPointers(Epetra_MultiVector & X, std::vector<double*> & cols) {
+    double ** ptrs;
+    X.ExtractView(&ptrs);
+    cols.assign(ptrs, ptrs + X.NumVectors());
+  }
+
+  // Copy the columns into / out of a column-major block with leading dimension ld
+  static void Gather(int n, const std::vector<ScalarType*> & cols, ScalarType * W, int ld) {
+    for (int j=0; j<(int)cols.size(); j++)
+      std::copy(cols[j], cols[j] + n, W + j*ld);
+  }
+  static void Scatter(int n, const ScalarType * W, int ld, const std::vector<ScalarType*> & cols) {
+    for (int j=0; j<(int)cols.size(); j++)
+      std::copy(W + j*ld, W + j*ld + n, cols[j]);
+  }
+
+  // Workspace size for GEQRF/UNGQR of up to m x k blocks
+  static int Lwork(int m, int k) {
+    Teuchos::LAPACK<int,ScalarType> lapack;
+    ScalarType query;
+    int info;
+    lapack.GEQRF(m, k, 0, m, 0, &query, -1, &info);
+    int lwork = (int)Teuchos::ScalarTraits<ScalarType>::real(query);
+    lapack.UNGQR(m, k, k, 0, m, 0, &query, -1, &info);
+    return(std::max(std::max(lwork, (int)Teuchos::ScalarTraits<ScalarType>::real(query)), k*64));
+  }
+
+  // One Cholesky QR pass: G = W^H W (summed over processors), G = R^H R, W = W R^{-1}
+  static int CholQR(int n, int ld, int k, ScalarType * W, ScalarType * R, const Epetra_Comm * comm) {
+    Teuchos::BLAS<int,ScalarType> blas;
+    Teuchos::LAPACK<int,ScalarType> lapack;
+    std::vector<ScalarType> G(k*k, ScalarType(0.0));
+    if (n > 0)
+      blas.GEMM(Teuchos::CONJ_TRANS, Teuchos::NO_TRANS, k, k, n, ScalarType(1.0), W, ld,
+                W, ld, ScalarType(0.0), &G[0], k);
+    if (comm != 0) {
+      int scale = sizeof(ScalarType)/sizeof(double);
+      comm->SumAll((double*)&G[0], (double*)R, scale*k*k);
+    }
+    else std::copy(G.begin(), G.end(), R);
+
+    int info;
+    lapack.POTRF('U', k, R, k, &info);
+    if (info != 0) return(info);
+    for (int j=0; j<k; j++)
+      for (int i=j+1; i<k; i++) R[i+j*k] = ScalarType(0.0);
+    if (n > 0)
+      blas.TRSM(Teuchos::RIGHT_SIDE, Teuchos::UPPER_TRI, Teuchos::NO_TRANS, Teuchos::NON_UNIT_DIAG,
+                n, k, ScalarType(1.0), R, k, W, ld);
+    return(0);
+  }
+};
+
+#endif
@@ -0,0 +1,191 @@
+//@HEADER
+// ************************************************************************
+//
+//                 Belos: Block Linear Solvers Package
+//                  Copyright 2004 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact Michael A. Heroux (maherou@sandia.gov)
+//
+// ************************************************************************
+//@HEADER
+
+/** \file   DeflationPreconditioner.hpp
+    \brief  Deflation preconditioner for CG on symmetric positive definite
+            problems, built from k approximate eigenvectors (e.g. computed
+            by Anasazi, or vectors kept from earlier solves).
+
+    The few smallest eigenvalues of A are what make CG slow, and a
+    one-level preconditioner such as ILU does little for them.  Given
+    vectors Z (n x k) spanning approximately the corresponding eigenvectors,
+    with E = Z^T A Z, Q = Z E^{-1} Z^T and P = I - A Q, the balancing
+    (BNN) form of deflation
+
+    \verbatim
+      B = P^T M P + Q
+    \endverbatim
+
+    is symmetric positive definite for SPD A and M, so it can be handed to
+    any CG implementation (Belos through Belos::EpetraPrecOp, AztecOO
+    through SetPrecOperator).  B solves exactly on span(Z), and M only has
+    to handle the rest of the spectrum.
+
+    A Z and E^{-1} are computed once.  Since A is symmetric, Q A W is
+    evaluated as Z E^{-1} (AZ)^T W, so an application costs one application
+    of M plus two k-column reductions and three n x k updates, but no
+    application of A.  The trade-off against the saved CG iterations
+    depends on k and on how expensive A and M are.
+
+    ApplyInverse() applies B, as for Ifpack preconditioners; Apply() is not
+    supported.
+ **/
+
+#ifndef DEFLATIONPRECONDITIONER_HPP
+#define DEFLATIONPRECONDITIONER_HPP
+
+#include <string>
+#include <stdexcept>
+
+#include "Teuchos_RCP.hpp"
+#include "Teuchos_TestForException.hpp"
+#include "Epetra_Operator.h"
+#include "Epetra_Comm.h"
+#include "Epetra_Map.h"
+#include "Epetra_LocalMap.h"
+#include "Epetra_MultiVector.h"
+#include "Epetra_SerialDenseMatrix.h"
+#include "Epetra_SerialDenseSolver.h"
+
+
+class DeflationPreconditioner : public Epetra_Operator {
+
+ public:
+
+  /** \brief Constructor
+
+      \param  A    [in]    symmetric positive definite operator
+      \param  Z    [in]    deflation vectors, in the domain map of A (linearly independent)
+      \param  M    [in]    inner preconditioner, applied with ApplyInverse(); null for none
+
+      Throws std::runtime_error if SetVectors(Z) fails (A Z cannot be
+      computed or Z^T A Z is singular).
+   */
+  DeflationPreconditioner(const Teuchos::RCP<const Epetra_Operator> & A,
+                          const Teuchos::RCP<const Epetra_MultiVector> & Z,
+                          const Teuchos::RCP<const Epetra_Operator> & M = Teuchos::null)
+    : A_(A), M_(M), label_("DeflationPreconditioner")
+  {
+    int ierr = SetVectors(Z);
+    TEUCHOS_TEST_FOR_EXCEPTION(ierr != 0, std::runtime_error,
+      "DeflationPreconditioner: SetVectors returned " << ierr
+      << " (are the deflation vectors linearly independent?)");
+  }
+
+  /** \brief Replace the deflation vectors (e.g. with better or more eigenvectors).
+
+      \return  0, or nonzero if Z^T A Z is singular
+   */
+  int SetVectors(const Teuchos::RCP<const Epetra_MultiVector> & Z) {
+    Z_ = Z;
+    int k = Z_->NumVectors();
+    localMap_ = Teuchos::rcp(new Epetra_LocalMap(k, 0, Z_->Comm()));
+    AZ_ = Teuchos::rcp(new Epetra_MultiVector(A_->OperatorRangeMap(), k));
+    EPETRA_CHK_ERR(A_->Apply(*Z_, *AZ_));
+
+    // E = Z^T A Z, then its inverse (k is small)
+    Epetra_MultiVector E(*localMap_, k);
+    EPETRA_CHK_ERR(E.Multiply('T', 'N', 1.0, *Z_, *AZ_, 0.0));
+    Epetra_SerialDenseMatrix Einv(k, k);
+    for (int j=0; j<k; j++)
+      for (int i=0; i<k; i++) Einv(i,j) = 0.5*(E[j][i] + E[i][j]);
+    Epetra_SerialDenseSolver solver;
+    solver.SetMatrix(Einv);
+    EPETRA_CHK_ERR(solver.Invert());
+
+    Einv_ = Teuchos::rcp(new Epetra_MultiVector(*localMap_, k));
+    for (int j=0; j<k; j++)
+      for (int i=0; i<k; i++) (*Einv_)[j][i] = Einv(i,j);
+    return(0);
+  }
+
+  //! Number of deflation vectors
+  int NumVectors() const {return(Z_->NumVectors());}
+
+  //! Y = (P^T M P + Q) X
+  int ApplyInverse(const Epetra_MultiVector & X, Epetra_MultiVector & Y) const {
+    int numVectors = X.NumVectors();
+    if (Y.NumVectors() != numVectors) EPETRA_CHK_ERR(-1);
+    Epetra_MultiVector s(*localMap_, numVectors), t(*localMap_, numVectors);
+
+    // t = E^{-1} Z^T X, so Q X = Z t and P X = X - AZ t
+    EPETRA_CHK_ERR(s.Multiply('T', 'N', 1.0, *Z_, X, 0.0));
+    EPETRA_CHK_ERR(t.Multiply('N', 'N', 1.0, *Einv_, s, 0.0));
+    Epetra_MultiVector PX(X);
+    EPETRA_CHK_ERR(PX.Multiply('N', 'N', -1.0, *AZ_, t, 1.0));
+
+    // Y = M P X
+    if (M_ == Teuchos::null) Y = PX;
+    else EPETRA_CHK_ERR(M_->ApplyInverse(PX, Y));
+
+    // Y = P^T Y + Q X, with Q A Y = Z E^{-1} (AZ)^T Y
+    EPETRA_CHK_ERR(s.Multiply('T', 'N', 1.0, *AZ_, Y, 0.0));
+    EPETRA_CHK_ERR(t.Multiply('N', 'N', -1.0, *Einv_, s, 1.0));
+    EPETRA_CHK_ERR(Y.Multiply('N', 'N', 1.0, *Z_, t, 1.0));
+    return(0);
+  }
+
+  int Apply(const Epetra_MultiVector &, Epetra_MultiVector &) const {return(-1);}
+
+  int SetUseTranspose(bool useTranspose) {return(useTranspose ? -1 : 0);}
+  double NormInf() const {return(0.0);}
+  const char * Label() const {return(label_.c_str());}
+  bool UseTranspose() const {return(false);}
+  bool HasNormInf() const {return(false);}
+  const Epetra_Comm & Comm() const {return(A_->Comm());}
+  const Epetra_Map & OperatorDomainMap() const {return(A_->OperatorDomainMap());}
+  const Epetra_Map & OperatorRangeMap() const {return(A_->OperatorRangeMap());}
+
+ private:
+
+  Teuchos::RCP<const Epetra_Operator> A_;
+  Teuchos::RCP<const Epetra_Operator> M_;
+  std::string label_;
+
+  Teuchos::RCP<const Epetra_MultiVector> Z_;
+  Teuchos::RCP<Epetra_MultiVector> AZ_;
+
+  // E^{-1} = (Z^T A Z)^{-1}, replicated on every processor
+  Teuchos::RCP<Epetra_LocalMap> localMap_;
+  Teuchos::RCP<Epetra_MultiVector> Einv_;
+};
+
+#endif
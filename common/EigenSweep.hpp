@@ -0,0 +1,365 @@
+//@HEADER
+// ************************************************************************
+//
+//                 Anasazi: Block Eigensolvers Package
+//                 Copyright 2004 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact Michael A. Heroux (maherou@sandia.gov)
+//
+// ************************************************************************
+//@HEADER
+
+/** \file   EigenSweep.hpp
+    \brief  Warm-started Anasazi eigensolves along a sequence of slowly
+            varying operators A(t_0), A(t_1), ...
+
+    A parameter sweep solves the same eigenproblem for many nearby
+    operators.  Started from random vectors, every step pays for the whole
+    convergence again; the eigenvectors converged at the previous step are
+    already close to the wanted ones, and starting from them usually takes
+    a fraction of the iterations.  EigenSweep wraps one Anasazi solver
+    manager (LOBPCGSolMgr, BlockDavidsonSolMgr, BlockKrylovSchurSolMgr, ...)
+    for Epetra_MultiVector / Epetra_Operator and keeps the eigenvectors of
+    the last Solve() to build the initial vectors of the next one:
+
+    - the initial block has the previous eigenvectors in its first columns
+      and random vectors after them, up to a multiple of the block size;
+    - LOBPCG and Block Krylov-Schur only use the first block of initial
+      vectors, so the previous eigenvectors beyond the block size are also
+      added into the columns of the first block (column j % blockSize).
+      The first block then spans combinations of all of them, which is what
+      a Krylov method needs; Block Davidson uses all the columns.
+
+    Auxiliary vectors (SetAuxVecs()) are passed to every eigenproblem; the
+    solver then works in their orthogonal complement, e.g. to keep out
+    eigenvectors known exactly for the whole sweep (a null space).
+
+    For comparisons each Solve() records the solver iterations, the number
+    of restarts (detected as a drop of the subspace dimension, through a
+    debug status test) and the number of operator applications (vectors
+    passed to A).  CompareWarmStart() runs a whole sweep cold and warm and
+    prints the work of both; DiagonalShift builds the operators of the
+    sweep A(t) = A + t diag(v).
+ **/
+
+#ifndef EIGENSWEEP_HPP
+#define EIGENSWEEP_HPP
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+#include "Teuchos_RCP.hpp"
+#include "Teuchos_ParameterList.hpp"
+#include "AnasaziBasicEigenproblem.hpp"
+#include "AnasaziStatusTest.hpp"
+#include "AnasaziEpetraAdapter.hpp"
+#include "Epetra_Operator.h"
+#include "Epetra_MultiVector.h"
+#include "Epetra_Vector.h"
+#include "Epetra_CrsMatrix.h"
+#include "Epetra_Map.h"
+
+
+template<class SolMgr>
+class EigenSweep {
+
+ public:
+
+  typedef Epetra_MultiVector MV;
+  typedef Epetra_Operator OP;
+
+  /** \brief Constructor
+
+      \param  params     [in]    parameters of the solver manager (must set "Block Size")
+      \param  nev        [in]    number of wanted eigenvalues
+      \param  hermitian  [in]    whether the operators are symmetric
+   */
+  EigenSweep(const Teuchos::ParameterList & params, int nev, bool hermitian = true)
+    : params_(params), nev_(nev), hermitian_(hermitian),
+      numIters_(0), numRestarts_(0), numApplies_(0)
+  {}
+
+  //! Vectors the eigenvectors are kept orthogonal to, in every Solve()
+  void SetAuxVecs(const Teuchos::RCP<const MV> & auxVecs) {auxVecs_ = auxVecs;}
+
+  //! Forget the previous eigenvectors; the next Solve() starts from random vectors
+  void Reset() {evecs_ = Teuchos::null;}
+
+  /** \brief Solve the eigenproblem of A.
+
+      \param  A          [in]    operator of this step
+      \param  warmStart  [in]    start from the previous eigenvectors (if any)
+      \return the return code of the solver manager
+   */
+  Anasazi::ReturnType Solve(const Teuchos::RCP<const OP> & A, bool warmStart = true) {
+    Teuchos::RCP<CountingOperator> op = Teuchos::rcp(new CountingOperator(A));
+    Teuchos::RCP<MV> ivec = InitialVectors(A->OperatorDomainMap(), warmStart);
+
+    Teuchos::RCP<Anasazi::BasicEigenproblem<double,MV,OP> > problem =
+      Teuchos::rcp(new Anasazi::BasicEigenproblem<double,MV,OP>(op, ivec));
+    problem->setHermitian(hermitian_);
+    problem->setNEV(nev_);
+    if (auxVecs_ != Teuchos::null) problem->setAuxVecs(auxVecs_);
+    if (!problem->setProblem()) return(Anasazi::Unconverged);
+
+    Teuchos::RCP<RestartCounter> counter = Teuchos::rcp(new RestartCounter);
+    SolMgr solver(problem, params_);
+    solver.setDebugStatusTest(counter);
+    Anasazi::ReturnType returnCode = solver.solve();
+
+    numIters_ = solver.getNumIters();
+    numRestarts_ = counter->NumRestarts();
+    numApplies_ = op->NumApplies();
+    solution_ = problem->getSolution();
+    if (solution_.numVecs > 0) evecs_ = Teuchos::rcp(new MV(*solution_.Evecs));
+    return(returnCode);
+  }
+
+  //! Eigenpairs of the last Solve()
+  const Anasazi::Eigensolution<double,MV> & Solution() const {return(solution_);}
+
+  //! Solver iterations of the last Solve()
+  int NumIters() const {return(numIters_);}
+
+  //! Restarts of the last Solve()
+  int NumRestarts() const {return(numRestarts_);}
+
+  //! Operator applications (number of vectors) of the last Solve()
+  int NumApplies() const {return(numApplies_);}
+
+ private:
+
+  // Previous eigenvectors first, then random columns
+  Teuchos::RCP<MV> InitialVectors(const Epetra_Map & map, bool warmStart) const {
+    int blockSize = params_.get<int>("Block Size");
+    int numPrev = (warmStart && evecs_ != Teuchos::null) ? evecs_->NumVectors() : 0;
+    int numCols = blockSize*std::max(1, (numPrev + blockSize - 1)/blockSize);
+    Teuchos::RCP<MV> ivec = Teuchos::rcp(new MV(map, numCols));
+    ivec->Random();
+    for (int j=0; j<numPrev; j++) {
+      (*ivec)(j)->Update(1.0, *(*evecs_)(j), 0.0);
+      if (j >= blockSize) (*ivec)(j % blockSize)->Update(1.0, *(*evecs_)(j), 1.0);
+    }
+    return(ivec);
+  }
+
+  // Forwards to A and counts the vectors applied
+  class CountingOperator : public Epetra_Operator {
+   public:
+    CountingOperator(const Teuchos::RCP<const OP> & A) : A_(A), numApplies_(0) {}
+
+    int Apply(const Epetra_MultiVector & X, Epetra_MultiVector & Y) const {
+      numApplies_ += X.NumVectors();
+      return(A_->Apply(X, Y));
+    }
+    int ApplyInverse(const Epetra_MultiVector & X, Epetra_MultiVector & Y) const {
+      return(A_->ApplyInverse(X, Y));
+    }
+    int SetUseTranspose(bool useTranspose) {return(useTranspose ? -1 : 0);}
+    double NormInf() const {return(A_->NormInf());}
+    const char * Label() const {return(A_->Label());}
+    bool UseTranspose() const {return(false);}
+    bool HasNormInf() const {return(A_->HasNormInf());}
+    const Epetra_Comm & Comm() const {return(A_->Comm());}
+    const Epetra_Map & OperatorDomainMap() const {return(A_->OperatorDomainMap());}
+    const Epetra_Map & OperatorRangeMap() const {return(A_->OperatorRangeMap());}
+
+    int NumApplies() const {return(numApplies_);}
+
+   private:
+    Teuchos::RCP<const OP> A_;
+    mutable int numApplies_;
+  };
+
+  // Never stops the solver; counts the drops of the subspace dimension
+  class RestartCounter : public Anasazi::StatusTest<double,MV,OP> {
+   public:
+    RestartCounter() : numRestarts_(0), lastDim_(0) {}
+
+    Anasazi::TestStatus checkStatus(Anasazi::Eigensolver<double,MV,OP> * solver) {
+      int dim = solver->getCurSubspaceDim();
+      if (dim < lastDim_) numRestarts_++;
+      lastDim_ = dim;
+      return(Anasazi::Failed);
+    }
+    Anasazi::TestStatus getStatus() const {return(Anasazi::Failed);}
+    std::vector<int> whichVecs() const {return(std::vector<int>());}
+    int howMany() const {return(0);}
+    void clearStatus() {}
+    void reset() {numRestarts_ = 0; lastDim_ = 0;}
+    std::ostream & print(std::ostream & os, int indent = 0) const {
+      os << std::string(indent, ' ') << "RestartCounter: " << numRestarts_ << " restarts" << std::endl;
+      return(os);
+    }
+
+    int NumRestarts() const {return(numRestarts_);}
+
+   private:
+    int numRestarts_;
+    int lastDim_;
+  };
+
+  Teuchos::ParameterList params_;
+  int nev_;
+  bool hermitian_;
+  Teuchos::RCP<const MV> auxVecs_;
+
+  // Converged eigenvectors of the last Solve()
+  Teuchos::RCP<MV> evecs_;
+  Anasazi::Eigensolution<double,MV> solution_;
+
+  int numIters_;
+  int numRestarts_;
+  int numApplies_;
+};
+
+
+/** \brief Solve the eigenproblems of a sweep from random vectors and from
+           the previous eigenvectors, and print the work of both (collective).
+
+    \param  params          [in]    parameters of the solver manager (must set "Block Size")
+    \param  nev             [in]    number of wanted eigenvalues
+    \param  sweepOperator   [in]    any object with a member
+                                    Teuchos::RCP<const Epetra_Operator> operator()(double t) const
+                                    returning the operator A(t)
+    \param  numSteps        [in]    number of steps t = 0, dt, ..., (numSteps-1)*dt
+    \param  dt              [in]    parameter step
+    \param  vectorName      [in]    what the eigenvectors are, for the table title
+    \param  reportRestarts  [in]    print the restarts column; false for solvers
+                                    that never restart (LOBPCG)
+    \param  os              [in]    stream written by processor 0
+    \return number of solves (cold or warm) that did not converge
+ */
+template<class SolMgr, class SweepOperator>
+int CompareWarmStart(const Teuchos::ParameterList & params, int nev,
+                     const SweepOperator & sweepOperator, int numSteps, double dt,
+                     const std::string & vectorName, bool reportRestarts,
+                     std::ostream & os = std::cout)
+{
+  EigenSweep<SolMgr> coldSweep(params, nev);
+  EigenSweep<SolMgr> warmSweep(params, nev);
+  // iterations, restarts, operator applies
+  int totalCold[3] = {0, 0, 0};
+  int totalWarm[3] = {0, 0, 0};
+  int numUnconverged = 0;
+  bool print = false;
+  std::string rule(reportRestarts ? 66 : 46, '-');
+
+  for (int step=0; step<numSteps; step++) {
+    Teuchos::RCP<const Epetra_Operator> At = sweepOperator(step*dt);
+    if (step == 0) {
+      print = (At->Comm().MyPID() == 0);
+      if (print) {
+        os << std::endl << "Parameter sweep (cold = random start, warm = previous " << vectorName << ")" << std::endl
+           << rule << std::endl
+           << std::setw(6) << "t"
+           << std::setw(20) << "iterations";
+        if (reportRestarts) os << std::setw(20) << "restarts";
+        os << std::setw(20) << "operator applies" << std::endl
+           << std::setw(6) << "";
+        for (int k=0; k<3; k++)
+          if (k != 1 || reportRestarts) os << std::setw(10) << "cold" << std::setw(10) << "warm";
+        os << std::endl << rule << std::endl;
+      }
+    }
+
+    Anasazi::ReturnType coldCode = coldSweep.Solve(At, false);
+    Anasazi::ReturnType warmCode = warmSweep.Solve(At, true);
+    int cold[3] = {coldSweep.NumIters(), coldSweep.NumRestarts(), coldSweep.NumApplies()};
+    int warm[3] = {warmSweep.NumIters(), warmSweep.NumRestarts(), warmSweep.NumApplies()};
+    if (coldCode != Anasazi::Converged) numUnconverged++;
+    if (warmCode != Anasazi::Converged) numUnconverged++;
+    for (int k=0; k<3; k++) {
+      totalCold[k] += cold[k];
+      totalWarm[k] += warm[k];
+    }
+    if (print) {
+      os << std::setw(6) << step*dt;
+      for (int k=0; k<3; k++)
+        if (k != 1 || reportRestarts) os << std::setw(10) << cold[k] << std::setw(10) << warm[k];
+      if (coldCode != Anasazi::Converged || warmCode != Anasazi::Converged) os << "  (unconverged)";
+      os << std::endl;
+    }
+  }
+
+  if (print) {
+    os << rule << std::endl
+       << std::setw(6) << "total";
+    for (int k=0; k<3; k++)
+      if (k != 1 || reportRestarts) os << std::setw(10) << totalCold[k] << std::setw(10) << totalWarm[k];
+    os << std::endl << "Warm starts saved " << totalCold[0] - totalWarm[0] << " iterations, ";
+    if (reportRestarts) os << totalCold[1] - totalWarm[1] << " restarts, ";
+    os << "and " << totalCold[2] - totalWarm[2] << " operator applies over the sweep." << std::endl;
+  }
+  return(numUnconverged);
+}
+
+
+/** \brief Operators A(t) = A + t diag(v) of a sweep, for CompareWarmStart()
+
+    Each call copies A and shifts its diagonal, so A must have all its
+    diagonal entries stored.
+ */
+class DiagonalShift {
+
+ public:
+
+  /** \brief Constructor
+
+      \param  A          [in]    matrix at t = 0
+      \param  potential  [in]    diagonal v, on the row map of A
+   */
+  DiagonalShift(const Teuchos::RCP<const Epetra_CrsMatrix> & A, const Epetra_Vector & potential)
+    : A_(A), potential_(potential)
+  {}
+
+  //! New matrix A + t diag(v)
+  Teuchos::RCP<const Epetra_Operator> operator()(double t) const {
+    Teuchos::RCP<Epetra_CrsMatrix> At = Teuchos::rcp(new Epetra_CrsMatrix(*A_));
+    Epetra_Vector diagonal(A_->RowMap());
+    At->ExtractDiagonalCopy(diagonal);
+    diagonal.Update(t, potential_, 1.0);
+    At->ReplaceDiagonalValues(diagonal);
+    return(At);
+  }
+
+ private:
+
+  Teuchos::RCP<const Epetra_CrsMatrix> A_;
+  Epetra_Vector potential_;
+};
+
+#endif
@@ -0,0 +1,309 @@
+//@HEADER
+// ************************************************************************
+//
+//               Epetra: Linear Algebra Services Package
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact Michael A. Heroux (maherou@sandia.gov)
+//
+// ************************************************************************
+//@HEADER
+
+/** \file   Epetra_ChunkedMigration.hpp
+    \brief  Redistribution of a sparse matrix to a new row map in chunks of
+            rows, with communication buffers bounded by one chunk.
+
+    Redistributing with a single Export (target.Export(source, exporter,
+    mode) into a new Epetra_CrsMatrix) holds at its peak the whole source
+    matrix, send and receive buffers for every row that moves (which
+    Epetra_DistObject keeps allocated for the life of the target), the
+    target rows allocated one at a time, and the contiguous copy of them
+    that FillComplete() makes.  For a matrix that mostly moves, as when it
+    is read on one processor, that is several times its size.
+
+    Epetra_ChunkedMigration moves at most chunkRows local rows per
+    processor at a time:
+
+    - the exact length of every target row is exchanged first (one integer
+      per row), so the target is allocated once with a static profile and
+      FillComplete() finds its storage already contiguous;
+    - each chunk is copied into a small matrix on the chunk's rows and
+      exported on its own, so the communication buffers never exceed one
+      chunk.
+
+    The source is either an existing matrix, which must stay alive until
+    Migrate() returns and can be deleted right after, or rows staged
+    through InsertGlobalValues() by a reader or generator that produces the
+    matrix on the wrong distribution.  An existing matrix is only read, so
+    the whole source and the whole target are alive together at the end of
+    Migrate(): the saving is in the buffers and the FillComplete() copy
+    only.  Staged rows are stored compactly per chunk and each chunk is
+    released as soon as it has been sent, so with staging source and
+    target together take little more than one copy of the matrix.
+
+    Staged rows must be inserted whole, or in consecutive calls for the
+    same row.  A row may be staged on several processors; its pieces are
+    summed, as with an Export in Add mode.
+ **/
+
+#ifndef EPETRA_CHUNKEDMIGRATION_HPP
+#define EPETRA_CHUNKEDMIGRATION_HPP
+
+#include <vector>
+#include <deque>
+#include <algorithm>
+
+#include "Epetra_ConfigDefs.h"
+#include "Epetra_Comm.h"
+#include "Epetra_Map.h"
+#include "Epetra_Export.h"
+#include "Epetra_IntVector.h"
+#include "Epetra_CrsMatrix.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+
+template<class GO = int>
+class Epetra_ChunkedMigration {
+
+ public:
+
+  /** \brief Constructor for rows staged with InsertGlobalValues()
+
+      \param  comm       [in]    communicator of the source and target maps
+      \param  chunkRows  [in]    maximum number of local rows sent at once
+   */
+  Epetra_ChunkedMigration(const Epetra_Comm & comm, int chunkRows = 4096)
+    : comm_(comm), source_(0), chunkRows_(chunkRows)
+  {}
+
+  /** \brief Constructor for the rows of an existing matrix
+
+      \param  source     [in]    matrix to redistribute; must outlive Migrate()
+      \param  chunkRows  [in]    maximum number of local rows sent at once
+   */
+  Epetra_ChunkedMigration(const Epetra_CrsMatrix & source, int chunkRows = 4096)
+    : comm_(source.Comm()), source_(&source), chunkRows_(chunkRows)
+  {}
+
+  /** \brief Stage entries of a row of the source (first constructor only)
+
+      \return  0, or -1 if the source is an existing matrix
+   */
+  int InsertGlobalValues(GO globalRow, int numEntries, const double * values, const GO * indices) {
+    if (source_ != 0) EPETRA_CHK_ERR(-1);
+    Chunk * c = chunks_.empty() ? 0 : &chunks_.back();
+    if (c == 0 || c->rows.empty() || c->rows.back() != globalRow) {
+      if (c == 0 || (int)c->rows.size() == chunkRows_) {
+        if (c != 0) Compact(*c);
+        chunks_.push_back(Chunk());
+        c = &chunks_.back();
+        c->ptr.push_back(0);
+      }
+      c->rows.push_back(globalRow);
+      c->ptr.push_back(c->ptr.back());
+    }
+    c->indices.insert(c->indices.end(), indices, indices + numEntries);
+    c->values.insert(c->values.end(), values, values + numEntries);
+    c->ptr.back() += numEntries;
+    return(0);
+  }
+
+  /** \brief Redistribute the source rows to targetMap (collective).
+
+      \param  targetMap  [in]    row map of the result
+      \param  domainMap  [in]    domain map of the result
+      \param  rangeMap   [in]    range map of the result
+      \param  target     [out]   new fill-complete matrix, owned by the caller;
+                                 0 on error
+      \return  0, or the first nonzero Epetra error code
+   */
+  int Migrate(const Epetra_Map & targetMap, const Epetra_Map & domainMap,
+              const Epetra_Map & rangeMap, Epetra_CrsMatrix *& target) {
+    target = 0;
+    GO indexBase = (GO)targetMap.IndexBase64();
+    int numMyChunks = NumMyChunks();
+    int numChunks;
+    EPETRA_CHK_ERR(comm_.MaxAll(&numMyChunks, &numChunks, 1));
+
+    // Exact target row lengths, then the target with a static profile
+    Epetra_IntVector targetLengths(targetMap);
+    {
+      std::vector<GO> rows;
+      std::vector<int> lengths;
+      for (int c=0; c<numMyChunks; c++) ChunkRows(c, rows, lengths);
+      Epetra_Map sourceMap((GO)-1, (int)rows.size(), Ptr(rows), indexBase, comm_);
+      Epetra_IntVector sourceLengths(Copy, sourceMap, Ptr(lengths));
+      Epetra_Export exporter(sourceMap, targetMap);
+      EPETRA_CHK_ERR(GlobalError(targetLengths.Export(sourceLengths, exporter, Add)));
+    }
+    target = new Epetra_CrsMatrix(Copy, targetMap, targetLengths.Values(), true);
+
+    // Errors are agreed on after every step, so that all processors keep
+    // calling the same collectives
+    int ierr = 0;
+    for (int c=0; c<numChunks && ierr == 0; c++) {
+      std::vector<GO> rows;
+      std::vector<int> lengths;
+      if (c < numMyChunks) ChunkRows(c, rows, lengths);
+      Epetra_Map chunkMap((GO)-1, (int)rows.size(), Ptr(rows), indexBase, comm_);
+      Epetra_CrsMatrix chunk(Copy, chunkMap, Ptr(lengths), true);
+      ierr = GlobalError((c < numMyChunks) ? FillChunk(c, chunk) : 0);
+      if (ierr == 0) ierr = GlobalError(chunk.FillComplete(domainMap, chunkMap));
+      if (ierr == 0) {
+        Epetra_Export exporter(chunkMap, targetMap);
+        ierr = GlobalError(target->Export(chunk, exporter, Insert));
+      }
+    }
+    if (ierr == 0) ierr = GlobalError(target->FillComplete(domainMap, rangeMap));
+    chunks_.clear();
+    if (ierr != 0) {
+      delete target;
+      target = 0;
+      EPETRA_CHK_ERR(ierr);
+    }
+    return(0);
+  }
+
+  //! Migrate() with the target map as domain and range map (square matrices)
+  int Migrate(const Epetra_Map & targetMap, Epetra_CrsMatrix *& target) {
+    return(Migrate(targetMap, targetMap, targetMap, target));
+  }
+
+  //! Peak resident set size of this process in bytes (0 where unknown)
+  static double PeakRSS() {
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return(0.0);
+#ifdef __APPLE__
+    return((double)usage.ru_maxrss);
+#else
+    return(1024.0*usage.ru_maxrss);
+#endif
+#else
+    return(0.0);
+#endif
+  }
+
+ private:
+
+  // Staged rows of one chunk in CSR form
+  struct Chunk {
+    std::vector<GO> rows;
+    std::vector<int> ptr;
+    std::vector<GO> indices;
+    std::vector<double> values;
+  };
+
+  // The most negative error code of all processors, else the largest one
+  int GlobalError(int ierr) const {
+    int minErr, maxErr;
+    comm_.MinAll(&ierr, &minErr, 1);
+    comm_.MaxAll(&ierr, &maxErr, 1);
+    return((minErr < 0) ? minErr : maxErr);
+  }
+
+  int NumMyChunks() const {
+    if (source_ == 0) return((int)chunks_.size());
+    return((source_->NumMyRows() + chunkRows_ - 1)/chunkRows_);
+  }
+
+  // Append the global ids and lengths of the rows of local chunk c
+  void ChunkRows(int c, std::vector<GO> & rows, std::vector<int> & lengths) const {
+    if (source_ == 0) {
+      const Chunk & s = chunks_[c];
+      for (std::size_t r=0; r<s.rows.size(); r++) {
+        rows.push_back(s.rows[r]);
+        lengths.push_back(s.ptr[r+1] - s.ptr[r]);
+      }
+    }
+    else {
+      int end = std::min((c+1)*chunkRows_, source_->NumMyRows());
+      for (int i=c*chunkRows_; i<end; i++) {
+        rows.push_back((GO)source_->RowMap().GID64(i));
+        lengths.push_back(source_->NumMyEntries(i));
+      }
+    }
+  }
+
+  // Copy the rows of local chunk c into chunk; staged rows are released
+  int FillChunk(int c, Epetra_CrsMatrix & chunk) {
+    if (source_ == 0) {
+      Chunk & s = chunks_[c];
+      for (std::size_t r=0; r<s.rows.size(); r++)
+        EPETRA_CHK_ERR(chunk.InsertGlobalValues(s.rows[r], s.ptr[r+1] - s.ptr[r],
+                                                Ptr(s.values) + s.ptr[r], Ptr(s.indices) + s.ptr[r]));
+      Release(s);
+    }
+    else {
+      std::vector<double> values;
+      std::vector<GO> indices;
+      int end = std::min((c+1)*chunkRows_, source_->NumMyRows());
+      for (int i=c*chunkRows_; i<end; i++) {
+        GO row = (GO)source_->RowMap().GID64(i);
+        int length = source_->NumMyEntries(i), numEntries;
+        values.resize(length);
+        indices.resize(length);
+        EPETRA_CHK_ERR(source_->ExtractGlobalRowCopy(row, length, numEntries, Ptr(values), Ptr(indices)));
+        EPETRA_CHK_ERR(chunk.InsertGlobalValues(row, numEntries, Ptr(values), Ptr(indices)));
+      }
+    }
+    return(0);
+  }
+
+  // Drop the spare capacity of a full chunk
+  static void Compact(Chunk & s) {
+    std::vector<GO>(s.indices).swap(s.indices);
+    std::vector<double>(s.values).swap(s.values);
+  }
+
+  static void Release(Chunk & s) {
+    std::vector<GO>().swap(s.rows);
+    std::vector<int>().swap(s.ptr);
+    std::vector<GO>().swap(s.indices);
+    std::vector<double>().swap(s.values);
+  }
+
+  template<class T>
+  static T * Ptr(std::vector<T> & v) {return(v.empty() ? 0 : &v[0]);}
+
+  const Epetra_Comm & comm_;
+  const Epetra_CrsMatrix * source_;
+  int chunkRows_;
+
+  // Staged rows, chunkRows_ rows per chunk (deque: chunks are never moved)
+  std::deque<Chunk> chunks_;
+};
+
+#endif
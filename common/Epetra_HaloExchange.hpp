@@ -0,0 +1,548 @@
+//@HEADER
+// ************************************************************************
+//
+//               Epetra: Linear Algebra Services Package
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact Michael A. Heroux (maherou@sandia.gov)
+//
+// ************************************************************************
+//@HEADER
+
+/** \file   Epetra_HaloExchange.hpp
+    \brief  Matrix-vector product for an Epetra_CrsMatrix with a halo exchange
+            whose communication pattern is set up once and reused.
+
+    Epetra_CrsMatrix::Multiply() imports the off-processor entries of x through
+    an Epetra_Import, and every call posts a fresh set of receives and sends
+    for the same pattern.  For small local sizes that per-call setup is a
+    noticeable part of the matvec time.
+
+    Epetra_HaloExchange works out the pattern once from the column and domain
+    maps of the matrix (who sends which entries to whom) and then exchanges
+    with one of
+
+    - \c Import      : the matrix's own Epetra_Import (the current path),
+    - \c Persistent  : persistent requests created with MPI_Send_init and
+                       MPI_Recv_init, restarted with MPI_Startall each call,
+    - \c Neighbor    : MPI_Neighbor_alltoallv on a distributed-graph
+                       communicator (needs MPI-3),
+    - \c Shared      : ranks on the same node publish the owned entries their
+                       on-node neighbors read in an MPI_Win_allocate_shared
+                       window and read on-node ghosts straight out of it; only
+                       off-node ghosts go through persistent requests (needs
+                       MPI-3).
+
+    The send and receive buffers are sized for a fixed number of vectors, so
+    the same object is reused for every product with that many vectors.  The
+    local part of the product is a plain CSR loop over the column-map vector;
+    when the range map differs from the row map the row-map result is then
+    exported to Y with the matrix's Epetra_Export, as Multiply() does.
+
+    Only the non-transpose product is supported.
+ **/
+
+#ifndef EPETRA_HALOEXCHANGE_HPP
+#define EPETRA_HALOEXCHANGE_HPP
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstring>
+
+#include "Epetra_ConfigDefs.h"
+#include "Epetra_Comm.h"
+#include "Epetra_Map.h"
+#include "Epetra_Import.h"
+#include "Epetra_CrsMatrix.h"
+#include "Epetra_MultiVector.h"
+#include "Epetra_Time.h"
+#ifdef EPETRA_MPI
+#include "mpi.h"
+#include "Epetra_MpiComm.h"
+#endif
+
+
+class Epetra_HaloExchange {
+
+ public:
+
+  enum Method {Import, Persistent, Neighbor, Shared};
+
+  //! Parse "import", "persistent", "neighbor" or "shared"; returns -1 if the name is unknown
+  static int MethodFromString(const char * name, Method & method) {
+    if      (std::strcmp(name, "import") == 0)     method = Import;
+    else if (std::strcmp(name, "persistent") == 0) method = Persistent;
+    else if (std::strcmp(name, "neighbor") == 0)   method = Neighbor;
+    else if (std::strcmp(name, "shared") == 0)     method = Shared;
+    else return(-1);
+    return(0);
+  }
+
+  static const char * MethodName(Method method) {
+    if (method == Persistent) return("persistent");
+    if (method == Neighbor)   return("neighbor");
+    if (method == Shared)     return("shared");
+    return("import");
+  }
+
+  /** \brief Constructor.  Collective over the matrix communicator.
+
+      \param  A            [in]    matrix (FillComplete() must have been called);
+                                   must outlive this object
+      \param  numVectors   [in]    number of vectors in every Multiply()
+      \param  method       [in]    halo exchange method; without MPI, or with an
+                                   MPI older than 3.0 for \c Neighbor, the
+                                   matrix Import is used instead, and \c Shared
+                                   without MPI-3 uses \c Persistent
+   */
+  Epetra_HaloExchange(const Epetra_CrsMatrix & A, int numVectors, Method method)
+    : A_(A), numVectors_(numVectors), method_(method),
+      colX_(A.ColMap(), numVectors), rowY_(0), timer_(A.Comm()), haloTime_(0.0)
+  {
+    if (A.Exporter() != 0) rowY_ = new Epetra_MultiVector(A.RowMap(), numVectors);
+#ifdef EPETRA_MPI
+#if !defined(MPI_VERSION) || MPI_VERSION < 3
+    if (method_ == Neighbor) method_ = Import;
+    if (method_ == Shared)   method_ = Persistent;
+#endif
+    graphComm_ = MPI_COMM_NULL;
+    nodeComm_ = MPI_COMM_NULL;
+#else
+    method_ = Import;
+#endif
+    BuildPattern();
+  }
+
+  ~Epetra_HaloExchange() {
+    delete rowY_;
+#ifdef EPETRA_MPI
+    for (unsigned i=0; i<requests_.size(); i++) MPI_Request_free(&requests_[i]);
+#if defined(MPI_VERSION) && MPI_VERSION >= 3
+    if (graphComm_ != MPI_COMM_NULL) MPI_Comm_free(&graphComm_);
+    if (nodeComm_ != MPI_COMM_NULL) {
+      MPI_Win_unlock_all(win_);
+      MPI_Win_free(&win_);
+      MPI_Comm_free(&nodeComm_);
+    }
+#endif
+#endif
+  }
+
+  //! Method actually used (may differ from the requested one, see the constructor)
+  Method GetMethod() const {return(method_);}
+
+  //! Number of processors this processor receives from
+  int NumRecvNeighbors() const {return((int)recvProcs_.size());}
+
+  //! Number of processors this processor sends to
+  int NumSendNeighbors() const {return((int)sendProcs_.size());}
+
+  //! Number of vector entries (per vector) this processor sends per exchange
+  int NumSendEntries() const {return((int)sendLIDs_.size());}
+
+  //! Number of ghost entries (per vector) received in messages
+  int NumRecvEntries() const {return((int)recvLIDs_.size());}
+
+  //! Number of ghost entries (per vector) read from the shared-memory window
+  int NumSharedEntries() const {return((int)shmTo_.size());}
+
+  //! Accumulated wall time spent in the halo exchange
+  double HaloTime() const {return(haloTime_);}
+  void ResetHaloTime() {haloTime_ = 0.0;}
+
+  //! Fill the column-map copy of X (owned entries and ghosts)
+  int ExchangeHalo(const Epetra_MultiVector & X) {
+    if (X.NumVectors() != numVectors_) EPETRA_CHK_ERR(-1);
+    double t0 = timer_.WallTime();
+
+    if (method_ == Import) {
+      if (A_.Importer() != 0) {
+        EPETRA_CHK_ERR(colX_.Import(X, *A_.Importer(), Insert));
+      }
+      else
+        CopyLocal(X);
+      haloTime_ += timer_.WallTime() - t0;
+      return(0);
+    }
+
+#ifdef EPETRA_MPI
+    const int nv = numVectors_;
+    for (unsigned i=0; i<sendLIDs_.size(); i++)
+      for (int v=0; v<nv; v++) sendBuf_[i*nv+v] = X[v][sendLIDs_[i]];
+
+    if (method_ == Persistent || method_ == Shared) {
+      if (requests_.size() > 0) MPI_Startall((int)requests_.size(), &requests_[0]);
+      CopyLocal(X);  // overlap the owned entries with the messages in flight
+#if defined(MPI_VERSION) && MPI_VERSION >= 3
+      if (method_ == Shared) ReadShared(X);
+#endif
+      if (requests_.size() > 0) MPI_Waitall((int)requests_.size(), &requests_[0], MPI_STATUSES_IGNORE);
+    }
+#if defined(MPI_VERSION) && MPI_VERSION >= 3
+    else {
+      MPI_Neighbor_alltoallv(&sendBuf_[0], &sendCounts_[0], &sendDispls_[0], MPI_DOUBLE,
+                             &recvBuf_[0], &recvCounts_[0], &recvDispls_[0], MPI_DOUBLE,
+                             graphComm_);
+      CopyLocal(X);
+    }
+#endif
+
+    for (unsigned i=0; i<recvLIDs_.size(); i++)
+      for (int v=0; v<nv; v++) colX_[v][recvLIDs_[i]] = recvBuf_[i*nv+v];
+#endif
+    haloTime_ += timer_.WallTime() - t0;
+    return(0);
+  }
+
+  //! Y = A*X; Y is on the range map of A
+  int Multiply(const Epetra_MultiVector & X, Epetra_MultiVector & Y) {
+    if (Y.NumVectors() != numVectors_) EPETRA_CHK_ERR(-1);
+    EPETRA_CHK_ERR(ExchangeHalo(X));
+
+    // Rows not laid out as the range map: compute on the row map, then export
+    Epetra_MultiVector & rowY = (rowY_ != 0) ? *rowY_ : Y;
+
+    int numRows = A_.NumMyRows();
+    int * rowPtr;
+    int * colInd;
+    double * vals;
+    bool haveCrs = (A_.ExtractCrsDataPointers(rowPtr, colInd, vals) == 0);
+
+    for (int v=0; v<numVectors_; v++) {
+      const double * x = colX_[v];
+      double * y = rowY[v];
+      for (int i=0; i<numRows; i++) {
+        int numEntries;
+        if (haveCrs) {
+          numEntries = rowPtr[i+1] - rowPtr[i];
+          const int * inds = colInd + rowPtr[i];
+          const double * rowVals = vals + rowPtr[i];
+          double sum = 0.0;
+          for (int k=0; k<numEntries; k++) sum += rowVals[k]*x[inds[k]];
+          y[i] = sum;
+        }
+        else {
+          int * inds;
+          double * rowVals;
+          A_.ExtractMyRowView(i, numEntries, rowVals, inds);
+          double sum = 0.0;
+          for (int k=0; k<numEntries; k++) sum += rowVals[k]*x[inds[k]];
+          y[i] = sum;
+        }
+      }
+    }
+
+    if (rowY_ != 0) {
+      Y.PutScalar(0.0);
+      EPETRA_CHK_ERR(Y.Export(*rowY_, *A_.Exporter(), Add));
+    }
+    return(0);
+  }
+
+ private:
+
+  // Copy the owned entries of X into the column-map vector
+  void CopyLocal(const Epetra_MultiVector & X) {
+    for (int v=0; v<numVectors_; v++) {
+      const double * x = X[v];
+      double * cx = colX_[v];
+      for (unsigned i=0; i<localTo_.size(); i++) cx[localTo_[i]] = x[localFrom_[i]];
+    }
+  }
+
+#if defined(EPETRA_MPI) && defined(MPI_VERSION) && MPI_VERSION >= 3
+  // Publish the owned entries that node processors read in one of the two
+  // buffers of our window segment and copy the on-node ghosts out of the
+  // neighbors' segments.  The buffers alternate between calls: a neighbor
+  // reads a buffer before it enters the next call's barrier, and we write
+  // that buffer again only after that barrier, so one barrier is enough.
+  void ReadShared(const Epetra_MultiVector & X) {
+    const int nv = numVectors_;
+    const int len = (int)shmSendLIDs_.size();
+    double * buf = shmBase_ + shmParity_*nv*len;
+    for (int v=0; v<nv; v++) {
+      const double * x = X[v];
+      for (int i=0; i<len; i++) buf[v*len+i] = x[shmSendLIDs_[i]];
+    }
+    MPI_Win_sync(win_);
+    MPI_Barrier(nodeComm_);
+    MPI_Win_sync(win_);
+    for (int v=0; v<nv; v++) {
+      double * cx = colX_[v];
+      for (unsigned i=0; i<shmTo_.size(); i++) {
+        int q = shmOwner_[i];
+        cx[shmTo_[i]] = peerBase_[q][(shmParity_*nv + v)*peerLen_[q] + shmFrom_[i]];
+      }
+    }
+    shmParity_ = 1 - shmParity_;
+  }
+#endif
+
+  // Work out which column-map entries come from which processor, tell the
+  // owners which of their entries to send, and register the exchange.
+  void BuildPattern() {
+    const Epetra_Map & colMap = A_.ColMap();
+    const Epetra_Map & domainMap = A_.DomainMap();
+
+    std::vector<int> remoteGIDs, remoteLIDs;
+    for (int lid=0; lid<colMap.NumMyElements(); lid++) {
+      int gid = colMap.GID(lid);
+      int dlid = domainMap.LID(gid);
+      if (dlid >= 0) {
+        localFrom_.push_back(dlid);
+        localTo_.push_back(lid);
+      }
+      else {
+        remoteGIDs.push_back(gid);
+        remoteLIDs.push_back(lid);
+      }
+    }
+
+#ifdef EPETRA_MPI
+    if (method_ == Import) return;
+
+    MPI_Comm comm = dynamic_cast<const Epetra_MpiComm &>(A_.Comm()).Comm();
+    int numProc = A_.Comm().NumProc();
+    int numRemote = (int)remoteGIDs.size();
+
+    // Owners of the ghost entries (RemoteIDList is collective)
+    std::vector<int> remotePIDs(numRemote+1), ownerLIDs(numRemote+1);
+    remoteGIDs.push_back(0);
+    domainMap.RemoteIDList(numRemote, &remoteGIDs[0], &remotePIDs[0], &ownerLIDs[0]);
+
+#if defined(MPI_VERSION) && MPI_VERSION >= 3
+    // Ghosts owned by a processor on this node are read from the window
+    if (method_ == Shared) {
+      MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &nodeComm_);
+      std::vector<int> worldRanks(numProc), nodeRanks(numProc);
+      MPI_Group group, nodeGroup;
+      MPI_Comm_group(comm, &group);
+      MPI_Comm_group(nodeComm_, &nodeGroup);
+      for (int p=0; p<numProc; p++) worldRanks[p] = p;
+      MPI_Group_translate_ranks(group, numProc, &worldRanks[0], nodeGroup, &nodeRanks[0]);
+      MPI_Group_free(&group);
+      MPI_Group_free(&nodeGroup);
+
+      int k = 0;
+      for (int j=0; j<numRemote; j++) {
+        int q = nodeRanks[remotePIDs[j]];
+        if (q != MPI_UNDEFINED) {
+          shmOwner_.push_back(q);
+          shmFrom_.push_back(ownerLIDs[j]);
+          shmTo_.push_back(remoteLIDs[j]);
+        }
+        else {
+          remoteGIDs[k] = remoteGIDs[j];
+          remoteLIDs[k] = remoteLIDs[j];
+          remotePIDs[k] = remotePIDs[j];
+          k++;
+        }
+      }
+      numRemote = k;
+      BuildShared();
+    }
+#endif
+
+    // Receive order: grouped by owner, column order within each owner
+    std::vector<std::pair<int,int> > order(numRemote);
+    for (int k=0; k<numRemote; k++) order[k] = std::make_pair(remotePIDs[k], k);
+    std::sort(order.begin(), order.end());
+
+    std::vector<int> recvFrom(numProc, 0), sendTo(numProc, 0);
+    std::vector<int> reqGIDs(numRemote+1);
+    for (int k=0; k<numRemote; k++) {
+      recvFrom[order[k].first]++;
+      reqGIDs[k] = remoteGIDs[order[k].second];
+      recvLIDs_.push_back(remoteLIDs[order[k].second]);
+    }
+
+    // Tell each owner which of its entries we need
+    MPI_Alltoall(&recvFrom[0], 1, MPI_INT, &sendTo[0], 1, MPI_INT, comm);
+    std::vector<int> recvDisplsAll(numProc, 0), sendDisplsAll(numProc, 0);
+    for (int p=1; p<numProc; p++) {
+      recvDisplsAll[p] = recvDisplsAll[p-1] + recvFrom[p-1];
+      sendDisplsAll[p] = sendDisplsAll[p-1] + sendTo[p-1];
+    }
+    int numSend = sendDisplsAll[numProc-1] + sendTo[numProc-1];
+    std::vector<int> sendGIDs(numSend+1);
+    MPI_Alltoallv(&reqGIDs[0], &recvFrom[0], &recvDisplsAll[0], MPI_INT,
+                  &sendGIDs[0], &sendTo[0], &sendDisplsAll[0], MPI_INT, comm);
+    for (int i=0; i<numSend; i++) sendLIDs_.push_back(domainMap.LID(sendGIDs[i]));
+
+    // Neighbor lists, counts and displacements in doubles
+    const int nv = numVectors_;
+    for (int p=0; p<numProc; p++) {
+      if (recvFrom[p] > 0) {
+        recvProcs_.push_back(p);
+        recvCounts_.push_back(recvFrom[p]*nv);
+        recvDispls_.push_back(recvDisplsAll[p]*nv);
+      }
+      if (sendTo[p] > 0) {
+        sendProcs_.push_back(p);
+        sendCounts_.push_back(sendTo[p]*nv);
+        sendDispls_.push_back(sendDisplsAll[p]*nv);
+      }
+    }
+    sendBuf_.resize(numSend*nv+1);
+    recvBuf_.resize(numRemote*nv+1);
+
+    if (method_ == Persistent || method_ == Shared) {
+      const int tag = 2001;
+      requests_.resize(recvProcs_.size() + sendProcs_.size());
+      int r = 0;
+      for (unsigned j=0; j<recvProcs_.size(); j++, r++)
+        MPI_Recv_init(&recvBuf_[recvDispls_[j]], recvCounts_[j], MPI_DOUBLE,
+                      recvProcs_[j], tag, comm, &requests_[r]);
+      for (unsigned j=0; j<sendProcs_.size(); j++, r++)
+        MPI_Send_init(&sendBuf_[sendDispls_[j]], sendCounts_[j], MPI_DOUBLE,
+                      sendProcs_[j], tag, comm, &requests_[r]);
+    }
+#if defined(MPI_VERSION) && MPI_VERSION >= 3
+    else {
+      // keep &v[0] valid for processors without neighbors
+      recvProcs_.push_back(0); recvCounts_.push_back(0); recvDispls_.push_back(0);
+      sendProcs_.push_back(0); sendCounts_.push_back(0); sendDispls_.push_back(0);
+      MPI_Dist_graph_create_adjacent(comm,
+                                     (int)recvProcs_.size()-1, &recvProcs_[0], MPI_UNWEIGHTED,
+                                     (int)sendProcs_.size()-1, &sendProcs_[0], MPI_UNWEIGHTED,
+                                     MPI_INFO_NULL, 0, &graphComm_);
+      recvProcs_.pop_back(); sendProcs_.pop_back();
+    }
+#endif
+#endif
+  }
+
+#if defined(EPETRA_MPI) && defined(MPI_VERSION) && MPI_VERSION >= 3
+  // Tell each node processor which of its entries we read (shmFrom_ holds
+  // owner LIDs on entry).  Each processor publishes the union of the entries
+  // asked of it, in LID order, and sends back where each one sits, which
+  // replaces the LIDs in shmFrom_.  Then allocate this processor's segment of
+  // the node window (two buffers, one column per vector) and look up where
+  // the other segments are mapped.
+  void BuildShared() {
+    int nodeSize;
+    MPI_Comm_size(nodeComm_, &nodeSize);
+    int numShm = (int)shmTo_.size();
+
+    std::vector<std::pair<int,int> > order(numShm);
+    for (int k=0; k<numShm; k++) order[k] = std::make_pair(shmOwner_[k], k);
+    std::sort(order.begin(), order.end());
+    std::vector<int> reqCounts(nodeSize, 0), askCounts(nodeSize, 0), reqLIDs(numShm+1);
+    for (int k=0; k<numShm; k++) {
+      reqCounts[order[k].first]++;
+      reqLIDs[k] = shmFrom_[order[k].second];
+    }
+    MPI_Alltoall(&reqCounts[0], 1, MPI_INT, &askCounts[0], 1, MPI_INT, nodeComm_);
+    std::vector<int> reqDispls(nodeSize, 0), askDispls(nodeSize, 0);
+    for (int q=1; q<nodeSize; q++) {
+      reqDispls[q] = reqDispls[q-1] + reqCounts[q-1];
+      askDispls[q] = askDispls[q-1] + askCounts[q-1];
+    }
+    int numAsked = askDispls[nodeSize-1] + askCounts[nodeSize-1];
+    std::vector<int> askLIDs(numAsked+1);
+    MPI_Alltoallv(&reqLIDs[0], &reqCounts[0], &reqDispls[0], MPI_INT,
+                  &askLIDs[0], &askCounts[0], &askDispls[0], MPI_INT, nodeComm_);
+
+    shmSendLIDs_.assign(askLIDs.begin(), askLIDs.begin()+numAsked);
+    std::sort(shmSendLIDs_.begin(), shmSendLIDs_.end());
+    shmSendLIDs_.erase(std::unique(shmSendLIDs_.begin(), shmSendLIDs_.end()), shmSendLIDs_.end());
+    std::vector<int> askPos(numAsked+1), reqPos(numShm+1);
+    for (int i=0; i<numAsked; i++)
+      askPos[i] = (int)(std::lower_bound(shmSendLIDs_.begin(), shmSendLIDs_.end(), askLIDs[i])
+                        - shmSendLIDs_.begin());
+    MPI_Alltoallv(&askPos[0], &askCounts[0], &askDispls[0], MPI_INT,
+                  &reqPos[0], &reqCounts[0], &reqDispls[0], MPI_INT, nodeComm_);
+    for (int k=0; k<numShm; k++) shmFrom_[order[k].second] = reqPos[k];
+
+    MPI_Aint bytes = (MPI_Aint)2*shmSendLIDs_.size()*numVectors_*sizeof(double);
+    MPI_Win_allocate_shared(bytes, sizeof(double), MPI_INFO_NULL, nodeComm_, &shmBase_, &win_);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, win_);
+    shmParity_ = 0;
+
+    peerBase_.resize(nodeSize);
+    peerLen_.resize(nodeSize);
+    for (int q=0; q<nodeSize; q++) {
+      MPI_Aint size;
+      int dispUnit;
+      MPI_Win_shared_query(win_, q, &size, &dispUnit, &peerBase_[q]);
+      peerLen_[q] = (int)(size/(2*numVectors_*sizeof(double)));
+    }
+  }
+#endif
+
+  // Not copyable (the persistent requests point into this object's buffers)
+  Epetra_HaloExchange(const Epetra_HaloExchange &);
+  Epetra_HaloExchange & operator=(const Epetra_HaloExchange &);
+
+  const Epetra_CrsMatrix & A_;
+  int numVectors_;
+  Method method_;
+  Epetra_MultiVector colX_;
+  Epetra_MultiVector * rowY_;  // row-map result, only when A has an Exporter
+  Epetra_Time timer_;
+  double haloTime_;
+
+  // Owned entries: colX_[localTo_[i]] = X[localFrom_[i]]
+  std::vector<int> localFrom_;
+  std::vector<int> localTo_;
+
+  // Ghost entries, in receive order, and the domain-map entries we send
+  std::vector<int> recvLIDs_;
+  std::vector<int> sendLIDs_;
+
+  std::vector<int> recvProcs_, recvCounts_, recvDispls_;
+  std::vector<int> sendProcs_, sendCounts_, sendDispls_;
+  std::vector<double> sendBuf_;
+  std::vector<double> recvBuf_;
+
+#ifdef EPETRA_MPI
+  std::vector<MPI_Request> requests_;
+  MPI_Comm graphComm_;
+
+  // Node window: our segment, the owned entries published in it, the buffer
+  // written next, every node processor's segment and its length (per buffer
+  // and vector), and the on-node ghosts
+  // colX_[shmTo_[i]] = segment shmOwner_[i], entry shmFrom_[i]
+  MPI_Comm nodeComm_;
+  MPI_Win win_;
+  double * shmBase_;
+  std::vector<int> shmSendLIDs_;
+  int shmParity_;
+  std::vector<double *> peerBase_;
+  std::vector<int> peerLen_;
+  std::vector<int> shmOwner_, shmFrom_, shmTo_;
+#endif
+};
+
+#endif
@@ -0,0 +1,252 @@
+//@HEADER
+// ************************************************************************
+//
+//               Epetra: Linear Algebra Services Package
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact Michael A. Heroux (maherou@sandia.gov)
+//
+// ************************************************************************
+//@HEADER
+
+/** \file   Epetra_IntervalMap.hpp
+    \brief  Compressed storage of an arbitrary global id list as contiguous
+            intervals, with an optional replicated range directory.
+
+    An Epetra_Map built from a list of global ids keeps the whole list, a
+    GID to LID hash table with one node per id, and, once RemoteIDList() is
+    called, a distributed directory with another entry per id that costs an
+    all-to-all exchange to build.  Lists produced by 2D block partitionings
+    (GenerateMyGlobalElements) or by owner-numbered mesh entities are a few
+    contiguous runs per processor, so all of this can be stored per run
+    instead of per id:
+
+    - the local list is stored as runs (first GID, first LID); GID(lid) and
+      LID(gid) are binary searches over the runs,
+    - the directory is the list of all runs of all processors, sorted by
+      first GID and replicated; it is built with two GatherAll calls and
+      RemoteIDList() needs no communication at all.
+
+    The directory holds every run of every processor on every processor, so
+    it is only built on request (constructor argument or BuildDirectory());
+    maps that never look up remote owners keep just their own runs.
+
+    The memory is proportional to the number of runs, so the class pays off
+    when the runs are long; BytesUsed() and NumGlobalRuns() tell how well a
+    given list compresses.  As for Epetra_Map, each global id must be owned
+    by one processor.
+ **/
+
+#ifndef EPETRA_INTERVALMAP_HPP
+#define EPETRA_INTERVALMAP_HPP
+
+#include <vector>
+#include <algorithm>
+
+#include "Epetra_ConfigDefs.h"
+#include "Epetra_Comm.h"
+
+
+template<class GO = int>
+class Epetra_IntervalMap {
+
+ public:
+
+  /** \brief Constructor (collective)
+
+      \param  numMyElements    [in]    length of the local global id list
+      \param  myGlobalElements [in]    local global ids, in local id order
+      \param  comm             [in]    communicator of the map
+      \param  buildDirectory   [in]    build the replicated directory now, for RemoteIDList()
+   */
+  Epetra_IntervalMap(int numMyElements, const GO * myGlobalElements, const Epetra_Comm & comm,
+                     bool buildDirectory = false)
+    : comm_(comm), numMyElements_(numMyElements), numGlobalRuns_(0), haveDirectory_(false)
+  {
+    // Split the list into maximal runs of consecutive ids
+    for (int i=0; i<numMyElements; i++) {
+      if (i==0 || myGlobalElements[i] != myGlobalElements[i-1]+1) {
+        runStart_.push_back(myGlobalElements[i]);
+        runLID_.push_back(i);
+      }
+    }
+    runLID_.push_back(numMyElements);
+
+    int numRuns = NumMyRuns();
+    order_.resize(numRuns);
+    for (int r=0; r<numRuns; r++) order_[r] = r;
+    std::sort(order_.begin(), order_.end(), RunLess(runStart_));
+
+    comm.SumAll(&numRuns, &numGlobalRuns_, 1);
+    if (buildDirectory) BuildDirectory();
+  }
+
+  /** \brief Build the replicated directory used by RemoteIDList() (collective).
+
+      Does nothing if the directory has already been built.
+   */
+  void BuildDirectory() {
+    if (haveDirectory_) return;
+    GatherDirectory();
+    haveDirectory_ = true;
+  }
+
+  //! Whether the directory has been built
+  bool HaveDirectory() const {return(haveDirectory_);}
+
+  //! Number of local global ids
+  int NumMyElements() const {return(numMyElements_);}
+
+  //! Number of runs of the local list
+  int NumMyRuns() const {return((int)runStart_.size());}
+
+  //! Number of runs of all processors (the directory length)
+  int NumGlobalRuns() const {return(numGlobalRuns_);}
+
+  //! Global id of local id \c lid, or -1
+  GO GID(int lid) const {
+    if (lid < 0 || lid >= numMyElements_) return(-1);
+    int r = (int)(std::upper_bound(runLID_.begin(), runLID_.end()-1, lid) - runLID_.begin()) - 1;
+    return(runStart_[r] + (lid - runLID_[r]));
+  }
+
+  //! Local id of global id \c gid, or -1 if it is not local
+  int LID(GO gid) const {
+    int lo = 0, hi = (int)order_.size();
+    while (lo < hi) {   // first sorted run starting after gid
+      int mid = (lo + hi)/2;
+      if (runStart_[order_[mid]] <= gid) lo = mid+1;
+      else hi = mid;
+    }
+    if (lo == 0) return(-1);
+    int r = order_[lo-1];
+    GO offset = gid - runStart_[r];
+    if (offset >= runLID_[r+1] - runLID_[r]) return(-1);
+    return(runLID_[r] + (int)offset);
+  }
+
+  bool MyGID(GO gid) const {return(LID(gid) >= 0);}
+
+  /** \brief Owning processor and local id of each of \c gids (no communication).
+
+      \return  0, 1 if some ids belong to no processor (their pid and lid are -1),
+               as Epetra_BlockMap::RemoteIDList, or -1 if the directory has not
+               been built
+   */
+  int RemoteIDList(int numIDs, const GO * gids, int * pids, int * lids) const {
+    if (!haveDirectory_) EPETRA_CHK_ERR(-1);
+    int ierr = 0;
+    for (int i=0; i<numIDs; i++) {
+      int d = (int)(std::upper_bound(dirStart_.begin(), dirStart_.end(), gids[i]) - dirStart_.begin()) - 1;
+      if (d < 0 || gids[i] - dirStart_[d] >= dirLength_[d]) {
+        pids[i] = lids[i] = -1;
+        ierr = 1;
+        continue;
+      }
+      pids[i] = dirPID_[d];
+      lids[i] = dirLID_[d] + (int)(gids[i] - dirStart_[d]);
+    }
+    return(ierr);
+  }
+
+  //! Bytes held by the local runs and the directory on this processor
+  double BytesUsed() const {
+    return((double)runStart_.size()*(sizeof(GO) + 2*sizeof(int)) + sizeof(int) +
+           (double)dirStart_.size()*(sizeof(GO) + 3*sizeof(int)));
+  }
+
+ private:
+
+  // Orders run indices by their first global id
+  struct RunLess {
+    RunLess(const std::vector<GO> & start) : start_(start) {}
+    bool operator()(int a, int b) const {return(start_[a] < start_[b]);}
+    const std::vector<GO> & start_;
+  };
+
+  // Gather the runs of all processors (padded to the longest run list) and sort them
+  void GatherDirectory() {
+    const Epetra_Comm & comm = comm_;
+    int numProc = comm.NumProc();
+    int numRuns = NumMyRuns(), maxRuns = 0;
+    comm.MaxAll(&numRuns, &maxRuns, 1);
+    if (maxRuns == 0) return;
+
+    std::vector<GO> myStart(maxRuns, 0), allStart(maxRuns*numProc);
+    std::vector<int> myRun(2*maxRuns, -1), allRun(2*maxRuns*numProc);
+    for (int r=0; r<numRuns; r++) {
+      myStart[r] = runStart_[r];
+      myRun[2*r] = runLID_[r+1] - runLID_[r];
+      myRun[2*r+1] = runLID_[r];
+    }
+    comm.GatherAll(&myStart[0], &allStart[0], maxRuns);
+    comm.GatherAll(&myRun[0], &allRun[0], 2*maxRuns);
+
+    std::vector<int> entries;
+    for (int k=0; k<maxRuns*numProc; k++)
+      if (allRun[2*k] > 0) entries.push_back(k);
+    std::sort(entries.begin(), entries.end(), RunLess(allStart));
+
+    int numEntries = (int)entries.size();
+    dirStart_.resize(numEntries);
+    dirLength_.resize(numEntries);
+    dirPID_.resize(numEntries);
+    dirLID_.resize(numEntries);
+    for (int d=0; d<numEntries; d++) {
+      int k = entries[d];
+      dirStart_[d] = allStart[k];
+      dirLength_[d] = allRun[2*k];
+      dirLID_[d] = allRun[2*k+1];
+      dirPID_[d] = k/maxRuns;
+    }
+  }
+
+  const Epetra_Comm & comm_;
+  int numMyElements_;
+  int numGlobalRuns_;
+  bool haveDirectory_;
+
+  // Local runs in list order: run r holds ids runStart_[r], ... for local ids
+  // runLID_[r] .. runLID_[r+1]-1; order_ sorts the runs by first id
+  std::vector<GO> runStart_;
+  std::vector<int> runLID_;
+  std::vector<int> order_;
+
+  // Runs of all processors, sorted by first id
+  std::vector<GO> dirStart_;
+  std::vector<int> dirLength_;
+  std::vector<int> dirPID_;
+  std::vector<int> dirLID_;
+};
+
+#endif
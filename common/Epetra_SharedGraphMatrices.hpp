@@ -0,0 +1,263 @@
+//@HEADER
+// ************************************************************************
+//
+//               Epetra: Linear Algebra Services Package
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact Michael A. Heroux (maherou@sandia.gov)
+//
+// ************************************************************************
+//@HEADER
+
+/** \file   Epetra_SharedGraphMatrices.hpp
+    \brief  A family of matrices with one sparsity pattern, stored as value
+            arrays over a single Epetra_CrsGraph, with a fused apply of any
+            linear combination of them.
+
+    Mass and stiffness matrices from one discretization have the same graph.
+    Applying (a*M + b*K) x as two Multiply() calls reads the column indices
+    and the imported x twice and does two halo exchanges.  This class reads
+    the indices in place from the graph (Epetra_CrsGraph copies share their
+    data, so nothing is duplicated) and keeps one value array per matrix, so
+
+    \verbatim
+      Apply(c, X, Y)    Y = sum_k c[k] A_k X
+    \endverbatim
+
+    makes one halo exchange and one pass over the indices, and
+
+    \verbatim
+      Combine(c, C)     C = sum_k c[k] A_k
+    \endverbatim
+
+    overwrites only the values of a matrix C built on Graph(), with no graph
+    work at all.
+
+    Matrices are added with AddMatrix(), which checks that the pattern and the
+    column map match Graph() and copies the values.  The family therefore
+    holds a full value array per matrix; it saves memory over separate
+    matrices only once the source matrices are released, and then only the
+    per-matrix index arrays.  Values(k) gives direct access to the value array
+    of matrix k (in the row-by-row order of the graph) for re-assembly in place.
+ **/
+
+#ifndef EPETRA_SHAREDGRAPHMATRICES_HPP
+#define EPETRA_SHAREDGRAPHMATRICES_HPP
+
+#include <vector>
+
+#include "Epetra_ConfigDefs.h"
+#include "Epetra_CrsGraph.h"
+#include "Epetra_CrsMatrix.h"
+#include "Epetra_MultiVector.h"
+#include "Epetra_Import.h"
+#include "Epetra_Export.h"
+
+
+class Epetra_SharedGraphMatrices {
+
+ public:
+
+  /** \brief Constructor
+
+      \param  graph    [in]    filled graph shared by all matrices of the family
+   */
+  Epetra_SharedGraphMatrices(const Epetra_CrsGraph & graph)
+    : graph_(graph), importX_(0), exportY_(0)
+  {
+    int numRows = graph_.NumMyRows();
+    rowPtr_.resize(numRows+1, 0);
+    for (int i=0; i<numRows; i++) rowPtr_[i+1] = rowPtr_[i] + graph_.NumMyIndices(i);
+  }
+
+  ~Epetra_SharedGraphMatrices() {
+    delete importX_;
+    delete exportY_;
+  }
+
+  //! The shared graph; build matrices for Combine() with Epetra_CrsMatrix(Copy, Graph())
+  const Epetra_CrsGraph & Graph() const {return(graph_);}
+
+  //! Number of matrices in the family
+  int NumMatrices() const {return((int)values_.size());}
+
+  //! Value array of matrix \c k, ordered like the local rows of Graph()
+  double * Values(int k) {return(&values_[k][0]);}
+
+  /** \brief Copy the values of \c A into the family.
+
+      \return  index of the new matrix, -1 if A is not filled, -2 if its
+               column map or sparsity pattern differs from Graph()
+   */
+  int AddMatrix(const Epetra_CrsMatrix & A) {
+    if (!A.Filled()) EPETRA_CHK_ERR(-1);
+    if (A.NumMyRows() != graph_.NumMyRows() || !A.ColMap().SameAs(graph_.ColMap())) EPETRA_CHK_ERR(-2);
+
+    std::vector<double> vals(rowPtr_[graph_.NumMyRows()]+1);
+    for (int i=0; i<A.NumMyRows(); i++) {
+      int numEntries, numGraphEntries;
+      int * inds;
+      int * graphInds;
+      double * rowVals;
+      A.ExtractMyRowView(i, numEntries, rowVals, inds);
+      graph_.ExtractMyRowView(i, numGraphEntries, graphInds);
+      if (numEntries != numGraphEntries) EPETRA_CHK_ERR(-2);
+      for (int j=0; j<numEntries; j++) {
+        if (inds[j] != graphInds[j]) EPETRA_CHK_ERR(-2);
+        vals[rowPtr_[i]+j] = rowVals[j];
+      }
+    }
+    values_.push_back(vals);
+    return(NumMatrices()-1);
+  }
+
+  /** \brief Y = sum_k coeffs[k] A_k X, with one halo exchange and one pass
+             over the indices.
+
+      \param  coeffs   [in]    one coefficient per matrix
+      \param  X        [in]    vectors in the domain map of Graph()
+      \param  Y        [out]   vectors in the range map of Graph()
+   */
+  int Apply(const double * coeffs, const Epetra_MultiVector & X, Epetra_MultiVector & Y) const {
+    int numVectors = X.NumVectors();
+    if (Y.NumVectors() != numVectors) EPETRA_CHK_ERR(-1);
+    int numMats = NumMatrices();
+    int numRows = graph_.NumMyRows();
+
+    const Epetra_MultiVector * Xcol = &X;
+    if (graph_.Importer() != 0) {
+      if (importX_ == 0 || importX_->NumVectors() != numVectors) {
+        delete importX_;
+        importX_ = new Epetra_MultiVector(graph_.ColMap(), numVectors);
+      }
+      EPETRA_CHK_ERR(importX_->Import(X, *graph_.Importer(), Insert));
+      Xcol = importX_;
+    }
+    Epetra_MultiVector * Yrow = &Y;
+    if (graph_.Exporter() != 0) {
+      if (exportY_ == 0 || exportY_->NumVectors() != numVectors) {
+        delete exportY_;
+        exportY_ = new Epetra_MultiVector(graph_.RowMap(), numVectors);
+      }
+      Yrow = exportY_;
+    }
+
+    for (int v=0; v<numVectors; v++) {
+      const double * x = (*Xcol)[v];
+      double * y = (*Yrow)[v];
+      if (numMats == 2) {
+        // The common a*M + b*K case
+        const double c0 = coeffs[0], c1 = coeffs[1];
+        const double * v0 = &values_[0][0];
+        const double * v1 = &values_[1][0];
+        for (int i=0; i<numRows; i++) {
+          int numEntries;
+          int * inds;
+          graph_.ExtractMyRowView(i, numEntries, inds);
+          const double * a0 = v0 + rowPtr_[i];
+          const double * a1 = v1 + rowPtr_[i];
+          double sum = 0.0;
+          for (int j=0; j<numEntries; j++)
+            sum += (c0*a0[j] + c1*a1[j])*x[inds[j]];
+          y[i] = sum;
+        }
+      }
+      else {
+        for (int i=0; i<numRows; i++) {
+          int numEntries;
+          int * inds;
+          graph_.ExtractMyRowView(i, numEntries, inds);
+          double sum = 0.0;
+          for (int j=0; j<numEntries; j++) {
+            double a = 0.0;
+            for (int k=0; k<numMats; k++) a += coeffs[k]*values_[k][rowPtr_[i]+j];
+            sum += a*x[inds[j]];
+          }
+          y[i] = sum;
+        }
+      }
+    }
+
+    if (graph_.Exporter() != 0) {
+      Y.PutScalar(0.0);
+      EPETRA_CHK_ERR(Y.Export(*exportY_, *graph_.Exporter(), Add));
+    }
+    return(0);
+  }
+
+  /** \brief Overwrite the values of \c C with sum_k coeffs[k] A_k.
+
+      \param  coeffs   [in]    one coefficient per matrix
+      \param  C        [out]   filled matrix built on Graph() (or on a graph
+                               with the same pattern and column map)
+   */
+  int Combine(const double * coeffs, Epetra_CrsMatrix & C) const {
+    if (!C.Filled() || C.NumMyRows() != graph_.NumMyRows() || !C.ColMap().SameAs(graph_.ColMap())) EPETRA_CHK_ERR(-2);
+    int numMats = NumMatrices();
+
+    for (int i=0; i<C.NumMyRows(); i++) {
+      int numEntries;
+      int * inds;
+      double * rowVals;
+      C.ExtractMyRowView(i, numEntries, rowVals, inds);
+      if (numEntries != rowPtr_[i+1]-rowPtr_[i]) EPETRA_CHK_ERR(-2);
+      for (int j=0; j<numEntries; j++) {
+        double a = 0.0;
+        for (int k=0; k<numMats; k++) a += coeffs[k]*values_[k][rowPtr_[i]+j];
+        rowVals[j] = a;
+      }
+    }
+    return(0);
+  }
+
+ private:
+
+  // Not copyable
+  Epetra_SharedGraphMatrices(const Epetra_SharedGraphMatrices &);
+  Epetra_SharedGraphMatrices & operator=(const Epetra_SharedGraphMatrices &);
+
+  // Shares the indices of the caller's graph (Epetra_CrsGraph copies are shallow)
+  Epetra_CrsGraph graph_;
+
+  // Start of each local row in the value arrays
+  std::vector<int> rowPtr_;
+
+  // One value array per matrix, row by row in the order of the graph's indices
+  std::vector<std::vector<double> > values_;
+
+  // Column-map copy of X and row-map copy of Y, reused between applies
+  mutable Epetra_MultiVector * importX_;
+  mutable Epetra_MultiVector * exportY_;
+};
+
+#endif
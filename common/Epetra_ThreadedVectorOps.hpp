@@ -0,0 +1,169 @@
+//@HEADER
+// ************************************************************************
+//
+//               Epetra: Linear Algebra Services Package
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact Michael A. Heroux (maherou@sandia.gov)
+//
+// ************************************************************************
+//@HEADER
+
+/** \file   Epetra_ThreadedVectorOps.hpp
+    \brief  Threaded versions of the Epetra_MultiVector kernels used in Krylov
+            iterations: Norm2, Dot, Update and Scale.
+
+    The local loops are split over OpenMP threads (when the code is compiled
+    with OpenMP; otherwise they run serially).  Reductions are deterministic:
+    the local vector is cut into fixed blocks of \c BlockSize entries, each
+    block is summed by one thread, and the block sums are added in block
+    order.  The result therefore does not depend on the number of threads or
+    on scheduling, only on the block size.  The global sum uses
+    Epetra_Comm::SumAll as Epetra does.
+
+    The inner loops are plain unit-stride loops over one vector at a time so
+    the compiler can vectorize them.
+ **/
+
+#ifndef EPETRA_THREADEDVECTOROPS_HPP
+#define EPETRA_THREADEDVECTOROPS_HPP
+
+#include <vector>
+#include <cmath>
+
+#include "Epetra_ConfigDefs.h"
+#include "Epetra_Comm.h"
+#include "Epetra_MultiVector.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+class Epetra_ThreadedVectorOps {
+
+ public:
+
+  //! Entries per reduction block
+  enum {BlockSize = 2048};
+
+  //! Largest number of threads available (1 without OpenMP)
+  static int MaxThreads() {
+#ifdef _OPENMP
+    return(omp_get_max_threads());
+#else
+    return(1);
+#endif
+  }
+
+  //! result[v] = ||x(v)||_2
+  static int Norm2(const Epetra_MultiVector & x, double * result, int numThreads) {
+    std::vector<double> local(x.NumVectors());
+    for (int v=0; v<x.NumVectors(); v++)
+      local[v] = BlockSum(x[v], x[v], x.MyLength(), numThreads);
+    x.Comm().SumAll(&local[0], result, x.NumVectors());
+    for (int v=0; v<x.NumVectors(); v++) result[v] = std::sqrt(result[v]);
+    return(0);
+  }
+
+  //! result[v] = x(v)^T y(v)
+  static int Dot(const Epetra_MultiVector & x, const Epetra_MultiVector & y, double * result, int numThreads) {
+    if (x.NumVectors() != y.NumVectors() || x.MyLength() != y.MyLength()) EPETRA_CHK_ERR(-1);
+    std::vector<double> local(x.NumVectors());
+    for (int v=0; v<x.NumVectors(); v++)
+      local[v] = BlockSum(x[v], y[v], x.MyLength(), numThreads);
+    x.Comm().SumAll(&local[0], result, x.NumVectors());
+    return(0);
+  }
+
+  //! C = a*A + b*B + c*C, as Epetra_MultiVector::Update
+  static int Update(double a, const Epetra_MultiVector & A, double b, const Epetra_MultiVector & B,
+                    double c, Epetra_MultiVector & C, int numThreads) {
+    if (A.NumVectors() != C.NumVectors() || B.NumVectors() != C.NumVectors() ||
+        A.MyLength() != C.MyLength() || B.MyLength() != C.MyLength()) EPETRA_CHK_ERR(-1);
+    const int n = C.MyLength();
+    for (int v=0; v<C.NumVectors(); v++) {
+      const double * pa = A[v];
+      const double * pb = B[v];
+      double * pc = C[v];
+      if (c == 0.0) {
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+#endif
+        for (int i=0; i<n; i++) pc[i] = a*pa[i] + b*pb[i];
+      }
+      else {
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+#endif
+        for (int i=0; i<n; i++) pc[i] = a*pa[i] + b*pb[i] + c*pc[i];
+      }
+    }
+    return(0);
+  }
+
+  //! x = a*x
+  static int Scale(double a, Epetra_MultiVector & x, int numThreads) {
+    const int n = x.MyLength();
+    for (int v=0; v<x.NumVectors(); v++) {
+      double * px = x[v];
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+#endif
+      for (int i=0; i<n; i++) px[i] *= a;
+    }
+    return(0);
+  }
+
+ private:
+
+  // sum_i x[i]*y[i], summed block by block and then over blocks in order
+  static double BlockSum(const double * x, const double * y, int n, int numThreads) {
+    const int numBlocks = (n + BlockSize - 1)/BlockSize;
+    std::vector<double> partial(numBlocks+1, 0.0);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+#endif
+    for (int blk=0; blk<numBlocks; blk++) {
+      const int begin = blk*BlockSize;
+      const int end = (begin + BlockSize < n) ? begin + BlockSize : n;
+      double sum = 0.0;
+      for (int i=begin; i<end; i++) sum += x[i]*y[i];
+      partial[blk] = sum;
+    }
+    double sum = 0.0;
+    for (int blk=0; blk<numBlocks; blk++) sum += partial[blk];
+    return(sum);
+  }
+};
+
+#endif
@@ -0,0 +1,307 @@
+//@HEADER
+// ************************************************************************
+//
+//               Epetra: Linear Algebra Services Package
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact Michael A. Heroux (maherou@sandia.gov)
+//
+// ************************************************************************
+//@HEADER
+
+/** \file   Epetra_TpetraBridge.hpp
+    \brief  Epetra and Tpetra objects that share their data instead of
+            copying it, for code that mixes the two.
+
+    Passing a vector or a matrix between an Epetra and a Tpetra code path
+    usually means building the other object and copying every entry, in
+    both directions, at every hand-off.  For Tpetra on a host node (the
+    serial, threaded and TBB nodes all keep their data in host memory) the
+    local storage of the two libraries is the same:
+
+    - a constant-stride Epetra_MultiVector and a constant-stride
+      Tpetra::MultiVector are both one column-major array with a leading
+      dimension, so each can be a view of the other's array;
+    - an Epetra_CrsMatrix with optimized storage keeps its local column
+      indices and values in two contiguous CSR arrays, which a Tpetra
+      CrsMatrix on the same row and column maps can use as they are.  Only
+      the row offsets are copied (Tpetra stores them as size_t), one
+      integer per row.
+
+    The Tpetra objects are built on unmanaged Kokkos::Views of the Epetra
+    arrays (a dual_view_type for a multivector, a local_matrix_type for a
+    matrix), so Kokkos neither copies nor frees them.  Views keep what
+    they look at alive: a Tpetra view has the Epetra object attached as
+    RCP extra data, an Epetra view has the Tpetra object (and its host
+    view) attached the same way.  Writes through either
+    object are seen by the other; changing the structure of a shared
+    matrix (e.g. a new FillComplete on the Epetra side) is not allowed
+    while the Tpetra matrix is in use.
+
+    Maps and communicators are converted, not shared; convert a map once
+    and pass it to every view built on it.  Only point maps (element size
+    1) and 32-bit global indices are supported, as for Tpetra with
+    GlobalOrdinal = int.  The Copy functions do the same conversions by
+    copying, for comparison and for the cases views do not cover.
+
+    All Tpetra objects are <double,int,int,Node>.  With explicit
+    instantiation Tpetra must be configured with Tpetra_INST_INT_INT and
+    Tpetra_INST_DOUBLE; otherwise the class is not defined, and neither is
+    EPETRA_TPETRABRIDGE_SUPPORTED, which callers can test.
+ **/
+
+#ifndef EPETRA_TPETRABRIDGE_HPP
+#define EPETRA_TPETRABRIDGE_HPP
+
+#include <stdexcept>
+
+#include "Tpetra_ConfigDefs.hpp"
+#if !defined(HAVE_TPETRA_EXPLICIT_INSTANTIATION) || \
+    (defined(HAVE_TPETRA_INST_INT_INT) && defined(HAVE_TPETRA_INST_DOUBLE))
+#define EPETRA_TPETRABRIDGE_SUPPORTED
+#endif
+
+#ifdef EPETRA_TPETRABRIDGE_SUPPORTED
+
+#include "Teuchos_RCP.hpp"
+#include "Teuchos_ArrayRCP.hpp"
+#include "Teuchos_ArrayView.hpp"
+#include "Teuchos_Comm.hpp"
+#include "Teuchos_DefaultSerialComm.hpp"
+#include "Teuchos_Assert.hpp"
+#include "Epetra_ConfigDefs.h"
+#include "Epetra_Comm.h"
+#include "Epetra_SerialComm.h"
+#include "Epetra_BlockMap.h"
+#include "Epetra_Map.h"
+#include "Epetra_MultiVector.h"
+#include "Epetra_CrsMatrix.h"
+#ifdef EPETRA_MPI
+#include "mpi.h"
+#include "Epetra_MpiComm.h"
+#include "Teuchos_DefaultMpiComm.hpp"
+#endif
+#include "Tpetra_Map.hpp"
+#include "Tpetra_MultiVector.hpp"
+#include "Tpetra_CrsMatrix.hpp"
+#include "Kokkos_Core.hpp"
+
+
+template<class Node = Tpetra::Map<>::node_type>
+class Epetra_TpetraBridge {
+
+ public:
+
+  typedef Tpetra::Map<int,int,Node> map_type;
+  typedef Tpetra::MultiVector<double,int,int,Node> multivector_type;
+  typedef Tpetra::CrsMatrix<double,int,int,Node> crs_matrix_type;
+  typedef typename multivector_type::dual_view_type dual_view_type;
+  typedef typename crs_matrix_type::local_matrix_type local_matrix_type;
+
+  //! Teuchos communicator over the processors of comm
+  static Teuchos::RCP<const Teuchos::Comm<int> > TpetraComm(const Epetra_Comm & comm) {
+#ifdef EPETRA_MPI
+    const Epetra_MpiComm * mpiComm = dynamic_cast<const Epetra_MpiComm *>(&comm);
+    if (mpiComm != 0)
+      return(Teuchos::rcp(new Teuchos::MpiComm<int>(Teuchos::opaqueWrapper(mpiComm->Comm()))));
+#endif
+    TEUCHOS_TEST_FOR_EXCEPTION(comm.NumProc() > 1, std::invalid_argument,
+      "Epetra_TpetraBridge::TpetraComm: unsupported Epetra_Comm");
+    return(Teuchos::rcp(new Teuchos::SerialComm<int>()));
+  }
+
+  //! Epetra communicator over the processors of comm
+  static Teuchos::RCP<const Epetra_Comm> EpetraComm(const Teuchos::Comm<int> & comm) {
+#ifdef EPETRA_MPI
+    const Teuchos::MpiComm<int> * mpiComm = dynamic_cast<const Teuchos::MpiComm<int> *>(&comm);
+    if (mpiComm != 0) return(Teuchos::rcp(new Epetra_MpiComm((*mpiComm->getRawMpiComm())())));
+#endif
+    TEUCHOS_TEST_FOR_EXCEPTION(comm.getSize() > 1, std::invalid_argument,
+      "Epetra_TpetraBridge::EpetraComm: unsupported Teuchos::Comm");
+    return(Teuchos::rcp(new Epetra_SerialComm()));
+  }
+
+  //! Tpetra map with the same global ids on every processor
+  static Teuchos::RCP<const map_type> TpetraMap(const Epetra_BlockMap & map) {
+    TEUCHOS_TEST_FOR_EXCEPTION(!map.ConstantElementSize() || map.ElementSize() != 1, std::invalid_argument,
+      "Epetra_TpetraBridge::TpetraMap: only maps with element size 1 are supported");
+    Teuchos::ArrayView<const int> gids(map.MyGlobalElements(), map.NumMyElements());
+    return(Teuchos::rcp(new map_type(map.NumGlobalElements(), gids, map.IndexBase(), TpetraComm(map.Comm()))));
+  }
+
+  //! Epetra map with the same global ids on every processor
+  static Teuchos::RCP<const Epetra_Map> EpetraMap(const map_type & map) {
+    Teuchos::ArrayView<const int> gids = map.getNodeElementList();
+    return(Teuchos::rcp(new Epetra_Map((int)map.getGlobalNumElements(), (int)gids.size(), gids.getRawPtr(),
+                                       map.getIndexBase(), *EpetraComm(*map.getComm()))));
+  }
+
+  /** \brief Tpetra multivector on the storage of X
+
+      \param  X    [in]    constant-stride multivector; kept alive by the view
+      \param  map  [in]    Tpetra version of X->Map() (from TpetraMap())
+   */
+  static Teuchos::RCP<multivector_type> TpetraView(const Teuchos::RCP<Epetra_MultiVector> & X,
+                                                   const Teuchos::RCP<const map_type> & map) {
+    TEUCHOS_TEST_FOR_EXCEPTION(!X->ConstantStride(), std::invalid_argument,
+      "Epetra_TpetraBridge::TpetraView: X must have constant stride");
+    typedef typename dual_view_type::t_dev device_view_type;
+    typedef Kokkos::View<double**, Kokkos::LayoutLeft, typename device_view_type::device_type,
+                         Kokkos::MemoryUnmanaged> unmanaged_type;
+    int lda = X->Stride(), numVectors = X->NumVectors();
+    // the whole allocation (lda rows) is the original view, the first
+    // MyLength() rows of it the view Tpetra works on
+    device_view_type all = unmanaged_type(X->Values(), lda, numVectors);
+    dual_view_type origView(all, Kokkos::create_mirror_view(all));
+    dual_view_type view = Kokkos::subview(origView, std::pair<int,int>(0, X->MyLength()), Kokkos::ALL());
+    Teuchos::RCP<multivector_type> Y = Teuchos::rcp(new multivector_type(map, view, origView));
+    Teuchos::set_extra_data(X, "Epetra_TpetraBridge::X", Teuchos::inOutArg(Y));
+    return(Y);
+  }
+
+  /** \brief Epetra multivector on the (host) storage of X
+
+      \param  X    [in]    constant-stride multivector; kept alive by the view
+      \param  map  [in]    Epetra version of X->getMap() (from EpetraMap())
+   */
+  static Teuchos::RCP<Epetra_MultiVector> EpetraView(const Teuchos::RCP<multivector_type> & X,
+                                                     const Epetra_BlockMap & map) {
+    TEUCHOS_TEST_FOR_EXCEPTION(!X->isConstantStride(), std::invalid_argument,
+      "Epetra_TpetraBridge::EpetraView: X must have constant stride");
+    Teuchos::ArrayRCP<double> data = X->get1dViewNonConst();
+    Teuchos::RCP<Epetra_MultiVector> Y =
+      Teuchos::rcp(new Epetra_MultiVector(View, map, data.getRawPtr(), (int)X->getStride(), (int)X->getNumVectors()));
+    Teuchos::set_extra_data(X, "Epetra_TpetraBridge::X", Teuchos::inOutArg(Y));
+    Teuchos::set_extra_data(data, "Epetra_TpetraBridge::data", Teuchos::inOutArg(Y));
+    return(Y);
+  }
+
+  //! Tpetra copy of X
+  static Teuchos::RCP<multivector_type> TpetraCopy(const Epetra_MultiVector & X,
+                                                   const Teuchos::RCP<const map_type> & map) {
+    Teuchos::RCP<multivector_type> Y = Teuchos::rcp(new multivector_type(map, X.NumVectors()));
+    for (int j=0; j<X.NumVectors(); j++) {
+      Teuchos::ArrayRCP<double> y = Y->getDataNonConst(j);
+      const double * x = X[j];
+      for (int i=0; i<X.MyLength(); i++) y[i] = x[i];
+    }
+    return(Y);
+  }
+
+  //! Epetra copy of X
+  static Teuchos::RCP<Epetra_MultiVector> EpetraCopy(const multivector_type & X, const Epetra_BlockMap & map) {
+    Teuchos::RCP<Epetra_MultiVector> Y = Teuchos::rcp(new Epetra_MultiVector(map, (int)X.getNumVectors()));
+    for (int j=0; j<Y->NumVectors(); j++) {
+      Teuchos::ArrayRCP<const double> x = X.getData(j);
+      double * y = (*Y)[j];
+      for (int i=0; i<Y->MyLength(); i++) y[i] = x[i];
+    }
+    return(Y);
+  }
+
+  /** \brief Tpetra matrix on the column indices and values of A
+
+      Shares the arrays of A when A is fill complete with optimized
+      storage, otherwise copies A row by row.
+
+      \param  A       [in]    fill-complete matrix; kept alive by the result when shared
+      \param  shared  [out]   whether the arrays of A are shared
+   */
+  static Teuchos::RCP<crs_matrix_type> TpetraMatrix(const Teuchos::RCP<Epetra_CrsMatrix> & A, bool & shared) {
+    int * rowPtr;
+    int * colInd;
+    double * values;
+    shared = A->Filled() && A->StorageOptimized() && A->ExtractCrsDataPointers(rowPtr, colInd, values) == 0;
+    if (!shared) return(TpetraMatrixCopy(*A));
+
+    typedef typename local_matrix_type::device_type device_type;
+    typedef typename local_matrix_type::row_map_type::non_const_type row_map_type;
+    typedef Kokkos::View<int*, device_type, Kokkos::MemoryUnmanaged> unmanaged_indices_type;
+    typedef Kokkos::View<double*, device_type, Kokkos::MemoryUnmanaged> unmanaged_values_type;
+
+    Teuchos::RCP<const map_type> rowMap, colMap, domainMap, rangeMap;
+    MatrixMaps(*A, rowMap, colMap, domainMap, rangeMap);
+    int numMyRows = A->NumMyRows();
+    int numMyEntries = rowPtr[numMyRows];
+    // the row offsets are the only copy (size_t in Tpetra, int in Epetra)
+    row_map_type offsets("Epetra_TpetraBridge::offsets", numMyRows+1);
+    for (int i=0; i<=numMyRows; i++) offsets(i) = rowPtr[i];
+    typename local_matrix_type::index_type indices = unmanaged_indices_type(colInd, numMyEntries);
+    typename local_matrix_type::values_type data = unmanaged_values_type(values, numMyEntries);
+    local_matrix_type localA("Epetra_TpetraBridge::A", numMyRows, A->NumMyCols(), numMyEntries,
+                             data, offsets, indices);
+
+    Teuchos::RCP<crs_matrix_type> B = Teuchos::rcp(new crs_matrix_type(localA, rowMap, colMap, domainMap, rangeMap));
+    Teuchos::set_extra_data(A, "Epetra_TpetraBridge::A", Teuchos::inOutArg(B));
+    return(B);
+  }
+
+  //! Tpetra copy of the fill-complete matrix A, on the same maps
+  static Teuchos::RCP<crs_matrix_type> TpetraMatrixCopy(const Epetra_CrsMatrix & A) {
+    Teuchos::RCP<const map_type> rowMap, colMap, domainMap, rangeMap;
+    MatrixMaps(A, rowMap, colMap, domainMap, rangeMap);
+    int numMyRows = A.NumMyRows();
+    Teuchos::ArrayRCP<size_t> lengths(numMyRows);
+    for (int i=0; i<numMyRows; i++) lengths[i] = A.NumMyEntries(i);
+
+    Teuchos::RCP<crs_matrix_type> B =
+      Teuchos::rcp(new crs_matrix_type(rowMap, colMap, lengths.getConst(), Tpetra::StaticProfile));
+    for (int i=0; i<numMyRows; i++) {
+      int numEntries;
+      double * values;
+      int * indices;
+      A.ExtractMyRowView(i, numEntries, values, indices);
+      B->insertLocalValues(i, Teuchos::ArrayView<const int>(indices, numEntries),
+                           Teuchos::ArrayView<const double>(values, numEntries));
+    }
+    B->fillComplete(domainMap, rangeMap);
+    return(B);
+  }
+
+ private:
+
+  // Tpetra versions of the four maps of A; maps that are the same in A are converted once
+  static void MatrixMaps(const Epetra_CrsMatrix & A, Teuchos::RCP<const map_type> & rowMap,
+                         Teuchos::RCP<const map_type> & colMap, Teuchos::RCP<const map_type> & domainMap,
+                         Teuchos::RCP<const map_type> & rangeMap) {
+    rowMap = TpetraMap(A.RowMap());
+    colMap = TpetraMap(A.ColMap());
+    domainMap = A.DomainMap().SameAs(A.RowMap()) ? rowMap : TpetraMap(A.DomainMap());
+    rangeMap = A.RangeMap().SameAs(A.RowMap()) ? rowMap
+             : (A.RangeMap().SameAs(A.DomainMap()) ? domainMap : TpetraMap(A.RangeMap()));
+  }
+};
+
+#endif // EPETRA_TPETRABRIDGE_SUPPORTED
+
+#endif
@@ -0,0 +1,317 @@
+// @HEADER
+// ***********************************************************************
+//
+//                    Teuchos: Common Tools Package
+//                 Copyright (2004) Sandia Corporation
+//
+// Under terms of Contract DE-AC04-94AL85000, there is a non-exclusive
+// license for use of this work by or on behalf of the U.S. Government.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact Michael A. Heroux (maherou@sandia.gov)
+//
+// ***********************************************************************
+// @HEADER
+
+/** \file   FlatHashtable.hpp
+    \brief  Open-addressing hashtable with flat storage, for integer and
+            integer-tuple keys (GID to LID maps, mesh entity deduplication).
+
+    Teuchos::Hashtable and std::map allocate one node per entry and chase a
+    pointer per probe.  FlatHashtable keeps (key, value, used) slots in one
+    flat array whose size is a power of two and resolves collisions by linear
+    probing, so a lookup usually reads one or two neighboring slots.  Removal
+    uses backward shifting, so there are no tombstones and lookups never slow
+    down after many removals.
+
+    Besides the Teuchos::Hashtable interface (put, get, containsKey, remove,
+    size, arrayify) it offers
+
+    - find():          pointer to the value, or 0 if the key is absent,
+    - getOrInsert():   value of an existing key, or insert a new one; this is
+                       the deduplication step "give this entity an id unless it
+                       already has one" in one probe sequence,
+    - build():         bulk insert with a single allocation,
+    - freeze():        rehash to a low load factor and make the table
+                       read-only, for lookup-heavy phases (a frozen table may
+                       be read by several threads at once).
+
+    Keys need a FlatHash specialization; int, long, long long, their unsigned
+    versions, std::pair of those and FlatHashTuple<N> (N long long ids, e.g.
+    the sorted node ids of an edge or a face) are provided.
+ **/
+
+#ifndef FLATHASHTABLE_HPP
+#define FLATHASHTABLE_HPP
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <stdexcept>
+
+#include "Teuchos_TestForException.hpp"
+
+
+//! Mix the bits of a 64-bit integer (the splitmix64 finalizer)
+inline std::size_t FlatHashMix(unsigned long long x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return((std::size_t)x);
+}
+
+//! Hash functor; specialize for new key types
+template<class Key> struct FlatHash;
+
+#define FLATHASH_INTEGER_KEY(T) \
+  template<> struct FlatHash<T> { \
+    std::size_t operator()(T k) const {return(FlatHashMix((unsigned long long)k));} \
+  };
+FLATHASH_INTEGER_KEY(int)
+FLATHASH_INTEGER_KEY(unsigned int)
+FLATHASH_INTEGER_KEY(long)
+FLATHASH_INTEGER_KEY(unsigned long)
+FLATHASH_INTEGER_KEY(long long)
+FLATHASH_INTEGER_KEY(unsigned long long)
+#undef FLATHASH_INTEGER_KEY
+
+template<class A, class B> struct FlatHash<std::pair<A,B> > {
+  std::size_t operator()(const std::pair<A,B> & k) const {
+    return(FlatHashMix(FlatHash<A>()(k.first)*0x9e3779b97f4a7c15ULL + FlatHash<B>()(k.second)));
+  }
+};
+
+//! Fixed-length tuple of ids, e.g. the sorted node ids of an edge (N=2) or a face (N=3,4)
+template<int N> struct FlatHashTuple {
+  long long id[N];
+  bool operator==(const FlatHashTuple & other) const {
+    for (int i=0; i<N; i++) if (id[i] != other.id[i]) return(false);
+    return(true);
+  }
+};
+
+template<int N> struct FlatHash<FlatHashTuple<N> > {
+  std::size_t operator()(const FlatHashTuple<N> & k) const {
+    unsigned long long h = 0;
+    for (int i=0; i<N; i++) h = FlatHashMix(h*0x9e3779b97f4a7c15ULL + (unsigned long long)k.id[i]);
+    return((std::size_t)h);
+  }
+};
+
+
+template<class Key, class Value, class Hash = FlatHash<Key> >
+class FlatHashtable {
+
+ public:
+
+  /** \brief Constructor
+
+      \param  capacity   [in]    number of keys to make room for
+      \param  maxLoad    [in]    grow when more than this fraction of the slots is used
+   */
+  FlatHashtable(int capacity = 16, double maxLoad = 0.7)
+    : size_(0), mask_(0), maxLoad_(maxLoad), frozen_(false)
+  {
+    Allocate(SlotsFor(capacity));
+  }
+
+  //! Number of keys
+  int size() const {return(size_);}
+
+  //! Number of slots
+  int capacity() const {return((int)slots_.size());}
+
+  //! True after freeze()
+  bool isFrozen() const {return(frozen_);}
+
+  //! Remove all keys (also unfreezes the table)
+  void clear() {
+    frozen_ = false;
+    size_ = 0;
+    for (std::size_t i=0; i<slots_.size(); i++) slots_[i].used = 0;
+  }
+
+  //! Make room for \c n keys without further growth
+  void reserve(int n) {
+    if (SlotsFor(n) > slots_.size()) Rehash(SlotsFor(n));
+  }
+
+  //! Value of \c key, or 0 if it is absent
+  const Value * find(const Key & key) const {
+    std::size_t i = hash_(key) & mask_;
+    while (slots_[i].used) {
+      if (slots_[i].key == key) return(&slots_[i].value);
+      i = (i+1) & mask_;
+    }
+    return(0);
+  }
+
+  bool containsKey(const Key & key) const {return(find(key) != 0);}
+
+  //! Value of \c key; throws std::runtime_error if it is absent
+  const Value & get(const Key & key) const {
+    const Value * v = find(key);
+    TEUCHOS_TEST_FOR_EXCEPTION(v == 0, std::runtime_error,
+                               "FlatHashtable::get: key not found");
+    return(*v);
+  }
+
+  //! Insert \c key, or overwrite its value if it is present
+  void put(const Key & key, const Value & value) {
+    TEUCHOS_TEST_FOR_EXCEPTION(frozen_, std::logic_error,
+                               "FlatHashtable::put: table is frozen");
+    std::size_t i = Slot(key);
+    slots_[i].value = value;
+  }
+
+  /** \brief Value of \c key if it is present; otherwise insert it with \c value.
+
+      \param  inserted  [out]   true if the key was new
+   */
+  const Value & getOrInsert(const Key & key, const Value & value, bool & inserted) {
+    int oldSize = size_;
+    std::size_t i = Slot(key);
+    inserted = (size_ != oldSize);
+    if (inserted) slots_[i].value = value;
+    return(slots_[i].value);
+  }
+
+  //! Remove \c key; throws std::runtime_error if it is absent
+  void remove(const Key & key) {
+    TEUCHOS_TEST_FOR_EXCEPTION(frozen_, std::logic_error,
+                               "FlatHashtable::remove: table is frozen");
+    std::size_t i = hash_(key) & mask_;
+    while (slots_[i].used && !(slots_[i].key == key)) i = (i+1) & mask_;
+    TEUCHOS_TEST_FOR_EXCEPTION(!slots_[i].used, std::runtime_error,
+                               "FlatHashtable::remove: key not found");
+    // Shift later members of the probe run back so no lookup chain is broken
+    slots_[i].used = 0;
+    std::size_t j = i;
+    for (;;) {
+      j = (j+1) & mask_;
+      if (!slots_[j].used) break;
+      std::size_t home = hash_(slots_[j].key) & mask_;
+      bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+      if (stays) continue;
+      slots_[i] = slots_[j];
+      slots_[j].used = 0;
+      i = j;
+    }
+    size_--;
+  }
+
+  //! Insert (or overwrite) \c n keys with one allocation
+  void build(int n, const Key * keys, const Value * values) {
+    reserve(size_ + n);
+    for (int k=0; k<n; k++) put(keys[k], values[k]);
+  }
+
+  //! Rehash to a load factor of at most one half and make the table read-only
+  void freeze() {
+    std::size_t slots = 16;
+    while (slots < 2*(std::size_t)size_) slots *= 2;
+    if (slots != slots_.size()) Rehash(slots);
+    frozen_ = true;
+  }
+
+  //! Copy out all keys and values (in slot order)
+  void arrayify(std::vector<Key> & keys, std::vector<Value> & values) const {
+    keys.clear();
+    values.clear();
+    for (std::size_t i=0; i<slots_.size(); i++) {
+      if (slots_[i].used) {
+        keys.push_back(slots_[i].key);
+        values.push_back(slots_[i].value);
+      }
+    }
+  }
+
+ private:
+
+  // Slots needed for n keys at the maximum load factor (a power of two)
+  std::size_t SlotsFor(int n) const {
+    std::size_t slots = 16;
+    while (slots*maxLoad_ < n) slots *= 2;
+    return(slots);
+  }
+
+  void Allocate(std::size_t slots) {
+    slots_.assign(slots, Entry());
+    mask_ = slots - 1;
+  }
+
+  void Rehash(std::size_t slots) {
+    std::vector<Entry> oldSlots;
+    oldSlots.swap(slots_);
+    Allocate(slots);
+    for (std::size_t j=0; j<oldSlots.size(); j++) {
+      if (!oldSlots[j].used) continue;
+      std::size_t i = hash_(oldSlots[j].key) & mask_;
+      while (slots_[i].used) i = (i+1) & mask_;
+      slots_[i] = oldSlots[j];
+    }
+  }
+
+  // Slot holding key, inserting it (with a default value) if it is absent
+  std::size_t Slot(const Key & key) {
+    std::size_t i = hash_(key) & mask_;
+    while (slots_[i].used) {
+      if (slots_[i].key == key) return(i);
+      i = (i+1) & mask_;
+    }
+    TEUCHOS_TEST_FOR_EXCEPTION(frozen_, std::logic_error,
+                               "FlatHashtable: cannot insert into a frozen table");
+    if ((size_+1) > maxLoad_*slots_.size()) {
+      Rehash(2*slots_.size());
+      return(Slot(key));
+    }
+    slots_[i].key = key;
+    slots_[i].used = 1;
+    size_++;
+    return(i);
+  }
+
+  struct Entry {
+    Key key;
+    Value value;
+    char used;
+    Entry() : key(), value(), used(0) {}
+  };
+
+  std::vector<Entry> slots_;
+  int size_;
+  std::size_t mask_;
+  double maxLoad_;
+  bool frozen_;
+  Hash hash_;
+};
+
+#endif
@@ -0,0 +1,174 @@
+//@HEADER
+// ************************************************************************
+//
+//                 Belos: Block Linear Solvers Package
+//                  Copyright 2004 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact Michael A. Heroux (maherou@sandia.gov)
+//
+// ************************************************************************
+//@HEADER
+
+/** \file   HarmonicRitz.hpp
+    \brief  Arnoldi process and harmonic Ritz values (and vectors) of the
+            resulting Hessenberg matrix, shared by PolynomialPreconditioner
+            (roots of the GMRES polynomial) and RecycleSpace (GCRODR-style
+            recycled vectors).
+
+    After m Arnoldi steps A V_m = V_{m+1} H_{m+1,m}, the harmonic Ritz pairs
+    are the eigenpairs of
+
+    \verbatim
+      H_m + h_{m+1,m}^2 H_m^{-T} e_m e_m^T
+    \endverbatim
+
+    The basis is orthogonalized by classical Gram-Schmidt with one
+    reorthogonalization pass, and the process stops early on an (almost)
+    invariant subspace, in which case NumValues() is less than the number of
+    steps asked for.
+
+    The operator is any object with a member
+    \c int \c Apply(const Epetra_Vector & x, Epetra_Vector & y) \c const,
+    so that scaled or shifted operators need no Epetra_Operator wrapper.
+ **/
+
+#ifndef HARMONICRITZ_HPP
+#define HARMONICRITZ_HPP
+
+#include <vector>
+#include <cmath>
+
+#include "Teuchos_RCP.hpp"
+#include "Epetra_ConfigDefs.h"
+#include "Epetra_Vector.h"
+#include "Epetra_LAPACK.h"
+
+
+class HarmonicRitz {
+
+ public:
+
+  /** \brief Run \c steps Arnoldi steps from \c start and solve the small
+             eigenproblem (collective).
+
+      \param  A             [in]    operator, see the file documentation
+      \param  start         [in]    starting vector
+      \param  steps         [in]    number of Arnoldi steps m
+      \param  wantVectors   [in]    also compute the harmonic Ritz vectors
+                                    in the Arnoldi basis (Coefficient())
+      \return 0, -1 if start is zero, -2 or -3 if a LAPACK call failed
+   */
+  template<class Op>
+  int Compute(const Op & A, const Epetra_Vector & start, int steps, bool wantVectors) {
+    int n = steps, ld = steps+1;
+    std::vector<double> H(ld*n, 0.0);   // column-major, leading dimension ld
+    V_.clear();
+    wr_.clear();
+    wi_.clear();
+    G_.clear();
+    Teuchos::RCP<Epetra_Vector> v = Teuchos::rcp(new Epetra_Vector(start));
+    double norm;
+    v->Norm2(&norm);
+    if (norm == 0.0) EPETRA_CHK_ERR(-1);
+    v->Scale(1.0/norm);
+    V_.push_back(v);
+
+    int k = 0;
+    for (; k<n; k++) {
+      Teuchos::RCP<Epetra_Vector> w = Teuchos::rcp(new Epetra_Vector(start.Map()));
+      EPETRA_CHK_ERR(A.Apply(*V_[k], *w));
+      for (int pass=0; pass<2; pass++) {
+        for (int j=0; j<=k; j++) {
+          double h;
+          V_[j]->Dot(*w, &h);
+          w->Update(-h, *V_[j], 1.0);
+          H[k*ld+j] += h;
+        }
+      }
+      w->Norm2(&norm);
+      H[k*ld+k+1] = norm;
+      if (norm < 1.0e-12*std::abs(H[k*ld+k]) || norm == 0.0) {k++; break;}
+      w->Scale(1.0/norm);
+      V_.push_back(w);
+    }
+    n = k;
+    if (n == 0) return(0);
+
+    // Eigenpairs of H_n + h_{n+1,n}^2 H_n^{-T} e_n e_n^T
+    Epetra_LAPACK lapack;
+    int info;
+    std::vector<double> Hn(n*n), HnT(n*n), f(n, 0.0), work(4*n);
+    std::vector<int> ipiv(n);
+    wr_.resize(n);
+    wi_.resize(n);
+    if (wantVectors) G_.resize(n*n);
+    for (int j=0; j<n; j++)
+      for (int i=0; i<n; i++) HnT[i*n+j] = Hn[j*n+i] = H[j*ld+i];
+    f[n-1] = 1.0;
+    double hlast = H[(n-1)*ld+n];
+    lapack.GESV(n, 1, &HnT[0], n, &ipiv[0], &f[0], n, &info);
+    if (info != 0) EPETRA_CHK_ERR(-2);
+    for (int i=0; i<n; i++) Hn[(n-1)*n+i] += hlast*hlast*f[i];
+    lapack.GEEV('N', wantVectors ? 'V' : 'N', n, &Hn[0], n, &wr_[0], &wi_[0], 0, 1,
+                wantVectors ? &G_[0] : 0, wantVectors ? n : 1, &work[0], 4*n, &info);
+    if (info != 0) EPETRA_CHK_ERR(-3);
+    return(0);
+  }
+
+  //! Number of harmonic Ritz values (the Arnoldi steps actually taken)
+  int NumValues() const {return((int)wr_.size());}
+
+  //! Real and imaginary part of harmonic Ritz value \c i, in LAPACK order
+  double Re(int i) const {return(wr_[i]);}
+  double Im(int i) const {return(wi_[i]);}
+
+  /** \brief Coefficient of Arnoldi vector \c i in column \c j of the
+             harmonic Ritz vectors (if computed).
+
+      As for LAPACK GEEV, a complex pair j, j+1 is stored as the real and
+      the imaginary part of the vector of value j.
+   */
+  double Coefficient(int i, int j) const {return(G_[j*NumValues()+i]);}
+
+  //! Arnoldi vector \c i, i < NumValues()
+  const Epetra_Vector & Basis(int i) const {return(*V_[i]);}
+
+ private:
+
+  std::vector<Teuchos::RCP<Epetra_Vector> > V_;
+  std::vector<double> wr_;
+  std::vector<double> wi_;
+  std::vector<double> G_;
+};
+
+#endif
@@ -0,0 +1,207 @@
+//@HEADER
+// ************************************************************************
+//
+//                 Belos: Block Linear Solvers Package
+//                  Copyright 2004 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact Michael A. Heroux (maherou@sandia.gov)
+//
+// ************************************************************************
+//@HEADER
+
+/** \file   InitialGuessProjector.hpp
+    \brief  Initial guesses for sequences of related linear solves, built by
+            projecting each new right-hand side onto previous solutions
+            (P. F. Fischer, "Projection techniques for iterative solution of
+            Ax = b with successive right-hand sides", 1998).
+
+    The projector keeps the last \c maxVectors solutions and their images
+    under A.  From these it builds a basis X of the solution space together
+    with W = A X, orthonormalized so that W^T W = I.  For a new right-hand
+    side b the initial guess
+
+    \verbatim
+      x0 = X W^T b
+    \endverbatim
+
+    minimizes ||b - A x0|| over the span of the stored solutions, so the
+    iterative solver only has to resolve the part of the solution that is
+    new.  When the projector is full the oldest solution is dropped and the
+    basis is rebuilt from the remaining ones, newest first.
+
+    If the operator changes between solves (Newton steps, parameter sweeps)
+    call UpdateOperator() so the stored images are recomputed with the new
+    operator; the cost is one operator apply per stored vector.
+
+    Note that the saving only shows up in the iteration count when the
+    solver's convergence test is relative to ||b|| rather than to the
+    initial residual.
+ **/
+
+#ifndef INITIALGUESSPROJECTOR_HPP
+#define INITIALGUESSPROJECTOR_HPP
+
+#include <deque>
+
+#include "Teuchos_RCP.hpp"
+#include "Epetra_BlockMap.h"
+#include "Epetra_Operator.h"
+#include "Epetra_Vector.h"
+
+
+class InitialGuessProjector {
+
+ public:
+
+  /** \brief Constructor
+
+      \param  map          [in]    map of the solution and right-hand side vectors
+      \param  maxVectors   [in]    number of previous solutions to keep
+      \param  dropTol      [in]    a new solution is not added if the part of its
+                                   image orthogonal to the stored images is smaller
+                                   than dropTol times the image norm
+   */
+  InitialGuessProjector(const Epetra_BlockMap & map, int maxVectors, double dropTol = 1.0e-10)
+    : map_(map), maxVectors_(maxVectors), dropTol_(dropTol)
+  {}
+
+  //! Number of stored solutions
+  int NumVectors() const {return (int)X_.size();}
+
+  //! Forget all stored solutions
+  void Reset() {solX_.clear(); solW_.clear(); X_.clear(); W_.clear();}
+
+  /** \brief Compute the projected initial guess for right-hand side \c b.
+
+      \param  b    [in]    right-hand side
+      \param  x    [out]   initial guess (zero if nothing is stored yet)
+   */
+  void ComputeInitialGuess(const Epetra_Vector & b, Epetra_Vector & x) const
+  {
+    x.PutScalar(0.0);
+    for (unsigned i=0; i<X_.size(); i++) {
+      double alpha;
+      W_[i]->Dot(b, &alpha);
+      x.Update(alpha, *X_[i], 1.0);
+    }
+  }
+
+  /** \brief Add the converged solution of A x = b.
+
+      \param  A    [in]    operator of the solve
+      \param  x    [in]    converged solution
+   */
+  void AddSolution(const Epetra_Operator & A, const Epetra_Vector & x)
+  {
+    if (maxVectors_ <= 0) return;
+
+    Teuchos::RCP<Epetra_Vector> newX = Teuchos::rcp(new Epetra_Vector(x));
+    Teuchos::RCP<Epetra_Vector> newW = Teuchos::rcp(new Epetra_Vector(map_));
+    A.Apply(*newX, *newW);
+
+    if ((int)solX_.size() == maxVectors_) {
+      solX_.pop_front();
+      solW_.pop_front();
+    }
+    solX_.push_back(newX);
+    solW_.push_back(newW);
+    Rebuild();
+  }
+
+  /** \brief Recompute the stored images with a new operator.
+
+      \param  A    [in]    new operator
+   */
+  void UpdateOperator(const Epetra_Operator & A)
+  {
+    for (unsigned i=0; i<solX_.size(); i++) A.Apply(*solX_[i], *solW_[i]);
+    Rebuild();
+  }
+
+ private:
+
+  // Rebuild the orthonormal basis from the stored solutions, newest first,
+  // so the most recent solutions are always represented exactly.
+  void Rebuild()
+  {
+    X_.clear();
+    W_.clear();
+    for (int i=(int)solX_.size()-1; i>=0; i--) {
+      Teuchos::RCP<Epetra_Vector> newX = Teuchos::rcp(new Epetra_Vector(*solX_[i]));
+      Teuchos::RCP<Epetra_Vector> newW = Teuchos::rcp(new Epetra_Vector(*solW_[i]));
+      if (Orthonormalize(*newX, *newW)) {
+        X_.push_back(newX);
+        W_.push_back(newW);
+      }
+    }
+  }
+
+  // Orthonormalize w against the stored images (two passes of modified
+  // Gram-Schmidt), applying the same transformation to x.  Returns false if
+  // w is numerically in the span of the stored images.
+  bool Orthonormalize(Epetra_Vector & x, Epetra_Vector & w) const
+  {
+    double norm0, norm;
+    w.Norm2(&norm0);
+    if (norm0 == 0.0) return false;
+
+    for (int pass=0; pass<2; pass++) {
+      for (unsigned i=0; i<W_.size(); i++) {
+        double alpha;
+        W_[i]->Dot(w, &alpha);
+        w.Update(-alpha, *W_[i], 1.0);
+        x.Update(-alpha, *X_[i], 1.0);
+      }
+    }
+
+    w.Norm2(&norm);
+    if (norm <= dropTol_*norm0) return false;
+    w.Scale(1.0/norm);
+    x.Scale(1.0/norm);
+    return true;
+  }
+
+  Epetra_BlockMap map_;
+  int maxVectors_;
+  double dropTol_;
+
+  // Stored solutions and their images, oldest first
+  std::deque<Teuchos::RCP<Epetra_Vector> > solX_;
+  std::deque<Teuchos::RCP<Epetra_Vector> > solW_;
+
+  // Orthonormalized basis (W_^T W_ = I, W_ = A X_)
+  std::deque<Teuchos::RCP<Epetra_Vector> > X_;
+  std::deque<Teuchos::RCP<Epetra_Vector> > W_;
+};
+
+#endif
@@ -0,0 +1,260 @@
+//@HEADER
+// ************************************************************************
+//
+//                 Belos: Block Linear Solvers Package
+//                  Copyright 2004 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact Michael A. Heroux (maherou@sandia.gov)
+//
+// ************************************************************************
+//@HEADER
+
+/** \file   MixedPrecisionGmres.hpp
+    \brief  Restarted GMRES with the Krylov basis stored in reduced precision.
+
+    Restarted GMRES keeps restart+1 basis vectors, which at large restart
+    lengths dominates the memory of the solver, and every iteration reads
+    the whole basis once or twice (orthogonalization), so the solve is
+    bound by memory bandwidth.  MixedPrecisionGmres stores the basis in
+    BasisScalar (float by default), halving both, while everything else is
+    done in double:
+
+    - the new direction A M^{-1} v_j is computed in double from the rounded
+      v_j, and orthogonalized against the basis by classical Gram-Schmidt
+      with one reorthogonalization (two reductions per iteration), with the
+      dot products accumulated in double,
+    - the Hessenberg matrix, the Givens rotations and the least squares
+      solution are double,
+    - the solution update x += M^{-1} V y is accumulated in double, and the
+      residual is recomputed in double at each restart.
+
+    Rounding the basis perturbs the Arnoldi relation at the level of the
+    float unit roundoff (about 6e-8), so within one cycle the residual
+    estimate can only be trusted down to that level.  Because each restart
+    starts from the true double residual, the outer iteration still
+    converges to double accuracy (each cycle acts as a step of iterative
+    refinement), possibly with a few more iterations.  With
+    BasisScalar = double the class is plain restarted GMRES, which gives
+    the baseline for comparisons.
+
+    Preconditioning is on the right, through M->ApplyInverse() as for
+    Ifpack preconditioners.  Only single vectors are supported.
+ **/
+
+#ifndef MIXEDPRECISIONGMRES_HPP
+#define MIXEDPRECISIONGMRES_HPP
+
+#include <vector>
+#include <cmath>
+
+#include "Teuchos_RCP.hpp"
+#include "Epetra_Operator.h"
+#include "Epetra_Comm.h"
+#include "Epetra_Map.h"
+#include "Epetra_Vector.h"
+
+
+template<class BasisScalar = float>
+class MixedPrecisionGmres {
+
+ public:
+
+  /** \brief Constructor
+
+      \param  A        [in]    operator of the linear system
+      \param  M        [in]    right preconditioner, applied with ApplyInverse(); null for none
+      \param  restart  [in]    number of iterations between restarts
+   */
+  MixedPrecisionGmres(const Teuchos::RCP<const Epetra_Operator> & A,
+                      const Teuchos::RCP<const Epetra_Operator> & M = Teuchos::null,
+                      int restart = 30)
+    : A_(A), M_(M), restart_(restart), numIters_(0), numRestarts_(0), achievedTol_(0.0)
+  {
+    length_ = A_->OperatorDomainMap().NumMyElements();
+    V_.resize((restart_+1)*(std::size_t)length_);
+  }
+
+  /** \brief Solve A x = b, starting from the given x.
+
+      \return  0 if ||b - A x|| <= tol ||b|| was reached within maxIters
+               iterations, 1 if not, negative on operator errors
+   */
+  int Solve(const Epetra_Vector & b, Epetra_Vector & x, int maxIters, double tol) {
+    const Epetra_Comm & comm = b.Comm();
+    const Epetra_Map & map = A_->OperatorDomainMap();
+    int m = restart_;
+    std::vector<double> H((m+1)*m), cs(m), sn(m), g(m+1), y(m), h(m+1), hLocal(m+1);
+    Epetra_Vector r(map), v(map), z(map), w(map);
+
+    double bnorm, beta;
+    b.Norm2(&bnorm);
+    if (bnorm == 0.0) bnorm = 1.0;
+    EPETRA_CHK_ERR(Residual(b, x, r));
+    r.Norm2(&beta);
+    numIters_ = 0;
+    numRestarts_ = 0;
+
+    while (beta > tol*bnorm && numIters_ < maxIters) {
+      Store(r, 1.0/beta, 0);
+      for (int i=0; i<=m; i++) g[i] = 0.0;
+      g[0] = beta;
+
+      int j = 0;
+      while (j < m && numIters_ < maxIters) {
+        // w = A M^{-1} v_j
+        Load(j, v);
+        if (M_ == Teuchos::null) {
+          EPETRA_CHK_ERR(A_->Apply(v, w));
+        }
+        else {
+          EPETRA_CHK_ERR(M_->ApplyInverse(v, z));
+          EPETRA_CHK_ERR(A_->Apply(z, w));
+        }
+
+        // Classical Gram-Schmidt, twice
+        for (int i=0; i<=j; i++) H[i+j*(m+1)] = 0.0;
+        for (int pass=0; pass<2; pass++) {
+          for (int i=0; i<=j; i++) hLocal[i] = LocalDot(i, w);
+          comm.SumAll(&hLocal[0], &h[0], j+1);
+          for (int i=0; i<=j; i++) {
+            Axpy(-h[i], i, w);
+            H[i+j*(m+1)] += h[i];
+          }
+        }
+        double hnorm;
+        w.Norm2(&hnorm);
+        H[j+1+j*(m+1)] = hnorm;
+        if (hnorm > 0.0) Store(w, 1.0/hnorm, j+1);
+
+        // Givens rotations on the new column of H and on g
+        for (int i=0; i<j; i++) {
+          double t = cs[i]*H[i+j*(m+1)] + sn[i]*H[i+1+j*(m+1)];
+          H[i+1+j*(m+1)] = -sn[i]*H[i+j*(m+1)] + cs[i]*H[i+1+j*(m+1)];
+          H[i+j*(m+1)] = t;
+        }
+        double a = H[j+j*(m+1)], c = H[j+1+j*(m+1)];
+        double rho = std::sqrt(a*a + c*c);
+        cs[j] = (rho == 0.0) ? 1.0 : a/rho;
+        sn[j] = (rho == 0.0) ? 0.0 : c/rho;
+        H[j+j*(m+1)] = rho;
+        H[j+1+j*(m+1)] = 0.0;
+        g[j+1] = -sn[j]*g[j];
+        g[j] = cs[j]*g[j];
+
+        j++;
+        numIters_++;
+        if (std::fabs(g[j]) <= tol*bnorm || hnorm == 0.0) break;
+      }
+
+      // y = H^{-1} g, then x += M^{-1} V y and r = b - A x
+      for (int i=j-1; i>=0; i--) {
+        double s = g[i];
+        for (int l=i+1; l<j; l++) s -= H[i+l*(m+1)]*y[l];
+        y[i] = (H[i+i*(m+1)] == 0.0) ? 0.0 : s/H[i+i*(m+1)];
+      }
+      v.PutScalar(0.0);
+      for (int i=0; i<j; i++) Axpy(y[i], i, v);
+      if (M_ == Teuchos::null) x.Update(1.0, v, 1.0);
+      else {
+        EPETRA_CHK_ERR(M_->ApplyInverse(v, z));
+        x.Update(1.0, z, 1.0);
+      }
+      EPETRA_CHK_ERR(Residual(b, x, r));
+      r.Norm2(&beta);
+      numRestarts_++;
+    }
+    achievedTol_ = beta/bnorm;
+    return((beta <= tol*bnorm) ? 0 : 1);
+  }
+
+  //! Iterations of the last Solve()
+  int NumIters() const {return(numIters_);}
+
+  //! Restart cycles of the last Solve()
+  int NumRestarts() const {return(numRestarts_);}
+
+  //! ||b - A x|| / ||b|| at the end of the last Solve()
+  double AchievedTol() const {return(achievedTol_);}
+
+  //! Bytes of basis storage on this processor
+  double BasisBytes() const {return((double)V_.size()*sizeof(BasisScalar));}
+
+ private:
+
+  // r = b - A x
+  int Residual(const Epetra_Vector & b, const Epetra_Vector & x, Epetra_Vector & r) const {
+    EPETRA_CHK_ERR(A_->Apply(x, r));
+    r.Update(1.0, b, -1.0);
+    return(0);
+  }
+
+  // v_i = scale*u, rounded to BasisScalar
+  void Store(const Epetra_Vector & u, double scale, int i) {
+    BasisScalar * vi = &V_[i*(std::size_t)length_];
+    for (int k=0; k<length_; k++) vi[k] = (BasisScalar)(scale*u[k]);
+  }
+
+  // u = v_i
+  void Load(int i, Epetra_Vector & u) const {
+    const BasisScalar * vi = &V_[i*(std::size_t)length_];
+    for (int k=0; k<length_; k++) u[k] = vi[k];
+  }
+
+  // local part of v_i^T u
+  double LocalDot(int i, const Epetra_Vector & u) const {
+    const BasisScalar * vi = &V_[i*(std::size_t)length_];
+    double s = 0.0;
+    for (int k=0; k<length_; k++) s += (double)vi[k]*u[k];
+    return(s);
+  }
+
+  // u += alpha v_i
+  void Axpy(double alpha, int i, Epetra_Vector & u) const {
+    const BasisScalar * vi = &V_[i*(std::size_t)length_];
+    for (int k=0; k<length_; k++) u[k] += alpha*vi[k];
+  }
+
+  Teuchos::RCP<const Epetra_Operator> A_;
+  Teuchos::RCP<const Epetra_Operator> M_;
+  int restart_;
+  int length_;
+
+  // Basis vectors v_0 .. v_restart, each length_ local entries
+  std::vector<BasisScalar> V_;
+
+  int numIters_;
+  int numRestarts_;
+  double achievedTol_;
+};
+
+#endif
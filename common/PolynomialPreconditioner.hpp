@@ -0,0 +1,299 @@
+//@HEADER
+// ************************************************************************
+//
+//                 Belos: Block Linear Solvers Package
+//                  Copyright 2004 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact Michael A. Heroux (maherou@sandia.gov)
+//
+// ************************************************************************
+//@HEADER
+
+/** \file   PolynomialPreconditioner.hpp
+    \brief  Polynomial preconditioners (Chebyshev or GMRES polynomial) whose
+            application uses only matrix-vector products and vector updates.
+
+    ILU and Gauss-Seidel preconditioners apply triangular sweeps, which are
+    sequential within a processor.  A polynomial preconditioner
+
+    \verbatim
+      M^{-1} = p(D^{-1} A) D^{-1}
+    \endverbatim
+
+    (D the diagonal of A) is applied with deg(p) sparse matrix-vector
+    products, diagonal scalings and vector updates.  These thread as well as
+    the matvec does, and there are no reductions, so nothing waits on other
+    processors besides the halo exchange of each matvec.  Two polynomials are
+    available:
+
+    - Chebyshev: the Chebyshev polynomial for the interval
+      [lambdaMax/eigRatio, lambdaMax] of D^{-1} A, where lambdaMax is
+      estimated by a few power method iterations (as in the Epetra
+      power method lesson) and enlarged by 10%.  Meant for SPD problems.
+    - GmresPoly: the GMRES polynomial of D^{-1} A, given by its roots, the
+      harmonic Ritz values from \c degree Arnoldi steps (Loe and Morgan,
+      "Toward efficient polynomial preconditioning for GMRES", 2021).  The
+      roots are applied in Leja order; complex conjugate pairs are applied
+      together in real arithmetic.  Works for nonsymmetric problems too.
+
+    Setup (Compute()) is the only part with reductions.  ApplyInverse()
+    applies M^{-1}; Apply() is not supported.
+ **/
+
+#ifndef POLYNOMIALPRECONDITIONER_HPP
+#define POLYNOMIALPRECONDITIONER_HPP
+
+#include <vector>
+#include <string>
+#include <cmath>
+
+#include "Teuchos_RCP.hpp"
+#include "Epetra_Operator.h"
+#include "Epetra_RowMatrix.h"
+#include "Epetra_Comm.h"
+#include "Epetra_Map.h"
+#include "Epetra_Vector.h"
+#include "Epetra_MultiVector.h"
+
+#include "HarmonicRitz.hpp"
+
+
+class PolynomialPreconditioner : public Epetra_Operator {
+
+ public:
+
+  enum Type {Chebyshev, GmresPoly};
+
+  /** \brief Constructor
+
+      \param  A            [in]    matrix to precondition
+      \param  type         [in]    Chebyshev or GmresPoly
+      \param  degree       [in]    polynomial degree (matvecs per application, about)
+      \param  powerIters   [in]    power method iterations for the Chebyshev bound
+      \param  eigRatio     [in]    ratio of the Chebyshev interval ends
+   */
+  PolynomialPreconditioner(const Teuchos::RCP<const Epetra_RowMatrix> & A, Type type, int degree,
+                           int powerIters = 10, double eigRatio = 30.0)
+    : A_(A), type_(type), degree_(degree), powerIters_(powerIters), eigRatio_(eigRatio),
+      lambdaMax_(0.0), label_(type == Chebyshev ? "Chebyshev polynomial" : "GMRES polynomial")
+  {}
+
+  /** \brief Compute the diagonal and the eigenvalue bound or the roots.
+
+      \return  0, or nonzero if a LAPACK call failed
+   */
+  int Compute() {
+    invDiag_ = Teuchos::rcp(new Epetra_Vector(A_->RowMatrixRowMap()));
+    EPETRA_CHK_ERR(A_->ExtractDiagonalCopy(*invDiag_));
+    for (int i=0; i<invDiag_->MyLength(); i++)
+      (*invDiag_)[i] = ((*invDiag_)[i] != 0.0) ? 1.0/(*invDiag_)[i] : 1.0;
+
+    if (type_ == Chebyshev) PowerMethod();
+    else EPETRA_CHK_ERR(ComputeRoots());
+    return(0);
+  }
+
+  //! Power method estimate of the largest eigenvalue of D^{-1} A (Chebyshev)
+  double LambdaMax() const {return(lambdaMax_);}
+
+  //! Number of roots (GmresPoly; may be less than the degree after an Arnoldi breakdown)
+  int NumRoots() const {return((int)rootRe_.size());}
+
+  //! Real and imaginary part of root \c i, in application order
+  double RootRe(int i) const {return(rootRe_[i]);}
+  double RootIm(int i) const {return(rootIm_[i]);}
+
+  //! Y = p(D^{-1} A) D^{-1} X
+  int ApplyInverse(const Epetra_MultiVector & X, Epetra_MultiVector & Y) const {
+    if (type_ == Chebyshev) return(ApplyChebyshev(X, Y));
+    return(ApplyGmresPoly(X, Y));
+  }
+
+  int Apply(const Epetra_MultiVector &, Epetra_MultiVector &) const {return(-1);}
+
+  int SetUseTranspose(bool useTranspose) {return(useTranspose ? -1 : 0);}
+  double NormInf() const {return(0.0);}
+  const char * Label() const {return(label_.c_str());}
+  bool UseTranspose() const {return(false);}
+  bool HasNormInf() const {return(false);}
+  const Epetra_Comm & Comm() const {return(A_->Comm());}
+  const Epetra_Map & OperatorDomainMap() const {return(A_->OperatorDomainMap());}
+  const Epetra_Map & OperatorRangeMap() const {return(A_->OperatorRangeMap());}
+
+ private:
+
+  // Y = D^{-1} A X
+  int ApplyScaled(const Epetra_MultiVector & X, Epetra_MultiVector & Y) const {
+    EPETRA_CHK_ERR(A_->Apply(X, Y));
+    EPETRA_CHK_ERR(Y.Multiply(1.0, *invDiag_, Y, 0.0));
+    return(0);
+  }
+
+  // Largest eigenvalue of D^{-1} A by the power method
+  void PowerMethod() {
+    Epetra_Vector q(A_->OperatorDomainMap()), z(A_->OperatorRangeMap());
+    double normz;
+    z.Random();
+    lambdaMax_ = 0.0;
+    for (int iter=0; iter<powerIters_; iter++) {
+      z.Norm2(&normz);
+      q.Scale(1.0/normz, z);
+      ApplyScaled(q, z);
+      q.Dot(z, &lambdaMax_);
+    }
+    lambdaMax_ *= 1.1;
+  }
+
+  // Chebyshev iteration for A Y = X from Y = 0, preconditioned by D
+  int ApplyChebyshev(const Epetra_MultiVector & X, Epetra_MultiVector & Y) const {
+    double lambdaMin = lambdaMax_/eigRatio_;
+    double theta = 0.5*(lambdaMax_ + lambdaMin);
+    double delta = 0.5*(lambdaMax_ - lambdaMin);
+    double sigma = theta/delta, rho = 1.0/sigma;
+
+    // X is read after Y is first written; keep a copy if they share storage
+    Teuchos::RCP<const Epetra_MultiVector> Xcopy = Teuchos::rcp(&X, false);
+    if (X.Pointers()[0] == Y.Pointers()[0]) Xcopy = Teuchos::rcp(new Epetra_MultiVector(X));
+    const Epetra_MultiVector & B = *Xcopy;
+
+    Epetra_MultiVector d(X.Map(), X.NumVectors()), r(X.Map(), X.NumVectors());
+    EPETRA_CHK_ERR(d.Multiply(1.0/theta, *invDiag_, B, 0.0));
+    Y = d;
+    for (int k=1; k<degree_; k++) {
+      EPETRA_CHK_ERR(A_->Apply(Y, r));
+      EPETRA_CHK_ERR(r.Update(1.0, B, -1.0));
+      double rhoNew = 1.0/(2.0*sigma - rho);
+      EPETRA_CHK_ERR(d.Multiply(2.0*rhoNew/delta, *invDiag_, r, rhoNew*rho));
+      EPETRA_CHK_ERR(Y.Update(1.0, d, 1.0));
+      rho = rhoNew;
+    }
+    return(0);
+  }
+
+  // Y = p(D^{-1} A) D^{-1} X, one factor of 1 - pi(t) = 1 - prod_i (1 - t/theta_i) at a time
+  int ApplyGmresPoly(const Epetra_MultiVector & X, Epetra_MultiVector & Y) const {
+    Epetra_MultiVector prod(X.Map(), X.NumVectors());
+    Epetra_MultiVector Aprod(X.Map(), X.NumVectors()), AAprod(X.Map(), X.NumVectors());
+    EPETRA_CHK_ERR(prod.Multiply(1.0, *invDiag_, X, 0.0));
+    Y.PutScalar(0.0);
+
+    int numRoots = NumRoots();
+    for (int i=0; i<numRoots; i++) {
+      double a = rootRe_[i], b = rootIm_[i];
+      bool last = (i == numRoots-1) || (b != 0.0 && i == numRoots-2);
+      if (b == 0.0) {
+        EPETRA_CHK_ERR(Y.Update(1.0/a, prod, 1.0));
+        if (last) break;
+        EPETRA_CHK_ERR(ApplyScaled(prod, Aprod));
+        EPETRA_CHK_ERR(prod.Update(-1.0/a, Aprod, 1.0));
+      }
+      else {
+        // Pair a +- ib: (1 - t/theta)(1 - t/conj(theta)) = 1 - (2a/m) t + t^2/m, m = a^2+b^2
+        double m = a*a + b*b;
+        EPETRA_CHK_ERR(ApplyScaled(prod, Aprod));
+        EPETRA_CHK_ERR(Y.Update(2.0*a/m, prod, -1.0/m, Aprod, 1.0));
+        i++;
+        if (last) break;
+        EPETRA_CHK_ERR(ApplyScaled(Aprod, AAprod));
+        EPETRA_CHK_ERR(prod.Update(-2.0*a/m, Aprod, 1.0/m, AAprod, 1.0));
+      }
+    }
+    return(0);
+  }
+
+  // D^{-1} A for HarmonicRitz
+  struct ScaledOperator {
+    ScaledOperator(const PolynomialPreconditioner & prec) : prec_(prec) {}
+    int Apply(const Epetra_Vector & x, Epetra_Vector & y) const {return(prec_.ApplyScaled(x, y));}
+    const PolynomialPreconditioner & prec_;
+  };
+
+  // Harmonic Ritz values of D^{-1} A from degree_ Arnoldi steps, in Leja order
+  int ComputeRoots() {
+    Epetra_Vector start(A_->OperatorDomainMap());
+    start.Random();
+    HarmonicRitz ritz;
+    EPETRA_CHK_ERR(ritz.Compute(ScaledOperator(*this), start, degree_, false));
+    int n = ritz.NumValues();
+    std::vector<double> wr(n), wi(n);
+    for (int i=0; i<n; i++) {wr[i] = ritz.Re(i); wi[i] = ritz.Im(i);}
+
+    // Leja order; a complex root with positive imaginary part is followed by its conjugate
+    rootRe_.clear();
+    rootIm_.clear();
+    std::vector<bool> used(n, false);
+    for (int count=0; count<n; count++) {
+      int best = -1;
+      double bestScore = 0.0;
+      for (int i=0; i<n; i++) {
+        if (used[i] || wi[i] < 0.0) continue;
+        double score = 0.0;
+        if (rootRe_.empty()) score = std::sqrt(wr[i]*wr[i] + wi[i]*wi[i]);
+        else
+          for (unsigned j=0; j<rootRe_.size(); j++)
+            score += std::log(std::sqrt((wr[i]-rootRe_[j])*(wr[i]-rootRe_[j]) +
+                                        (wi[i]-rootIm_[j])*(wi[i]-rootIm_[j])) + 1.0e-300);
+        if (best < 0 || score > bestScore) {best = i; bestScore = score;}
+      }
+      if (best < 0) break;
+      used[best] = true;
+      rootRe_.push_back(wr[best]);
+      rootIm_.push_back(wi[best]);
+      if (wi[best] > 0.0) {
+        for (int i=0; i<n; i++) {
+          if (!used[i] && wi[i] < 0.0 && wr[i] == wr[best] && wi[i] == -wi[best]) {used[i] = true; break;}
+        }
+        rootRe_.push_back(wr[best]);
+        rootIm_.push_back(-wi[best]);
+      }
+    }
+    return(0);
+  }
+
+  Teuchos::RCP<const Epetra_RowMatrix> A_;
+  Type type_;
+  int degree_;
+  int powerIters_;
+  double eigRatio_;
+  double lambdaMax_;
+  std::string label_;
+
+  // Inverse of the diagonal of A
+  Teuchos::RCP<Epetra_Vector> invDiag_;
+
+  // GMRES polynomial roots, in application order
+  std::vector<double> rootRe_;
+  std::vector<double> rootIm_;
+};
+
+#endif
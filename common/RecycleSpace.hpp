@@ -0,0 +1,349 @@
+//@HEADER
+// ************************************************************************
+//
+//                 Belos: Block Linear Solvers Package
+//                  Copyright 2004 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact Michael A. Heroux (maherou@sandia.gov)
+//
+// ************************************************************************
+//@HEADER
+
+/** \file   RecycleSpace.hpp
+    \brief  Recycled Krylov subspace (U, C = A U) that can be written to disk
+            at the end of a run and reloaded to seed the solves of the next
+            run, as GCRODR does between solves within one run.
+
+    GCRODR keeps k vectors U spanning approximate eigenvectors of the
+    smallest eigenvalues, with C = A U and C^T C = I, and deflates them from
+    the next solve: with P = I - C C^T it solves
+
+    \verbatim
+      P A y = P b,    x = U C^T b + y - U C^T A y
+    \endverbatim
+
+    so the Krylov solver never has to rebuild the slow part of the
+    spectrum.  The Belos solver manager keeps its recycle space private and
+    loses it when the process ends, so this class holds the pair itself:
+
+    - Compute() builds U from the k harmonic Ritz vectors of smallest
+      magnitude of a short Arnoldi run (the choice GCRODR makes),
+    - Write() and Read() store and load U and C, one binary file per
+      process; Read() checks that the number of processes, the global length
+      and the global ids of every process match the map of the run;
+      Remove() deletes the files,
+    - InitialGuess(), DeflatedOperator and Correct() apply the formula
+      above around any solver (e.g. a Stratimikos/Thyra solve of P A).
+
+    If the operator of the new run differs from the one C was computed with
+    (same family, new parameters), call UpdateOperator() to recompute C; the
+    cost is k operator applications.
+ **/
+
+#ifndef RECYCLESPACE_HPP
+#define RECYCLESPACE_HPP
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "Teuchos_RCP.hpp"
+#include "Epetra_Operator.h"
+#include "Epetra_Comm.h"
+#include "Epetra_Map.h"
+#include "Epetra_Vector.h"
+#include "Epetra_MultiVector.h"
+
+#include "HarmonicRitz.hpp"
+
+
+class RecycleSpace {
+
+ public:
+
+  /** \brief Constructor
+
+      \param  map    [in]    map of the solution and right-hand side vectors
+   */
+  RecycleSpace(const Epetra_Map & map) : map_(map) {}
+
+  //! Number of recycled vectors (0 before Compute() or Read())
+  int NumVectors() const {return((U_ == Teuchos::null) ? 0 : U_->NumVectors());}
+
+  const Epetra_MultiVector & U() const {return(*U_);}
+  const Epetra_MultiVector & C() const {return(*C_);}
+
+  /** \brief Build U from harmonic Ritz vectors of A (collective).
+
+      \param  A             [in]    operator
+      \param  start         [in]    starting vector of the Arnoldi run (e.g. a right-hand side)
+      \param  numVectors    [in]    number of recycled vectors k
+      \param  arnoldiSteps  [in]    Arnoldi steps m > k
+      \return 0, or nonzero if the small eigenproblem failed
+   */
+  int Compute(const Epetra_Operator & A, const Epetra_Vector & start, int numVectors, int arnoldiSteps) {
+    HarmonicRitz ritz;
+    EPETRA_CHK_ERR(ritz.Compute(A, start, arnoldiSteps, true));
+    int n = ritz.NumValues();
+    std::vector<double> wr(n), wi(n);
+    for (int i=0; i<n; i++) {wr[i] = ritz.Re(i); wi[i] = ritz.Im(i);}
+
+    // The numVectors of smallest magnitude; a complex pair is stored by GEEV
+    // as two real columns (real and imaginary part), and both are kept
+    std::vector<int> order(n);
+    std::vector<double> magnitude(n);
+    for (int i=0; i<n; i++) {order[i] = i; magnitude[i] = std::sqrt(wr[i]*wr[i] + wi[i]*wi[i]);}
+    std::sort(order.begin(), order.end(), MagnitudeLess(magnitude));
+    std::vector<bool> selected(n, false);
+    int numSelected = 0;
+    for (int i=0; i<n && numSelected<std::min(numVectors, n); i++) {
+      int j = order[i];
+      if (selected[j]) continue;
+      selected[j] = true;
+      numSelected++;
+      if (wi[j] != 0.0) {
+        int partner = (wi[j] > 0.0) ? j+1 : j-1;
+        if (!selected[partner]) {selected[partner] = true; numSelected++;}
+      }
+    }
+
+    // U = V_n G(:, selected), then C = A U and orthonormalization
+    U_ = C_ = Teuchos::null;
+    if (numSelected == 0) return(0);
+    U_ = Teuchos::rcp(new Epetra_MultiVector(map_, numSelected));
+    int col = 0;
+    for (int j=0; j<n; j++) {
+      if (!selected[j]) continue;
+      for (int i=0; i<n; i++) (*U_)(col)->Update(ritz.Coefficient(i,j), ritz.Basis(i), 1.0);
+      col++;
+    }
+    return(UpdateOperator(A));
+  }
+
+  /** \brief Recompute C = A U for a new operator and orthonormalize (collective).
+
+      Columns of U whose image is numerically dependent on the others are dropped.
+   */
+  int UpdateOperator(const Epetra_Operator & A) {
+    if (NumVectors() == 0) return(0);
+    Epetra_MultiVector AU(map_, NumVectors());
+    EPETRA_CHK_ERR(A.Apply(*U_, AU));
+
+    std::vector<int> kept;
+    for (int j=0; j<NumVectors(); j++) {
+      double norm0, norm;
+      AU(j)->Norm2(&norm0);
+      if (norm0 == 0.0) continue;
+      for (int pass=0; pass<2; pass++) {
+        for (unsigned i=0; i<kept.size(); i++) {
+          double alpha;
+          AU(kept[i])->Dot(*AU(j), &alpha);
+          AU(j)->Update(-alpha, *AU(kept[i]), 1.0);
+          (*U_)(j)->Update(-alpha, *(*U_)(kept[i]), 1.0);
+        }
+      }
+      AU(j)->Norm2(&norm);
+      if (norm <= 1.0e-10*norm0) continue;
+      AU(j)->Scale(1.0/norm);
+      (*U_)(j)->Scale(1.0/norm);
+      kept.push_back(j);
+    }
+
+    if (kept.empty()) {
+      U_ = C_ = Teuchos::null;
+      return(0);
+    }
+    Teuchos::RCP<Epetra_MultiVector> U = Teuchos::rcp(new Epetra_MultiVector(map_, (int)kept.size()));
+    C_ = Teuchos::rcp(new Epetra_MultiVector(map_, (int)kept.size()));
+    for (unsigned i=0; i<kept.size(); i++) {
+      (*U)(i)->Update(1.0, *(*U_)(kept[i]), 0.0);
+      (*C_)(i)->Update(1.0, *AU(kept[i]), 0.0);
+    }
+    U_ = U;
+    return(0);
+  }
+
+  /** \brief Write U and C, one file "fileName.<NumProc>.<MyPID>" per process.
+
+      \return 0, or -1 if the file could not be written
+   */
+  int Write(const std::string & fileName) const {
+    std::ofstream file(FileName(fileName).c_str(), std::ios::binary);
+    int header[5] = {Version, map_.Comm().NumProc(), map_.NumGlobalElements(),
+                     map_.NumMyElements(), NumVectors()};
+    file.write((const char*)header, sizeof(header));
+    if (map_.NumMyElements() > 0)
+      file.write((const char*)map_.MyGlobalElements(), map_.NumMyElements()*sizeof(int));
+    for (int j=0; j<NumVectors(); j++) {
+      file.write((const char*)(*U_)[j], map_.NumMyElements()*sizeof(double));
+      file.write((const char*)(*C_)[j], map_.NumMyElements()*sizeof(double));
+    }
+    return(file.good() ? 0 : -1);
+  }
+
+  /** \brief Remove the files written by Write() (this process's file only).
+
+      \return 0, or -1 if the file could not be removed
+   */
+  int Remove(const std::string & fileName) const {
+    return((std::remove(FileName(fileName).c_str()) == 0) ? 0 : -1);
+  }
+
+  /** \brief Read U and C written by Write() (collective).
+
+      \return 0, -1 if a file is missing or unreadable, -2 if the number of
+              processes, the global length or the global ids of some process
+              do not match; the result is the same on all processes
+   */
+  int Read(const std::string & fileName) {
+    int status = ReadMine(fileName), minStatus;
+    map_.Comm().MinAll(&status, &minStatus, 1);
+    if (minStatus != 0) {
+      U_ = C_ = Teuchos::null;
+      return(minStatus);
+    }
+    return(0);
+  }
+
+  //! x = U C^T b
+  int InitialGuess(const Epetra_Vector & b, Epetra_Vector & x) const {
+    x.PutScalar(0.0);
+    if (NumVectors() == 0) return(0);
+    std::vector<double> alpha;
+    Project(*C_, b, alpha);
+    for (int j=0; j<NumVectors(); j++) EPETRA_CHK_ERR(x.Update(alpha[j], *(*U_)(j), 1.0));
+    return(0);
+  }
+
+  //! x += y - U C^T A y, for y solving P A y = b - A x
+  int Correct(const Epetra_Operator & A, const Epetra_Vector & y, Epetra_Vector & x) const {
+    Epetra_Vector Ay(map_), z(map_);
+    EPETRA_CHK_ERR(A.Apply(y, Ay));
+    EPETRA_CHK_ERR(InitialGuess(Ay, z));
+    EPETRA_CHK_ERR(x.Update(1.0, y, -1.0, z, 1.0));
+    return(0);
+  }
+
+  //! P A = (I - C C^T) A, the operator of the deflated solve
+  class DeflatedOperator : public Epetra_Operator {
+   public:
+    DeflatedOperator(const Teuchos::RCP<const Epetra_Operator> & A, const Teuchos::RCP<const RecycleSpace> & space)
+      : A_(A), space_(space), label_("Deflated operator") {}
+
+    int Apply(const Epetra_MultiVector & X, Epetra_MultiVector & Y) const {
+      EPETRA_CHK_ERR(A_->Apply(X, Y));
+      int k = space_->NumVectors();
+      if (k == 0) return(0);
+      for (int v=0; v<Y.NumVectors(); v++) {
+        std::vector<double> alpha;
+        Project(space_->C(), *Y(v), alpha);
+        for (int j=0; j<k; j++) EPETRA_CHK_ERR(Y(v)->Update(-alpha[j], *space_->C()(j), 1.0));
+      }
+      return(0);
+    }
+
+    int ApplyInverse(const Epetra_MultiVector &, Epetra_MultiVector &) const {return(-1);}
+    int SetUseTranspose(bool useTranspose) {return(useTranspose ? -1 : 0);}
+    double NormInf() const {return(0.0);}
+    const char * Label() const {return(label_.c_str());}
+    bool UseTranspose() const {return(false);}
+    bool HasNormInf() const {return(false);}
+    const Epetra_Comm & Comm() const {return(A_->Comm());}
+    const Epetra_Map & OperatorDomainMap() const {return(A_->OperatorDomainMap());}
+    const Epetra_Map & OperatorRangeMap() const {return(A_->OperatorRangeMap());}
+
+   private:
+    Teuchos::RCP<const Epetra_Operator> A_;
+    Teuchos::RCP<const RecycleSpace> space_;
+    std::string label_;
+  };
+
+ private:
+
+  enum {Version = 1};
+
+  struct MagnitudeLess {
+    MagnitudeLess(const std::vector<double> & magnitude) : magnitude_(magnitude) {}
+    bool operator()(int a, int b) const {return(magnitude_[a] < magnitude_[b]);}
+    const std::vector<double> & magnitude_;
+  };
+
+  // alpha = C^T b, with one reduction
+  static void Project(const Epetra_MultiVector & C, const Epetra_Vector & b, std::vector<double> & alpha) {
+    int k = C.NumVectors();
+    std::vector<double> local(k, 0.0);
+    alpha.resize(k);
+    for (int j=0; j<k; j++)
+      for (int i=0; i<C.MyLength(); i++) local[j] += C[j][i]*b[i];
+    C.Comm().SumAll(&local[0], &alpha[0], k);
+  }
+
+  std::string FileName(const std::string & fileName) const {
+    std::ostringstream name;
+    name << fileName << "." << map_.Comm().NumProc() << "." << map_.Comm().MyPID();
+    return(name.str());
+  }
+
+  int ReadMine(const std::string & fileName) {
+    std::ifstream file(FileName(fileName).c_str(), std::ios::binary);
+    int header[5];
+    if (!file.read((char*)header, sizeof(header)) || header[0] != Version) return(-1);
+    if (header[1] != map_.Comm().NumProc() || header[2] != map_.NumGlobalElements() ||
+        header[3] != map_.NumMyElements()) return(-2);
+    int numMy = header[3], k = header[4];
+    std::vector<int> gids(numMy+1);
+    if (numMy > 0 && !file.read((char*)&gids[0], numMy*sizeof(int))) return(-1);
+    for (int i=0; i<numMy; i++) if (gids[i] != map_.GID(i)) return(-2);
+
+    U_ = Teuchos::rcp(new Epetra_MultiVector(map_, std::max(k, 1)));
+    C_ = Teuchos::rcp(new Epetra_MultiVector(map_, std::max(k, 1)));
+    for (int j=0; j<k; j++) {
+      if (!file.read((char*)(*U_)[j], numMy*sizeof(double))) return(-1);
+      if (!file.read((char*)(*C_)[j], numMy*sizeof(double))) return(-1);
+    }
+    if (k == 0) U_ = C_ = Teuchos::null;
+    return(0);
+  }
+
+  Epetra_Map map_;
+
+  // Recycled vectors and their images, C^T C = I, C = A U
+  Teuchos::RCP<Epetra_MultiVector> U_;
+  Teuchos::RCP<Epetra_MultiVector> C_;
+};
+
+#endif
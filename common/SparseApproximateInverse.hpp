@@ -0,0 +1,245 @@
+//@HEADER
+// ************************************************************************
+//
+//       IFPACK: Robust Algebraic Preconditioning Package
+//                Copyright (2002) Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact Michael A. Heroux (maherou@sandia.gov)
+//
+// ************************************************************************
+//@HEADER
+
+/** \file   SparseApproximateInverse.hpp
+    \brief  Sparse approximate inverse (SPAI) preconditioner with the
+            sparsity pattern of A, computed column by column in parallel
+            threads and applied as one local sparse matrix-vector product.
+
+    ILU preconditioners apply two triangular solves, which are sequential
+    within a processor.  A sparse approximate inverse M ~ A^{-1} is applied
+    as y = M x, which threads like a matvec.  M is computed independently
+    for each column k by the small least squares problem
+
+    \verbatim
+      min || A m_k - e_k ||    over m_k with the pattern of row k of A
+    \endverbatim
+
+    (Grote and Huckle, 1997, without the pattern adaptation), so the columns
+    are spread over OpenMP threads with no synchronization.
+
+    As for Ifpack ILU without overlap, each processor approximates the
+    inverse of its diagonal block: only the entries of A whose column is
+    owned by the processor (in the domain map) are used.  M then has no
+    ghost columns, so the apply needs no halo exchange at all.
+
+    A must be square and fill-complete; M maps the range of A to its
+    domain, so it can be used as a left or right preconditioner.
+    ApplyInverse() applies M; Apply() is not supported.
+ **/
+
+#ifndef SPARSEAPPROXIMATEINVERSE_HPP
+#define SPARSEAPPROXIMATEINVERSE_HPP
+
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "Teuchos_RCP.hpp"
+#include "Epetra_Operator.h"
+#include "Epetra_CrsMatrix.h"
+#include "Epetra_Comm.h"
+#include "Epetra_Map.h"
+#include "Epetra_MultiVector.h"
+#include "Epetra_LAPACK.h"
+
+
+class SparseApproximateInverse : public Epetra_Operator {
+
+ public:
+
+  /** \brief Constructor
+
+      \param  A    [in]    square, fill-complete matrix
+   */
+  SparseApproximateInverse(const Teuchos::RCP<const Epetra_CrsMatrix> & A)
+    : A_(A), label_("Sparse approximate inverse"), numFailed_(0)
+  {}
+
+  /** \brief Compute M.
+
+      \return  0, or nonzero if A is not filled, its row map is not its range
+               map, or M could not be assembled
+   */
+  int Compute() {
+    if (!A_->Filled() || !A_->RowMap().SameAs(A_->RangeMap())) EPETRA_CHK_ERR(-1);
+    const Epetra_Map & rangeMap = A_->RangeMap();
+    const Epetra_Map & domainMap = A_->DomainMap();
+    const Epetra_Map & colMap = A_->ColMap();
+    int numRows = A_->NumMyRows();
+    int numCols = domainMap.NumMyElements();
+
+    // Local block of A: rows by range LID, columns by domain LID (owned columns only)
+    std::vector<int> colToDomain(colMap.NumMyElements());
+    for (int j=0; j<colMap.NumMyElements(); j++) colToDomain[j] = domainMap.LID(colMap.GID(j));
+    std::vector<int> rowPtr(numRows+1, 0), cscPtr(numCols+1, 0);
+    std::vector<int> rowInd;
+    std::vector<double> rowVal;
+    for (int i=0; i<numRows; i++) {
+      int numEntries;
+      int * inds;
+      double * vals;
+      A_->ExtractMyRowView(i, numEntries, vals, inds);
+      for (int j=0; j<numEntries; j++) {
+        int d = colToDomain[inds[j]];
+        if (d < 0) continue;
+        rowInd.push_back(d);
+        rowVal.push_back(vals[j]);
+        cscPtr[d+1]++;
+      }
+      rowPtr[i+1] = (int)rowInd.size();
+    }
+    for (int d=0; d<numCols; d++) cscPtr[d+1] += cscPtr[d];
+    std::vector<int> cscInd(rowInd.size()+1), next(cscPtr.begin(), cscPtr.end()-1);
+    std::vector<double> cscVal(rowInd.size()+1);
+    for (int i=0; i<numRows; i++) {
+      for (int p=rowPtr[i]; p<rowPtr[i+1]; p++) {
+        int q = next[rowInd[p]]++;
+        cscInd[q] = i;
+        cscVal[q] = rowVal[p];
+      }
+    }
+
+    // Column k of M has the pattern of row k of A: mVal[p] = M(rowInd[p], k)
+    std::vector<double> mVal(rowInd.size()+1, 0.0);
+    int numFailed = 0;
+#ifdef _OPENMP
+#pragma omp parallel reduction(+:numFailed)
+#endif
+    {
+      Epetra_LAPACK lapack;
+      std::vector<int> rows, mark(numRows, -1);
+      std::vector<double> dense, rhs, work;
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 64)
+#endif
+      for (int k=0; k<numRows; k++) {
+        int nJ = rowPtr[k+1] - rowPtr[k];
+        if (nJ == 0) continue;
+
+        // Rows I touched by the columns J, and the dense A(I,J)
+        rows.clear();
+        for (int p=rowPtr[k]; p<rowPtr[k+1]; p++) {
+          int d = rowInd[p];
+          for (int q=cscPtr[d]; q<cscPtr[d+1]; q++) {
+            if (mark[cscInd[q]] < 0) {
+              mark[cscInd[q]] = (int)rows.size();
+              rows.push_back(cscInd[q]);
+            }
+          }
+        }
+        int nI = (int)rows.size();
+        if (mark[k] < 0) {mark[k] = nI++; rows.push_back(k);}
+        dense.assign(nI*nJ, 0.0);
+        for (int p=rowPtr[k]; p<rowPtr[k+1]; p++) {
+          int d = rowInd[p];
+          for (int q=cscPtr[d]; q<cscPtr[d+1]; q++)
+            dense[(p-rowPtr[k])*nI + mark[cscInd[q]]] = cscVal[q];
+        }
+        rhs.assign(std::max(nI, nJ), 0.0);
+        rhs[mark[k]] = 1.0;
+        for (int i=0; i<nI; i++) mark[rows[i]] = -1;
+
+        // Least squares solve by QR
+        int info, lwork = std::max(1, std::min(nI, nJ) + std::max(nI, nJ))*32;
+        work.resize(lwork);
+        lapack.GELS('N', nI, nJ, 1, &dense[0], nI, &rhs[0], std::max(nI, nJ), &work[0], lwork, &info);
+        if (info != 0) {numFailed++; continue;}
+        for (int p=rowPtr[k]; p<rowPtr[k+1]; p++) mVal[p] = rhs[p-rowPtr[k]];
+      }
+    }
+    numFailed_ = numFailed;
+
+    // Assemble M by rows (domain LIDs); its columns are the range LIDs, all local
+    std::vector<int> mPtr(cscPtr), mInd(rowInd.size()+1);
+    std::vector<double> mRowVal(rowInd.size()+1);
+    next.assign(cscPtr.begin(), cscPtr.end()-1);
+    for (int k=0; k<numRows; k++) {
+      for (int p=rowPtr[k]; p<rowPtr[k+1]; p++) {
+        int q = next[rowInd[p]]++;
+        mInd[q] = k;
+        mRowVal[q] = mVal[p];
+      }
+    }
+    std::vector<int> numEntriesPerRow(numCols+1);
+    for (int d=0; d<numCols; d++) numEntriesPerRow[d] = mPtr[d+1] - mPtr[d];
+    M_ = Teuchos::rcp(new Epetra_CrsMatrix(Copy, domainMap, rangeMap, &numEntriesPerRow[0], true));
+    for (int d=0; d<numCols; d++) {
+      if (mPtr[d+1] == mPtr[d]) continue;
+      EPETRA_CHK_ERR(M_->InsertMyValues(d, mPtr[d+1]-mPtr[d], &mRowVal[mPtr[d]], &mInd[mPtr[d]]));
+    }
+    EPETRA_CHK_ERR(M_->FillComplete(rangeMap, domainMap));
+    EPETRA_CHK_ERR(M_->OptimizeStorage());
+    return(0);
+  }
+
+  //! Number of local columns of M left zero because A(I,J) was rank deficient
+  int NumFailedColumns() const {return(numFailed_);}
+
+  //! The approximate inverse (after Compute())
+  const Epetra_CrsMatrix & Matrix() const {return(*M_);}
+
+  //! Y = M X
+  int ApplyInverse(const Epetra_MultiVector & X, Epetra_MultiVector & Y) const {
+    EPETRA_CHK_ERR(M_->Multiply(false, X, Y));
+    return(0);
+  }
+
+  int Apply(const Epetra_MultiVector &, Epetra_MultiVector &) const {return(-1);}
+
+  int SetUseTranspose(bool useTranspose) {return(useTranspose ? -1 : 0);}
+  double NormInf() const {return(0.0);}
+  const char * Label() const {return(label_.c_str());}
+  bool UseTranspose() const {return(false);}
+  bool HasNormInf() const {return(false);}
+  const Epetra_Comm & Comm() const {return(A_->Comm());}
+  const Epetra_Map & OperatorDomainMap() const {return(A_->RangeMap());}
+  const Epetra_Map & OperatorRangeMap() const {return(A_->DomainMap());}
+
+ private:
+
+  Teuchos::RCP<const Epetra_CrsMatrix> A_;
+  std::string label_;
+  int numFailed_;
+  Teuchos::RCP<Epetra_CrsMatrix> M_;
+};
+
+#endif
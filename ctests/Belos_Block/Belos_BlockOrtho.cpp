@@ -0,0 +1,192 @@
+//
+// Compares the block orthonormalization kernels of BlockOrthogonalization.hpp
+// (TSQR and CholQR2) with the Belos orthogonalization managers (DGKS, ICGS,
+// IMGS) on random blocks of 1 to 32 vectors, for the user-defined MyMultiVec
+// and for Epetra_MultiVector.  For each block size and method it prints the
+// average normalization time, the orthonormality error ||I - Q^H Q|| and the
+// factorization error max_j ||X0(:,j) - (Q R)(:,j)|| / ||X0(:,j)||.
+//
+// The test passes if TSQR and CholQR2 produce orthonormal blocks Q with
+// Q R equal to the input block.
+//
+#include "BelosConfigDefs.hpp"
+#include "BelosMultiVec.hpp"
+#include "BelosOperator.hpp"
+#include "BelosEpetraAdapter.hpp"
+#include "BelosDGKSOrthoManager.hpp"
+#include "BelosICGSOrthoManager.hpp"
+#include "BelosIMGSOrthoManager.hpp"
+#include "Teuchos_CommandLineProcessor.hpp"
+#include "Teuchos_SerialDenseMatrix.hpp"
+#include "Teuchos_Time.hpp"
+
+#ifdef HAVE_MPI
+#include <mpi.h>
+#include "Epetra_MpiComm.h"
+#else
+#include "Epetra_SerialComm.h"
+#endif
+#include "Epetra_Map.h"
+#include "Epetra_MultiVector.h"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+
+#include "MyMultiVec.hpp"
+#include "BlockOrthogonalization.hpp"
+
+namespace Belos {
+  class MPIFinalize {
+  public:
+    ~MPIFinalize() {
+#ifdef HAVE_MPI
+      MPI_Finalize();
+#endif
+    }
+  };
+}
+
+using namespace Teuchos;
+
+typedef Teuchos::SerialDenseMatrix<int,double> SDM;
+
+// Local columns of a block, and its communicator (0 if not distributed)
+void LocalColumns(Belos::MultiVec<double> & X, std::vector<double*> & cols, int & length,
+                  const Epetra_Comm * & comm)
+{
+  MyMultiVec<double> & MyX = dynamic_cast<MyMultiVec<double> &>(X);
+  cols.resize(MyX.GetNumberVecs());
+  for (int v=0; v<MyX.GetNumberVecs(); ++v) cols[v] = MyX[v];
+  length = MyX.GetVecLength();
+  comm = 0;
+}
+
+void LocalColumns(Epetra_MultiVector & X, std::vector<double*> & cols, int & length,
+                  const Epetra_Comm * & comm)
+{
+  double ** ptrs;
+  X.ExtractView(&ptrs);
+  cols.assign(ptrs, ptrs + X.NumVectors());
+  length = X.MyLength();
+  comm = &X.Comm();
+}
+
+// Normalize copies of X0 with each method; returns the largest orthonormality or
+// factorization error of TSQR and CholQR2
+template<class MV, class OP>
+double CompareMethods(const std::string & vecType, const MV & X0, int numTrials, bool verbose)
+{
+  typedef Belos::MultiVecTraits<double,MV> MVT;
+  int k = MVT::GetNumberVecs(X0);
+  RCP<MV> X = MVT::CloneCopy(X0);
+  RCP<SDM> B = rcp( new SDM(k,k) );
+
+  Belos::DGKSOrthoManager<double,MV,OP> dgks("DGKS");
+  Belos::ICGSOrthoManager<double,MV,OP> icgs("ICGS");
+  Belos::IMGSOrthoManager<double,MV,OP> imgs("IMGS");
+  const char * names[] = {"DGKS", "ICGS", "IMGS", "TSQR", "CholQR2"};
+
+  double maxError = 0.0;
+  for (int method=0; method<5; ++method) {
+    double time = 0.0;
+    int info = 0;
+    for (int t=0; t<numTrials; ++t) {
+      MVT::MvAddMv( 1.0, X0, 0.0, X0, *X );
+      std::vector<double*> cols;
+      int length;
+      const Epetra_Comm * comm;
+      LocalColumns(*X, cols, length, comm);
+
+      Teuchos::Time timer("normalize");
+      timer.start(true);
+      switch (method) {
+      case 0: dgks.normalize(*X, B); break;
+      case 1: icgs.normalize(*X, B); break;
+      case 2: imgs.normalize(*X, B); break;
+      case 3: info = BlockOrthogonalization<double>::TSQR(length, cols, *B, comm); break;
+      case 4: info = BlockOrthogonalization<double>::CholQR2(length, cols, *B, comm); break;
+      }
+      timer.stop();
+      time += timer.totalElapsedTime();
+    }
+    double error = dgks.orthonormError(*X);
+
+    // Residual = Q R - X0, relative to the columns of X0
+    RCP<MV> Residual = MVT::CloneCopy(X0);
+    MVT::MvTimesMatAddMv( 1.0, *X, *B, -1.0, *Residual );
+    std::vector<double> resNorms(k), x0Norms(k);
+    MVT::MvNorm( *Residual, resNorms );
+    MVT::MvNorm( X0, x0Norms );
+    double factorError = 0.0;
+    for (int j=0; j<k; ++j) factorError = std::max(factorError, resNorms[j]/x0Norms[j]);
+
+    if (method >= 3) maxError = std::max(maxError, (info == 0) ? std::max(error, factorError) : 1.0);
+
+    if (verbose)
+      std::cout << std::setw(18) << vecType << std::setw(6) << k << std::setw(10) << names[method]
+                << std::setw(14) << time/numTrials << std::setw(14) << error
+                << std::setw(14) << factorError
+                << ((info != 0) ? "   (failed)" : "") << std::endl;
+  }
+  return(maxError);
+}
+
+int main(int argc, char *argv[]) {
+
+  int MyPID = 0;
+#ifdef HAVE_MPI
+  MPI_Init(&argc,&argv);
+  Belos::MPIFinalize mpiFinalize; // Will call finalize with *any* return
+  (void)mpiFinalize;
+  Epetra_MpiComm Comm(MPI_COMM_WORLD);
+  MyPID = Comm.MyPID();
+#else
+  Epetra_SerialComm Comm;
+#endif
+
+  bool verbose = false;
+  int length = 10000;
+  int maxBlocksize = 32;
+  int numTrials = 5;
+
+  CommandLineProcessor cmdp(false,true);
+  cmdp.setOption("verbose","quiet",&verbose,"Print messages and results.");
+  cmdp.setOption("length",&length,"Global length of the vectors.");
+  cmdp.setOption("max-blocksize",&maxBlocksize,"Largest block size (block sizes 1, 2, 4, ...).");
+  cmdp.setOption("num-trials",&numTrials,"Number of normalizations timed per method.");
+  if (cmdp.parse(argc,argv) != CommandLineProcessor::PARSE_SUCCESSFUL) {
+    return -1;
+  }
+  bool proc_verbose = verbose && (MyPID==0);
+
+  if (proc_verbose)
+    std::cout << std::setw(18) << "vectors" << std::setw(6) << "k" << std::setw(10) << "method"
+              << std::setw(14) << "time (s)" << std::setw(14) << "||I-Q^HQ||"
+              << std::setw(14) << "||X0-QR||" << std::endl;
+
+  double maxError = 0.0;
+  Epetra_Map Map(length, 0, Comm);
+  for (int k=1; k<=maxBlocksize; k*=2) {
+    // MyMultiVec is not distributed: every processor runs the serial case
+    MyMultiVec<double> MyX0(length, k);
+    MyX0.MvRandom();
+    maxError = std::max(maxError, CompareMethods<Belos::MultiVec<double>,Belos::Operator<double> >(
+                          "MyMultiVec", MyX0, numTrials, proc_verbose));
+
+    Epetra_MultiVector EpetraX0(Map, k);
+    EpetraX0.Random();
+    maxError = std::max(maxError, CompareMethods<Epetra_MultiVector,Epetra_Operator>(
+                          "Epetra_MultiVector", EpetraX0, numTrials, proc_verbose));
+  }
+
+  if (maxError > 1.0e-10) {
+    if (proc_verbose)
+      std::cout << "End Result: TEST FAILED" << std::endl;
+    return -1;
+  }
+  if (proc_verbose)
+    std::cout << "End Result: TEST PASSED" << std::endl;
+  return 0;
+}
@@ -66,6 +66,10 @@
 #ifdef EPETRA_HAVE_JADMATRIX
 #include "Epetra_JadMatrix.h"
 #endif
+#include "Epetra_HaloExchange.hpp"
+#include "Epetra_ThreadedVectorOps.hpp"
+#include "Epetra_IntervalMap.hpp"
+#include "Epetra_TpetraBridge.hpp"
 
 // prototypes
 
@@ -119,6 +123,28 @@ void runJadMatrixTests(Epetra_JadMatrix * A,  Epetra_MultiVector * b, Epetra_Mul
 void runLUMatrixTests(Epetra_CrsMatrix * L,  Epetra_MultiVector * bL, Epetra_MultiVector * btL, Epetra_MultiVector * xexactL, 
 		      Epetra_CrsMatrix * U,  Epetra_MultiVector * bU, Epetra_MultiVector * btU, Epetra_MultiVector * xexactU, 
 		      bool StaticProfile, bool verbose, bool summary);
+
+void runHaloTests(Epetra_CrsMatrix * A,  Epetra_MultiVector * b, Epetra_MultiVector * xexact,
+		  Epetra_HaloExchange::Method haloMethod, bool verbose, bool summary);
+
+void reportHaloVolume(Epetra_CrsMatrix * A, bool verbose, bool summary);
+
+void reportMapConstruction(Epetra_CrsMatrix * A, bool verbose, bool summary);
+
+#ifdef EPETRA_TPETRABRIDGE_SUPPORTED
+bool reportTpetraBridge(Epetra_CrsMatrix * A, Epetra_MultiVector * x, bool verbose, bool summary);
+
+double maxRelativeDiff(const Epetra_MultiVector & X, double alpha, const Epetra_MultiVector & Y);
+#endif
+
+void runThreadedVectorTests(Epetra_MultiVector & q, Epetra_MultiVector & z, Epetra_MultiVector & r,
+			    bool verbose, bool summary);
+
+bool isGridMapping(const char * name);
+#ifdef EPETRA_MPI
+MPI_Comm CreateProcessGrid(const char * gridMapping, int numProcsX, int numProcsY,
+			   int & tileX, int & tileY);
+#endif
 int main(int argc, char *argv[])
 {
   int ierr = 0;
@@ -131,9 +157,6 @@ int main(int argc, char *argv[])
 
   // Initialize MPI
   MPI_Init(&argc,&argv);
-  Epetra_MpiComm comm( MPI_COMM_WORLD );
-#else
-  Epetra_SerialComm comm;
 #endif
 
   bool verbose = false;
@@ -145,9 +168,34 @@ int main(int argc, char *argv[])
   // Check if we should print verbose results to standard out
   if (argc>6) if (argv[6][0]=='-' && argv[6][1]=='s') summary = true;
 
+  // Check if we should also time the matvec with a pre-registered halo exchange
+  // and how processors are placed in the process grid (in either order)
+  bool haloTests = false;
+  Epetra_HaloExchange::Method haloMethod = Epetra_HaloExchange::Import;
+  const char * gridMapping = "rank";
+  for (int i=7; i<argc; i++) {
+    if (Epetra_HaloExchange::MethodFromString(argv[i], haloMethod)==0) haloTests = true;
+    else if (isGridMapping(argv[i])) gridMapping = argv[i];
+    else {
+      cerr << "Unknown option " << argv[i] << " (halo exchange method: import, persistent, neighbor or shared;" << endl
+	   << " process grid mapping: rank, cart or node)" << endl;
+      return(1);
+    }
+  }
+
+#ifdef EPETRA_MPI
+  // Number the processors by their position in the process grid
+  int tileX = 0, tileY = 0;
+  MPI_Comm gridComm = MPI_COMM_WORLD;
+  if (argc>4) gridComm = CreateProcessGrid(gridMapping, atoi(argv[3]), atoi(argv[4]), tileX, tileY);
+  Epetra_MpiComm comm( gridComm );
+#else
+  Epetra_SerialComm comm;
+#endif
+
   if(argc < 6) {
     cerr << "Usage: " << argv[0]
-         << " NumNodesX NumNodesY NumProcX NumProcY NumPoints [-v|-s]" << endl
+         << " NumNodesX NumNodesY NumProcX NumProcY NumPoints [-v|-s] [HaloMethod] [GridMapping]" << endl
          << "where:" << endl
          << "NumNodesX         - Number of mesh nodes in X direction per processor" << endl
          << "NumNodesY         - Number of mesh nodes in Y direction per processor" << endl
@@ -155,6 +203,12 @@ int main(int argc, char *argv[])
          << "NumProcY          - Number of processors to use in Y direction" << endl
          << "NumPoints         - Number of points to use in stencil (5, 9 or 25 only)" << endl
          << "-v|-s             - (Optional) Run in verbose mode if -v present or summary mode if -s present" << endl
+         << "HaloMethod        - (Optional) Also time matvecs with a halo exchange set up once: import, persistent" << endl
+         << "                    (MPI_Send_init/MPI_Recv_init), neighbor (MPI_Neighbor_alltoallv) or shared" << endl
+         << "                    (on-node ghosts read from an MPI shared-memory window)" << endl
+         << "GridMapping       - (Optional) How processors are placed in the NumProcX X NumProcY grid: rank (default," << endl
+         << "                    by MPI_COMM_WORLD rank), cart (MPI_Cart_create with reordering) or node (each node" << endl
+         << "                    takes a 2D tile of the grid)" << endl
          << " NOTES: NumProcX*NumProcY must equal the number of processors used to run the problem." << endl << endl
 	 << " Serial example:" << endl
          << argv[0] << " 16 12 1 1 25 -v" << endl
@@ -163,6 +217,12 @@ int main(int argc, char *argv[])
          << "mpirun -np 32 " << argv[0] << " 10 12 4 8 9 -v" << endl
 	 << " Run this program in verbose mode on 32 processors putting a 10 X 12 subgrid on each processor using 4 processors "<< endl
 	 << " in the X direction and 8 in the Y direction.  Total grid size is 40 points in X and 96 in Y with a 9 point stencil."<< endl
+         << endl
+	 << " Halo exchange example:" << endl
+         << "mpirun -np 16 " << argv[0] << " 4 4 4 4 5 -v persistent" << endl
+	 << " Compare Multiply with a persistent-request halo exchange on a small, latency bound 4 X 4 subgrid per processor."<< endl
+	 << " Use shared instead of persistent to read ghosts owned by processors on the same node from shared memory."<< endl
+	 << " Add node to keep the processors of each node on one 2D tile of the process grid."<< endl
          << endl;
     return(1);
 
@@ -205,7 +265,12 @@ int main(int argc, char *argv[])
 	 << " Number of global nonzero entries      = " << numNodesX*numNodesY*numPoints*numProcsX*numProcsY << endl
 	 << " Number of Processors in X direction   = " << numProcsX << endl
 	 << " Number of Processors in Y direction   = " << numProcsY << endl
-	 << " Number of Points in stencil           = " << numPoints << endl << endl;
+	 << " Number of Points in stencil           = " << numPoints << endl
+	 << " Process grid mapping                  = " << gridMapping;
+#ifdef EPETRA_MPI
+    if (tileX>0) cout << " (" << tileX << " X " << tileY << " processors per node)";
+#endif
+    cout << endl << endl;
   }
   // Print blank line to keep output columns lined up
   if (summary && comm.NumProc()>1)
@@ -394,6 +459,18 @@ int main(int argc, char *argv[])
 #endif
       runMatrixTests(A, b, bt, xexact, StaticProfile, verbose, summary);
 
+      if (j==0 && k==1) {
+	reportHaloVolume(A, verbose, summary);
+	reportMapConstruction(A, verbose, summary);
+#ifdef EPETRA_TPETRABRIDGE_SUPPORTED
+	if (!reportTpetraBridge(A, xexact, verbose, summary)) ierr = 1;
+#else
+	if (verbose) cout << "Epetra <-> Tpetra skipped: Tpetra is not instantiated for <double,int,int>" << endl;
+#endif
+      }
+
+      if (haloTests) runHaloTests(A, b, xexact, haloMethod, verbose, summary);
+
       delete A;
       delete b;
       delete bt; 
@@ -485,10 +562,13 @@ int main(int argc, char *argv[])
 	if (comm.NumProc()==1) cout << "Update" << '\t';
 	cout << MFLOPs << endl;
       }
+
+      runThreadedVectorTests(q, z, r, verbose, summary);
     }
     }
   }
 #ifdef EPETRA_MPI
+  if (gridComm != MPI_COMM_WORLD) MPI_Comm_free(&gridComm);
   MPI_Finalize() ;
 #endif
 
@@ -1082,3 +1162,452 @@ void runLUMatrixTests(Epetra_CrsMatrix * L,  Epetra_MultiVector * bL, Epetra_Mul
   }
   return;
 }
+//=========================================================================================
+// Times 10 matvecs with Epetra_CrsMatrix::Multiply and with Epetra_HaloExchange, first
+// using the matrix Import and then using haloMethod.  The halo exchange pattern is set
+// up once per Epetra_HaloExchange object, outside the timed loop.  Every halo product
+// is checked against Multiply; the check line reports PASSED only if they all match.
+void runHaloTests(Epetra_CrsMatrix * A,  Epetra_MultiVector * b, Epetra_MultiVector * xexact,
+		  Epetra_HaloExchange::Method haloMethod, bool verbose, bool summary) {
+
+  Epetra_MultiVector z(*b);
+  Epetra_MultiVector r(*b);
+  Epetra_SerialDenseVector resvec(b->NumVectors());
+  Epetra_Time timer(A->Comm());
+  double flops = 2.0*10.0*A->NumGlobalNonzeros()*b->NumVectors();
+
+  Epetra_MultiVector zRef(*b);
+  A->Multiply(false, *xexact, zRef);
+  Epetra_SerialDenseVector refNorm(b->NumVectors()), diffNorm(b->NumVectors());
+  zRef.NormInf(refNorm.Values());
+  bool match = true;
+
+  // k = 0 is Multiply, k = 1 is the halo engine with Import, k = 2 is haloMethod
+  int kstop = (haloMethod==Epetra_HaloExchange::Import) ? 2 : 3;
+  for (int k=0; k<kstop; k++) {
+
+    Epetra_HaloExchange * halo = 0;
+    if (k==1) halo = new Epetra_HaloExchange(*A, b->NumVectors(), Epetra_HaloExchange::Import);
+    if (k==2) halo = new Epetra_HaloExchange(*A, b->NumVectors(), haloMethod);
+    std::string name = "Multiply";
+    if (halo!=0) name = Epetra_HaloExchange::MethodName(halo->GetMethod());
+
+    // One untimed product so first-touch and first-message costs are not counted
+    if (halo==0) A->Multiply(false, *xexact, z);
+    else {
+      halo->Multiply(*xexact, z);
+      halo->ResetHaloTime();
+    }
+
+    A->Comm().Barrier();
+    timer.ResetStartTime();
+
+    //10 matvecs
+    for( int i = 0; i < 10; ++i )
+      if (halo==0) A->Multiply(false, *xexact, z);
+      else halo->Multiply(*xexact, z);
+
+    double elapsed_time = timer.ElapsedTime();
+    double halo_time = (halo==0) ? 0.0 : halo->HaloTime();
+    double max_time, max_halo_time;
+    A->Comm().MaxAll(&elapsed_time, &max_time, 1);
+    A->Comm().MaxAll(&halo_time, &max_halo_time, 1);
+
+    r.Update(-1.0, z, 1.0, *b, 0.0); // r = b - z
+    r.Norm2(resvec.Values());
+
+    if (halo!=0) {
+      r.Update(1.0, z, -1.0, zRef, 0.0); // r = z - A*xexact from Multiply
+      r.NormInf(diffNorm.Values());
+      for (int v=0; v<b->NumVectors(); v++)
+	if (diffNorm[v] > 1.0e-12*refNorm[v]) match = false;
+    }
+
+    // Ghost entries per vector read from the node window and received in messages
+    double ghosts[2] = {0.0, 0.0}, sumGhosts[2];
+    if (halo!=0) {
+      ghosts[0] = halo->NumSharedEntries();
+      ghosts[1] = halo->NumRecvEntries();
+    }
+    A->Comm().SumAll(ghosts, sumGhosts, 2);
+
+    double MFLOPs = flops/max_time/1000000.0;
+    if (verbose) {
+      cout << "ResNorm = " << resvec.NormInf() << ": Total MFLOPs for 10 MatVec's with " << name
+	   << " halo exchange = " << MFLOPs << " (" << max_time << " s";
+      if (halo!=0) cout << ", halo " << max_halo_time << " s";
+      cout << ")" << endl;
+      if (k==2)
+	cout << "  Halo neighbors: receive from " << halo->NumRecvNeighbors() << ", send to "
+	     << halo->NumSendNeighbors() << " (processor 0); ghost entries on-node "
+	     << sumGhosts[0] << ", in messages " << sumGhosts[1] << " (all processors)" << endl;
+    }
+    if (summary) {
+      if (A->Comm().NumProc()==1) cout << "HaloMv" << name << '\t';
+      cout << MFLOPs << endl;
+    }
+    delete halo;
+  }
+  if (verbose)
+    cout << "Halo exchange products vs Multiply: " << (match ? "PASSED" : "FAILED") << endl;
+  return;
+}
+//=========================================================================================
+// Reports how many ghost entries of a matvec are owned by processors on the same node
+// and how many cross a node boundary.  Uses the "shared" halo exchange, which splits
+// the ghosts that way; without MPI-3 every ghost is counted as off-node.
+void reportHaloVolume(Epetra_CrsMatrix * A, bool verbose, bool summary) {
+
+  Epetra_HaloExchange halo(*A, 1, Epetra_HaloExchange::Shared);
+  double ghosts[2], sumGhosts[2];
+  ghosts[0] = halo.NumSharedEntries();
+  ghosts[1] = halo.NumRecvEntries();
+  A->Comm().SumAll(ghosts, sumGhosts, 2);
+
+  if (verbose)
+    cout << "Halo volume per vector: " << sumGhosts[0] << " entries on-node, "
+	 << sumGhosts[1] << " entries (" << sumGhosts[1]*sizeof(double) << " bytes) off-node" << endl;
+  if (summary) {
+    if (A->Comm().NumProc()==1) cout << "OffNodeHaloEntries" << '\t';
+    cout << sumGhosts[1] << endl;
+  }
+  return;
+}
+
+//=========================================================================================
+// Builds the row map of A again from its global id list, once as an Epetra_Map and once
+// as an Epetra_IntervalMap, and looks up the owners of the ghost ids of A with each
+// (the first RemoteIDList call builds the Epetra_Map directory).  Reports the maximum
+// time over processors and the total memory.  The Epetra_Map figure is not measured
+// but estimated from its layout (4 bytes per id for the list, about 24 for the GID to
+// LID hash table and 8 for the directory entry) and is labeled as such; the
+// Epetra_IntervalMap figure counts the arrays it holds.
+void reportMapConstruction(Epetra_CrsMatrix * A, bool verbose, bool summary) {
+
+  const Epetra_Comm & comm = A->Comm();
+  const Epetra_BlockMap & rowMap = A->RowMap();
+  const Epetra_BlockMap & colMap = A->ColMap();
+  int numMyElements = rowMap.NumMyElements();
+  int * myGlobalElements = rowMap.MyGlobalElements();
+
+  std::vector<int> ghosts;
+  for (int i=0; i<colMap.NumMyElements(); i++)
+    if (!rowMap.MyGID(colMap.GID(i))) ghosts.push_back(colMap.GID(i));
+  int numGhosts = ghosts.size();
+  const int * ghostIDs = (numGhosts>0) ? &ghosts[0] : 0;
+  std::vector<int> pids(numGhosts+1), lids(numGhosts+1), pids2(numGhosts+1), lids2(numGhosts+1);
+
+  Epetra_Time timer(comm);
+  double times[2], maxTimes[2];
+  comm.Barrier();
+  timer.ResetStartTime();
+  Epetra_Map map(-1, numMyElements, myGlobalElements, 0, comm);
+  map.RemoteIDList(numGhosts, ghostIDs, &pids[0], &lids[0]);
+  times[0] = timer.ElapsedTime();
+
+  comm.Barrier();
+  timer.ResetStartTime();
+  Epetra_IntervalMap<int> intervalMap(numMyElements, myGlobalElements, comm, true);
+  intervalMap.RemoteIDList(numGhosts, ghostIDs, &pids2[0], &lids2[0]);
+  times[1] = timer.ElapsedTime();
+  comm.MaxAll(times, maxTimes, 2);
+
+  double local[3], global[3];
+  local[0] = 36.0*numMyElements;  // estimate, see above
+  local[1] = intervalMap.BytesUsed();
+  local[2] = 0.0;
+  for (int i=0; i<numGhosts; i++)
+    if (pids[i]!=pids2[i] || lids[i]!=lids2[i]) local[2] += 1.0;
+  for (int i=0; i<numMyElements; i++)
+    if (intervalMap.LID(myGlobalElements[i])!=i || intervalMap.GID(i)!=myGlobalElements[i]) local[2] += 1.0;
+  comm.SumAll(local, global, 3);
+
+  if (verbose) {
+    cout << "Map from " << map.NumGlobalElements() << " ids in " << intervalMap.NumGlobalRuns() << " runs:"
+	 << " Epetra_Map " << maxTimes[0] << " s, " << global[0] << " bytes (estimate, 36 per id);"
+	 << " Epetra_IntervalMap " << maxTimes[1] << " s, " << global[1] << " bytes (counted)";
+    if (global[2]>0.0) cout << " (" << global[2] << " lookups DIFFER)";
+    cout << endl;
+  }
+  if (summary) {
+    if (comm.NumProc()==1) cout << "MapBuild" << '\t';
+    cout << maxTimes[0] << endl;
+    if (comm.NumProc()==1) cout << "IntervalMapBuild" << '\t';
+    cout << maxTimes[1] << endl;
+  }
+  return;
+}
+
+#ifdef EPETRA_TPETRABRIDGE_SUPPORTED
+//=========================================================================================
+// Times handing A and x to Tpetra and back by copying every entry and
+// through the shared-storage views of Epetra_TpetraBridge, and checks that
+// the Tpetra product with the shared matrix matches Epetra's and that
+// writes through the views and the shared matrix reach the other library,
+// in both directions (on a copy of A, which is left as it was).  Returns
+// false if the products differ or a write did not reach the other side.
+// Map conversion is done once and not included.
+bool reportTpetraBridge(Epetra_CrsMatrix * A, Epetra_MultiVector * x, bool verbose, bool summary) {
+
+  typedef Epetra_TpetraBridge<> Bridge;
+  const Epetra_Comm & comm = A->Comm();
+  Teuchos::RCP<Epetra_CrsMatrix> Ar = Teuchos::rcp(A, false);
+  Teuchos::RCP<Epetra_MultiVector> xr = Teuchos::rcp(x, false);
+  Teuchos::RCP<const Bridge::map_type> map = Bridge::TpetraMap(x->Map());
+  const int numReps = 10;
+
+  Epetra_Time timer(comm);
+  double times[6], maxTimes[6];
+  Teuchos::RCP<Bridge::multivector_type> xt;
+  Teuchos::RCP<Epetra_MultiVector> xe;
+  Teuchos::RCP<Bridge::crs_matrix_type> At;
+  bool shared = false;
+
+  comm.Barrier();
+  timer.ResetStartTime();
+  for (int i=0; i<numReps; i++) xt = Bridge::TpetraCopy(*x, map);
+  times[0] = timer.ElapsedTime()/numReps;
+  timer.ResetStartTime();
+  for (int i=0; i<numReps; i++) xt = Bridge::TpetraView(xr, map);
+  times[1] = timer.ElapsedTime()/numReps;
+
+  timer.ResetStartTime();
+  for (int i=0; i<numReps; i++) xe = Bridge::EpetraCopy(*xt, x->Map());
+  times[2] = timer.ElapsedTime()/numReps;
+  timer.ResetStartTime();
+  for (int i=0; i<numReps; i++) xe = Bridge::EpetraView(xt, x->Map());
+  times[3] = timer.ElapsedTime()/numReps;
+
+  timer.ResetStartTime();
+  for (int i=0; i<numReps; i++) At = Bridge::TpetraMatrixCopy(*A);
+  times[4] = timer.ElapsedTime()/numReps;
+  timer.ResetStartTime();
+  for (int i=0; i<numReps; i++) At = Bridge::TpetraMatrix(Ar, shared);
+  times[5] = timer.ElapsedTime()/numReps;
+  comm.MaxAll(times, maxTimes, 6);
+
+  // y = A x by Epetra, and by Tpetra into the storage of an Epetra vector
+  Epetra_MultiVector y(A->RangeMap(), x->NumVectors());
+  Teuchos::RCP<Epetra_MultiVector> yt = Teuchos::rcp(new Epetra_MultiVector(y));
+  A->Multiply(false, *x, y);
+  At->apply(*Bridge::TpetraView(xr, map), *Bridge::TpetraView(yt, At->getRangeMap()));
+  yt->Update(-1.0, y, 1.0);
+  std::vector<double> diff(x->NumVectors());
+  yt->NormInf(&diff[0]);
+  double maxDiff = *std::max_element(diff.begin(), diff.end());
+
+  // Writes through the views: scale by 2 on one side, compare with 2x on
+  // the other, then scale back on the other side and compare with x
+  double writeDiff = 0.0;
+  Teuchos::RCP<Epetra_MultiVector> w = Teuchos::rcp(new Epetra_MultiVector(*x));
+  Teuchos::RCP<Bridge::multivector_type> wt = Bridge::TpetraView(w, map);
+  wt->scale(2.0);
+  writeDiff = std::max(writeDiff, maxRelativeDiff(*w, 2.0, *x));
+  w->Scale(0.5);
+  writeDiff = std::max(writeDiff, maxRelativeDiff(*Bridge::EpetraCopy(*wt, x->Map()), 1.0, *x));
+
+  Teuchos::RCP<Bridge::multivector_type> vt = Bridge::TpetraCopy(*x, map);
+  Teuchos::RCP<Epetra_MultiVector> v = Bridge::EpetraView(vt, x->Map());
+  v->Scale(2.0);
+  writeDiff = std::max(writeDiff, maxRelativeDiff(*Bridge::EpetraCopy(*vt, x->Map()), 2.0, *x));
+  vt->scale(0.5);
+  writeDiff = std::max(writeDiff, maxRelativeDiff(*v, 1.0, *x));
+
+  // The same for the values of a shared copy of A: scaled by Epetra it
+  // is applied by Tpetra, and scaled back by Tpetra it is applied by Epetra
+  Teuchos::RCP<Epetra_CrsMatrix> Ac = Teuchos::rcp(new Epetra_CrsMatrix(*A));
+  Ac->OptimizeStorage();
+  bool sharedCopy = false;
+  Teuchos::RCP<Bridge::crs_matrix_type> Act = Bridge::TpetraMatrix(Ac, sharedCopy);
+  if (sharedCopy) {
+    Ac->Scale(2.0);
+    Act->apply(*Bridge::TpetraView(xr, map), *Bridge::TpetraView(yt, Act->getRangeMap()));
+    writeDiff = std::max(writeDiff, maxRelativeDiff(*yt, 2.0, y));
+    Act->resumeFill();
+    Act->scale(0.5);
+    Act->fillComplete(Act->getDomainMap(), Act->getRangeMap());
+    Ac->Multiply(false, *x, *yt);
+    writeDiff = std::max(writeDiff, maxRelativeDiff(*yt, 1.0, y));
+  }
+  std::vector<double> norm(x->NumVectors());
+  y.NormInf(&norm[0]);
+  double scale = std::max(1.0, *std::max_element(norm.begin(), norm.end()));
+  bool passed = maxDiff <= 1.0e-12*scale && writeDiff <= 1.0e-12;
+
+  if (verbose) {
+    cout << "Epetra <-> Tpetra for " << x->NumVectors() << " vectors: to Tpetra copy " << maxTimes[0]
+	 << " s, view " << maxTimes[1] << " s; to Epetra copy " << maxTimes[2] << " s, view " << maxTimes[3]
+	 << " s; CrsMatrix copy " << maxTimes[4] << " s, " << (shared ? "shared " : "not shared (copied) ")
+	 << maxTimes[5] << " s; max |Ax - Ax| " << maxDiff << "; write-through max rel. diff " << writeDiff << endl;
+  }
+  if (comm.MyPID()==0 && (verbose || !passed))
+    cout << "Epetra <-> Tpetra products and write-through: " << (passed ? "PASSED" : "FAILED") << endl;
+  if (summary) {
+    const char * names[6] = {"TpetraMVCopy", "TpetraMVView", "EpetraMVCopy", "EpetraMVView",
+			     "TpetraCrsCopy", "TpetraCrsShare"};
+    for (int i=0; i<6; i++) {
+      if (comm.NumProc()==1) cout << names[i] << '\t';
+      cout << maxTimes[i] << endl;
+    }
+  }
+  return(passed);
+}
+
+//=========================================================================================
+// max over the columns j of ||X(:,j) - alpha Y(:,j)||_inf / ||alpha Y(:,j)||_inf
+double maxRelativeDiff(const Epetra_MultiVector & X, double alpha, const Epetra_MultiVector & Y) {
+
+  Epetra_MultiVector D(X);
+  D.Update(-alpha, Y, 1.0);
+  std::vector<double> diff(X.NumVectors()), norm(X.NumVectors());
+  D.NormInf(&diff[0]);
+  Y.NormInf(&norm[0]);
+  double maxDiff = 0.0;
+  for (int j=0; j<X.NumVectors(); j++) {
+    double scale = std::abs(alpha)*norm[j];
+    maxDiff = std::max(maxDiff, diff[j]/(scale > 0.0 ? scale : 1.0));
+  }
+  return(maxDiff);
+}
+#endif
+
+bool isGridMapping(const char * name) {
+  std::string s(name);
+  return(s=="rank" || s=="cart" || s=="node");
+}
+
+#ifdef EPETRA_MPI
+//=========================================================================================
+// Returns a communicator in which each processor's rank is its position in the
+// numProcsX by numProcsY process grid (myProcX = rank%numProcsX, myProcY = rank/numProcsX,
+// as used by GenerateMyGlobalElements).
+//
+//   rank : the MPI_COMM_WORLD rank is the grid position
+//   cart : MPI_Cart_create with reordering, so the MPI library may place grid
+//          neighbors close together
+//   node : the processors of each node are given a tileX by tileY tile of the grid
+//          (tileX*tileY = processors per node, as square as the grid allows), so
+//          only the tile boundary halo crosses nodes.  Needs the same number of
+//          processors on every node; otherwise tileX = tileY = 0 and the world
+//          order is kept.
+MPI_Comm CreateProcessGrid(const char * gridMapping, int numProcsX, int numProcsY,
+			   int & tileX, int & tileY) {
+
+  std::string mapping(gridMapping);
+  int numProcs, myRank;
+  MPI_Comm_size(MPI_COMM_WORLD, &numProcs);
+  MPI_Comm_rank(MPI_COMM_WORLD, &myRank);
+  tileX = tileY = 0;
+  if (mapping=="rank" || numProcsX*numProcsY!=numProcs) return(MPI_COMM_WORLD);
+
+  MPI_Comm gridComm;
+  if (mapping=="cart") {
+    int dims[2] = {numProcsY, numProcsX}; // row-major: rank = myProcY*numProcsX + myProcX
+    int periods[2] = {0, 0};
+    MPI_Cart_create(MPI_COMM_WORLD, 2, dims, periods, 1, &gridComm);
+    return(gridComm);
+  }
+
+#if defined(MPI_VERSION) && MPI_VERSION >= 3
+  MPI_Comm nodeComm, leaderComm;
+  int nodeRank, nodeSize, nodeIndex = 0;
+  MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, myRank, MPI_INFO_NULL, &nodeComm);
+  MPI_Comm_rank(nodeComm, &nodeRank);
+  MPI_Comm_size(nodeComm, &nodeSize);
+
+  // Number the nodes by their lowest world rank
+  MPI_Comm_split(MPI_COMM_WORLD, (nodeRank==0) ? 0 : MPI_UNDEFINED, myRank, &leaderComm);
+  if (nodeRank==0) {
+    MPI_Comm_rank(leaderComm, &nodeIndex);
+    MPI_Comm_free(&leaderComm);
+  }
+  MPI_Bcast(&nodeIndex, 1, MPI_INT, 0, nodeComm);
+  MPI_Comm_free(&nodeComm);
+
+  int minSize, maxSize;
+  MPI_Allreduce(&nodeSize, &minSize, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+  MPI_Allreduce(&nodeSize, &maxSize, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+  // Most square tile that divides the grid
+  if (minSize==maxSize) {
+    for (int tx=1; tx<=nodeSize; tx++) {
+      if (nodeSize%tx!=0) continue;
+      int ty = nodeSize/tx;
+      if (numProcsX%tx!=0 || numProcsY%ty!=0) continue;
+      if (tileX==0 || tx+ty < tileX+tileY) {
+	tileX = tx;
+	tileY = ty;
+      }
+    }
+  }
+
+  int key = myRank;
+  if (tileX>0) {
+    int tilesX = numProcsX/tileX;
+    int myProcX = (nodeIndex%tilesX)*tileX + nodeRank%tileX;
+    int myProcY = (nodeIndex/tilesX)*tileY + nodeRank/tileX;
+    key = myProcY*numProcsX + myProcX;
+  }
+  MPI_Comm_split(MPI_COMM_WORLD, 0, key, &gridComm);
+  return(gridComm);
+#else
+  return(MPI_COMM_WORLD);
+#endif
+}
+#endif
+//=========================================================================================
+// Times 10 each of Norm2, Dot, Update and Scale with Epetra_ThreadedVectorOps for
+// 1, 2, 4, ... threads up to the maximum (slowest processor, all starting together),
+// and checks the reductions against Epetra.
+void runThreadedVectorTests(Epetra_MultiVector & q, Epetra_MultiVector & z, Epetra_MultiVector & r,
+			    bool verbose, bool summary) {
+
+  int nrhs = q.NumVectors();
+  double n = (double) q.GlobalLength() * nrhs;
+  Epetra_SerialDenseVector resvec(nrhs), refvec(nrhs);
+  Epetra_Time timer(q.Comm());
+  q.Random();
+  z.Random();
+
+  // Flops per entry, as counted by Epetra: Norm2 and Dot 2, Update 3, Scale 1
+  const char * names[4] = {"Norm2", "Dot", "Update", "Scale"};
+  double flopsPerEntry[4] = {2.0, 2.0, 3.0, 1.0};
+
+  int maxThreads = Epetra_ThreadedVectorOps::MaxThreads();
+  for (int numThreads=1; numThreads<=maxThreads; numThreads*=2) {
+    for (int op=0; op<4; op++) {
+      q.Comm().Barrier();
+      timer.ResetStartTime();
+      for( int i = 0; i < 10; ++i ) {
+	if (op==0) Epetra_ThreadedVectorOps::Norm2(q, resvec.Values(), numThreads);
+	if (op==1) Epetra_ThreadedVectorOps::Dot(q, z, resvec.Values(), numThreads);
+	if (op==2) Epetra_ThreadedVectorOps::Update(1.0, z, 1.0, r, 0.0, q, numThreads);
+	if (op==3) Epetra_ThreadedVectorOps::Scale(1.0, q, numThreads);
+      }
+      double elapsed_time = timer.ElapsedTime();
+      double max_time;
+      q.Comm().MaxAll(&elapsed_time, &max_time, 1);
+      double MFLOPs = 10.0*flopsPerEntry[op]*n/max_time/1000000.0;
+
+      // The Epetra reference reductions are collective, so every processor
+      // computes them whether or not it prints
+      double maxDiff = 0.0;
+      if (op<2) {
+	if (op==0) q.Norm2(refvec.Values());
+	else q.Dot(z, refvec.Values());
+	for (int v=0; v<nrhs; v++) maxDiff = EPETRA_MAX(maxDiff, std::abs(resvec[v]-refvec[v])/std::abs(refvec[v]));
+      }
+
+      if (verbose) {
+	cout << "Total MFLOPs for 10 threaded " << names[op] << "'s (" << numThreads << " threads) = " << MFLOPs;
+	if (op<2) cout << " (relative difference from Epetra " << maxDiff << ")";
+	cout << endl;
+      }
+      if (summary) {
+	if (q.Comm().NumProc()==1) cout << names[op] << "Thr" << numThreads << '\t';
+	cout << MFLOPs << endl;
+      }
+    }
+  }
+  return;
+}
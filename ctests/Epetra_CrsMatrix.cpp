@@ -53,6 +53,7 @@
 #endif
 #include "epetra_test_err.h"
 #include "Epetra_Version.h"
+#include "Epetra_SharedGraphMatrices.hpp"
 
 // prototypes
 
@@ -68,6 +69,8 @@ int power_method(bool TransA, Epetra_CrsMatrix& A,
 
 int check_graph_sharing(Epetra_Comm& Comm);
 
+int check_shared_graph_apply(Epetra_Comm& Comm, bool verbose);
+
 int main(int argc, char *argv[])
 {
   int ierr = 0, forierr = 0;
@@ -224,6 +227,8 @@ int main(int argc, char *argv[])
 
   EPETRA_TEST_ERR(check_graph_sharing(Comm),ierr);
 
+  EPETRA_TEST_ERR(check_shared_graph_apply(Comm, verbose),ierr);
+
   // Create vectors for Power method
 
   Epetra_Vector q(Map);
@@ -1104,3 +1109,70 @@ int check_graph_sharing(Epetra_Comm& Comm)
   return(0);
 }
 
+// Builds a "mass" and a "stiffness" matrix on one tridiagonal graph and checks that
+// the fused apply and the value-only combination of Epetra_SharedGraphMatrices match
+// a*M*x + b*K*x computed with two Multiply() calls.
+int check_shared_graph_apply(Epetra_Comm& Comm, bool verbose)
+{
+  int numLocalElems = 100;
+  Epetra_Map map(-1, numLocalElems, 0, Comm);
+  int numGlobalElems = map.NumGlobalElements();
+
+  Epetra_CrsGraph graph(Copy, map, 3);
+  for (int i=0; i<numLocalElems; ++i) {
+    int row = map.GID(i);
+    int cols[3] = {row-1, row, row+1};
+    int first = (row==0) ? 1 : 0;
+    int last = (row==numGlobalElems-1) ? 2 : 3;
+    graph.InsertGlobalIndices(row, last-first, cols+first);
+  }
+  graph.FillComplete();
+
+  Epetra_CrsMatrix M(Copy, graph), K(Copy, graph);
+  for (int i=0; i<numLocalElems; ++i) {
+    int numEntries;
+    int * inds;
+    graph.ExtractMyRowView(i, numEntries, inds);
+    for (int j=0; j<numEntries; ++j) {
+      bool diag = (graph.ColMap().GID(inds[j])==map.GID(i));
+      double valM = diag ? 4.0 : 1.0;
+      double valK = diag ? 2.0 : -1.0;
+      M.ReplaceMyValues(i, 1, &valM, &inds[j]);
+      K.ReplaceMyValues(i, 1, &valK, &inds[j]);
+    }
+  }
+  M.FillComplete();
+  K.FillComplete();
+
+  Epetra_SharedGraphMatrices family(graph);
+  if (family.AddMatrix(M) != 0) return(-1);
+  if (family.AddMatrix(K) != 1) return(-2);
+
+  double coeffs[2] = {0.5, 0.25};
+  Epetra_Vector x(map), y(map), z(map), tmp(map);
+  x.Random();
+
+  M.Multiply(false, x, y);
+  K.Multiply(false, x, tmp);
+  y.Update(coeffs[1], tmp, coeffs[0]);
+
+  family.Apply(coeffs, x, z);
+  z.Update(-1.0, y, 1.0);
+  double diffApply;
+  z.NormInf(&diffApply);
+
+  Epetra_CrsMatrix C(Copy, graph);
+  C.FillComplete();
+  if (family.Combine(coeffs, C) != 0) return(-3);
+  C.Multiply(false, x, z);
+  z.Update(-1.0, y, 1.0);
+  double diffCombine;
+  z.NormInf(&diffCombine);
+
+  if (verbose)
+    cout << "Shared graph apply:   |fused - two Multiply| = " << diffApply
+         << ", |combined - two Multiply| = " << diffCombine << endl;
+
+  if (diffApply > 1.0e-12 || diffCombine > 1.0e-12) return(-4);
+  return(0);
+}
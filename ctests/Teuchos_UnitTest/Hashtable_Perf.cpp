@@ -0,0 +1,197 @@
+/*
+// @HEADER
+// ***********************************************************************
+//
+//                    Teuchos: Common Tools Package
+//                 Copyright (2004) Sandia Corporation
+//
+// Under terms of Contract DE-AC04-94AL85000, there is a non-exclusive
+// license for use of this work by or on behalf of the U.S. Government.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact Michael A. Heroux (maherou@sandia.gov)
+//
+// ***********************************************************************
+// @HEADER
+*/
+
+// Insert and lookup throughput of Teuchos::Hashtable, std::unordered_map and
+// FlatHashtable for integer keys.
+//
+//   Hashtable_Perf --num-keys=1000000 [--no-teuchos] [--key-bits=64]
+//
+// Keys are scattered (i times a large odd constant).  Lookups visit keys 0..2n-1
+// in a scrambled order, so half of them are absent and the access order has
+// nothing to do with the insertion order.  Teuchos::Hashtable becomes very slow beyond a few
+// million keys; use --no-teuchos for the 10^7 and 10^8 runs.
+//
+// Every FlatHashtable lookup (before and after freeze) is checked against
+// Teuchos::Hashtable, or with --no-teuchos against the inserted keys; the test
+// passes only if all of them match.
+
+#include "Teuchos_CommandLineProcessor.hpp"
+#include "Teuchos_Time.hpp"
+#include "Teuchos_Hashtable.hpp"
+#include "FlatHashtable.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#if __cplusplus >= 201103L
+#include <unordered_map>
+#endif
+
+
+template<class Key>
+Key makeKey(long long i) {return((Key)(i*0x9E3779B1LL));}
+
+// Position i of a scrambled visit of 0..m-1 (stride coprime to m)
+long long lookupIndex(long long i, long long m) {return((i*1000003LL) % m);}
+
+void report(const std::string & name, int numKeys, double insertTime, double lookupTime, long long found)
+{
+  std::cout << std::setw(22) << std::left << name
+            << " insert " << std::setw(10) << numKeys/insertTime/1.0e6 << " Mkeys/s"
+            << "   lookup " << std::setw(10) << 2.0*numKeys/lookupTime/1.0e6 << " Mkeys/s"
+            << "   (found " << found << ")" << std::endl;
+}
+
+// Compare the lookups of keys 0..2n-1 in table with reference (or, if reference
+// is 0, with the inserted keys: key i is present with value i for i < n)
+template<class Key>
+bool sameLookups(const FlatHashtable<Key,int> & table, const Teuchos::Hashtable<Key,int> * reference,
+                 int numKeys)
+{
+  for (long long i=0; i<2LL*numKeys; i++) {
+    Key key = makeKey<Key>(i);
+    const int * value = table.find(key);
+    bool present = (reference != 0) ? reference->containsKey(key) : (i < numKeys);
+    if ((value != 0) != present) return(false);
+    if (present && *value != ((reference != 0) ? reference->get(key) : (int)i)) return(false);
+  }
+  return(true);
+}
+
+template<class Key>
+bool runBenchmarks(int numKeys, bool runTeuchos)
+{
+  Teuchos::Time timer("hashtable");
+  long long found;
+  bool match = true;
+
+  Teuchos::Hashtable<Key,int> teuchosTable;
+  if (runTeuchos) {
+    Teuchos::Hashtable<Key,int> & table = teuchosTable;
+    timer.start(true);
+    for (int i=0; i<numKeys; i++) table.put(makeKey<Key>(i), i);
+    double insertTime = timer.stop();
+    found = 0;
+    timer.start(true);
+    for (int i=0; i<2*numKeys; i++) {
+      Key key = makeKey<Key>(lookupIndex(i, 2LL*numKeys));
+      if (table.containsKey(key)) found += table.get(key);
+    }
+    report("Teuchos::Hashtable", numKeys, insertTime, timer.stop(), found);
+  }
+
+#if __cplusplus >= 201103L
+  {
+    std::unordered_map<Key,int> table;
+    table.reserve(numKeys);
+    timer.start(true);
+    for (int i=0; i<numKeys; i++) table[makeKey<Key>(i)] = i;
+    double insertTime = timer.stop();
+    found = 0;
+    timer.start(true);
+    for (int i=0; i<2*numKeys; i++) {
+      typename std::unordered_map<Key,int>::const_iterator it = table.find(makeKey<Key>(lookupIndex(i, 2LL*numKeys)));
+      if (it != table.end()) found += it->second;
+    }
+    report("std::unordered_map", numKeys, insertTime, timer.stop(), found);
+  }
+#endif
+
+  {
+    FlatHashtable<Key,int> table(numKeys);
+    timer.start(true);
+    for (int i=0; i<numKeys; i++) table.put(makeKey<Key>(i), i);
+    double insertTime = timer.stop();
+    found = 0;
+    timer.start(true);
+    for (int i=0; i<2*numKeys; i++) {
+      const int * value = table.find(makeKey<Key>(lookupIndex(i, 2LL*numKeys)));
+      if (value != 0) found += *value;
+    }
+    report("FlatHashtable", numKeys, insertTime, timer.stop(), found);
+    match = match && sameLookups(table, runTeuchos ? &teuchosTable : 0, numKeys);
+
+    // Insert rate below includes the freeze
+    timer.start(true);
+    table.freeze();
+    insertTime += timer.stop();
+    found = 0;
+    timer.start(true);
+    for (int i=0; i<2*numKeys; i++) {
+      const int * value = table.find(makeKey<Key>(lookupIndex(i, 2LL*numKeys)));
+      if (value != 0) found += *value;
+    }
+    report("FlatHashtable frozen", numKeys, insertTime, timer.stop(), found);
+    match = match && sameLookups(table, runTeuchos ? &teuchosTable : 0, numKeys);
+  }
+
+  std::cout << "FlatHashtable lookups vs " << (runTeuchos ? "Teuchos::Hashtable" : "inserted keys")
+            << ": " << (match ? "match" : "MISMATCH") << std::endl;
+  return(match);
+}
+
+
+int main(int argc, char *argv[])
+{
+  int numKeys = 1000000;
+  bool runTeuchos = true;
+  int keyBits = 32;
+
+  Teuchos::CommandLineProcessor clp;
+  clp.setOption("num-keys", &numKeys, "number of keys to insert");
+  clp.setOption("teuchos", "no-teuchos", &runTeuchos, "also time Teuchos::Hashtable");
+  clp.setOption("key-bits", &keyBits, "32 (int keys) or 64 (long long keys)");
+  if (clp.parse(argc, argv) != Teuchos::CommandLineProcessor::PARSE_SUCCESSFUL) return(1);
+
+  std::cout << "Keys: " << numKeys << " (" << keyBits << " bit)" << std::endl;
+  bool match;
+  if (keyBits == 64) match = runBenchmarks<long long>(numKeys, runTeuchos);
+  else match = runBenchmarks<int>(numKeys, runTeuchos);
+
+  if (!match) {
+    std::cout << "End Result: TEST FAILED" << std::endl;
+    return(1);
+  }
+  std::cout << "End Result: TEST PASSED" << std::endl;
+  return(0);
+}
@@ -44,6 +44,11 @@
 #include "Teuchos_UnitTestHarness.hpp"
 #include "Teuchos_as.hpp"
 #include "Teuchos_Hashtable.hpp"
+#include "FlatHashtable.hpp"
+
+#include <map>
+#include <vector>
+#include <algorithm>
 
 
 namespace {
@@ -67,13 +72,109 @@ TEUCHOS_UNIT_TEST_TEMPLATE_2_DECL( Hashtable, test0, Key, Value )
   TEST_EQUALITY( hashtable.get(as<Key>(5)), as<Value>(7) );
 }
 
+
+TEUCHOS_UNIT_TEST_TEMPLATE_2_DECL( FlatHashtable, test0, Key, Value )
+{
+  using Teuchos::as;
+
+  FlatHashtable<Key,Value> hashtable;
+
+  hashtable.put(as<Key>(1), as<Value>(1));
+  hashtable.put(as<Key>(3), as<Value>(9));
+  hashtable.put(as<Key>(5), as<Value>(7));
+
+  TEST_EQUALITY( hashtable.size(), 3 );
+
+  TEST_EQUALITY( hashtable.containsKey(as<Key>(3)), true );
+  TEST_EQUALITY( hashtable.containsKey(as<Key>(4)), false );
+
+  TEST_EQUALITY( hashtable.get(as<Key>(5)), as<Value>(7) );
+  TEST_THROW( hashtable.get(as<Key>(4)), std::runtime_error );
+}
+
+
+TEUCHOS_UNIT_TEST( FlatHashtable, putRemoveGrow )
+{
+  // Random puts and removes against std::map, through several rehashes
+  FlatHashtable<int,int> hashtable(4);
+  std::map<int,int> reference;
+  unsigned int seed = 12345;
+  for (int i=0; i<200000; i++) {
+    seed = seed*1103515245u + 12345u;
+    int key = (seed >> 8) % 3000;
+    if (i%3 == 0 && reference.count(key)) {
+      hashtable.remove(key);
+      reference.erase(key);
+    }
+    else {
+      hashtable.put(key, i);
+      reference[key] = i;
+    }
+  }
+
+  TEST_EQUALITY( hashtable.size(), Teuchos::as<int>(reference.size()) );
+  int numWrong = 0;
+  for (int key=0; key<3000; key++) {
+    const int * value = hashtable.find(key);
+    if ((value != 0) != (reference.count(key) > 0)) numWrong++;
+    else if (value != 0 && *value != reference[key]) numWrong++;
+  }
+  TEST_EQUALITY( numWrong, 0 );
+}
+
+
+TEUCHOS_UNIT_TEST( FlatHashtable, tupleKeyDedup )
+{
+  // Number the edges of two triangles sharing edge (1,2)
+  long long tris[2][3] = {{0, 1, 2}, {1, 3, 2}};
+  FlatHashtable<FlatHashTuple<2>,int> edges;
+  for (int t=0; t<2; t++) {
+    for (int i=0; i<3; i++) {
+      FlatHashTuple<2> edge;
+      edge.id[0] = std::min(tris[t][i], tris[t][(i+1)%3]);
+      edge.id[1] = std::max(tris[t][i], tris[t][(i+1)%3]);
+      bool inserted;
+      edges.getOrInsert(edge, edges.size(), inserted);
+    }
+  }
+  TEST_EQUALITY( edges.size(), 5 );
+
+  FlatHashtable<std::pair<int,int>,double> pairs;
+  pairs.put(std::make_pair(2,3), 1.5);
+  TEST_EQUALITY( pairs.get(std::make_pair(2,3)), 1.5 );
+  TEST_EQUALITY( pairs.containsKey(std::make_pair(3,2)), false );
+}
+
+
+TEUCHOS_UNIT_TEST( FlatHashtable, buildFreeze )
+{
+  std::vector<long long> keys(1000);
+  std::vector<int> values(1000);
+  for (int i=0; i<1000; i++) {
+    keys[i] = 1000000007LL*i;
+    values[i] = i;
+  }
+
+  FlatHashtable<long long,int> hashtable;
+  hashtable.build(1000, &keys[0], &values[0]);
+  hashtable.freeze();
+
+  TEST_EQUALITY( hashtable.isFrozen(), true );
+  TEST_EQUALITY( hashtable.size(), 1000 );
+  TEST_COMPARE( 2*hashtable.size(), <=, hashtable.capacity() );
+  TEST_EQUALITY( hashtable.get(keys[999]), 999 );
+  TEST_THROW( hashtable.put(1LL, 1), std::logic_error );
+  TEST_THROW( hashtable.remove(keys[0]), std::logic_error );
+}
+
 //
 // Instantiations
 //
 
 
 #define UNIT_TEST_GROUP( K, V ) \
-  TEUCHOS_UNIT_TEST_TEMPLATE_2_INSTANT( Hashtable, test0, K, V )
+  TEUCHOS_UNIT_TEST_TEMPLATE_2_INSTANT( Hashtable, test0, K, V ) \
+  TEUCHOS_UNIT_TEST_TEMPLATE_2_INSTANT( FlatHashtable, test0, K, V )
 
 UNIT_TEST_GROUP(int, int)
 UNIT_TEST_GROUP(int, float)